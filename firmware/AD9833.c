@@ -8,16 +8,12 @@
 ///
 //////////////////////////////////////////////////////////////////////////////
 
-#ifdef __cplusplus
-extern "C"
-{
-#endif
-
 #include <stdint.h>
 #include <avr/io.h>
-#include "ad9833.h"
+#include "AD9833.h"
 #include "softspi.h"
-  
+#include "ddsbus.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -46,39 +42,494 @@ extern "C" {
 #define CNTL_OPBITEN  (1 << 5)
 #define CNTL_DIV2     (1 << 3)
 #define CNTL_MODE     (1 << 1)
-        
 
-static uint16_t controlReg;
-        static uint32_t frequency_0;
-        static uint32_t frequency_1;
-        static uint16_t phase_0;
-        static uint16_t phase_1;
+// How B28 and HLB route the next frequency word
+#define CNTL_LOAD     (CNTL_B28 | CNTL_HLB)
+#define CNTL_WAVE     (CNTL_OPBITEN | CNTL_DIV2 | CNTL_MODE)
+#define CNTL_SLEEP    (CNTL_SLEEP1 | CNTL_SLEEP12)
+
+#define ADDR_FREQ0    0x4000
+#define ADDR_FREQ1    0x8000
+#define ADDR_PHASE0   0xc000
+#define ADDR_PHASE1   0xe000
+
+#define HALF_MASK     0x3fff
+#define PHASE_MASK    0x0fff
+
+// Words staged for the next AD9833_update().  Each run of words for the
+// same chips goes out as one FSYNC transaction.
+#define PENDING_SIZE  8
+
+typedef struct AD9833_CHIP
+{
+        uint16_t controlReg;      // wanted control bits, B28/HLB ignored
+        uint16_t chipControl;     // last control word staged or sent
+        uint32_t frequency[2];    // what the chip holds, staged or sent
+        uint16_t phase[2];
+        uint8_t  control_stale;   // chip's control word unknown
+} chip_t;
+
+// Words one setter needs sent to one chip
+typedef struct AD9833_WORDS
+{
+        uint8_t  n;
+        uint16_t wd[3];
+} words_t;
+
+static chip_t   chip[AD9833_CHANNELS];
+
+static uint16_t pending[PENDING_SIZE];
+static uint8_t  n_pending;
+static uint8_t  pending_chips;
+static uint8_t  sent_early;      // staged words went out before a take
+
+// Chips that need the same words, collected by group_add()
+static words_t  group;
+static uint8_t  group_chips;
+
+static void send(uint8_t chips, const uint16_t* wds, uint8_t n)
+{
+#if AD9833_HWSPI
+        DDSBUS_write(chips, wds, n);
+#else
+        for (uint8_t c = 0; c < AD9833_CHANNELS; c++)
+        {
+                if (chips & AD9833_CH(c))
+                {
+                        for (uint8_t i = 0; i < n; i++)
+                        {
+                                SOFTSPI_write(c, wds[i]);
+                        }
+                }
+        }
+#endif
+}
+
+static void flush(void)
+{
+        if (n_pending)
+        {
+                send(pending_chips, pending, n_pending);
+                n_pending = 0;
+        }
+}
+
+static void stage(uint8_t chips, uint16_t wd)
+{
+        if (n_pending == PENDING_SIZE
+            || (n_pending && chips != pending_chips))
+        {
+                flush();
+                sent_early = 1;
+        }
+        pending_chips = chips;
+        pending[n_pending++] = wd;
+}
+
+static void group_end(void)
+{
+        for (uint8_t i = 0; i < group.n; i++)
+        {
+                stage(group_chips, group.wd[i]);
+        }
+        group_chips = 0;
+}
+
+// Adds chip c, which needs words w, to the group; a chip needing other
+// words ends the group and starts the next
+static void group_add(uint8_t c, const words_t* w)
+{
+        uint8_t same = group.n == w->n;
+        for (uint8_t i = 0; same && i < w->n; i++)
+        {
+                same = group.wd[i] == w->wd[i];
+        }
+        if (group_chips && !same)
+        {
+                group_end();
+        }
+        group = *w;
+        group_chips |= AD9833_CH(c);
+}
+
+// Adds a control word only if the chip is not already in this load mode.
+// FSEL and the rest keep the value the chip has; they change in update.
+static void set_load_mode(chip_t* p, uint16_t load, words_t* w)
+{
+        if ((p->chipControl & CNTL_LOAD) != load)
+        {
+                p->chipControl = (p->chipControl & ~CNTL_LOAD) | load;
+                w->wd[w->n++] = p->chipControl;
+                p->control_stale = 0;
+        }
+}
 
 //////////////////////////////////////////////////////////////////////////////
 /// @function AD9833_init
-/// @brief   Initializes AD9833 
-/// @return
+/// @brief   Initializes AD9833
+/// @return  0
 /////////////////////////////////////////////////////////////////////////////
 int AD9833_init()
 {
-        controlReg = CNTL_B28 | CNTL_RESET;
-        AD9833_write_word(controlReg);
-        
-  
-
+#if AD9833_HWSPI
+        DDSBUS_init(AD9833_ALL);
+#else
+        for (uint8_t c = 0; c < AD9833_CHANNELS; c++)
+        {
+                SOFTSPI_set_interface(c, GPIO_PIN_C5 - c, 16,
+                                      SPI_MODE_2_MSB_FIRST, 0);
+        }
+        DDRB |= 0x08;  // b3 output
+#endif
+        n_pending = 0;
+        sent_early = 0;
+        group_chips = 0;
+        for (uint8_t c = 0; c < AD9833_CHANNELS; c++)
+        {
+                chip_t* p = &chip[c];
+                p->control_stale = 0;
+                p->controlReg = CNTL_RESET;
+                p->chipControl = CNTL_B28 | CNTL_RESET;
+                p->frequency[0] = 0;
+                p->frequency[1] = 0;
+                p->phase[0] = 0;
+                p->phase[1] = 0;
+        }
+        stage(AD9833_ALL, CNTL_B28 | CNTL_RESET);
+        stage(AD9833_ALL, ADDR_FREQ0);
+        stage(AD9833_ALL, ADDR_FREQ0);
+        stage(AD9833_ALL, ADDR_FREQ1);
+        stage(AD9833_ALL, ADDR_FREQ1);
+        stage(AD9833_ALL, ADDR_PHASE0);
+        stage(AD9833_ALL, ADDR_PHASE1);
+        flush();
+        sent_early = 0;
+        return 0;
+}
 
 ////////////////////////////////////////////////////////////////////////////
 /// @fn AD9833_write_word
-/// @brief Write a raw 16 bit word to the chip.
+/// @brief Write a raw 16 bit word to the chips.
 /// @param[in] wd  The word to write.
 ////////////////////////////////////////////////////////////////////////////
-void AD9833_write_word(uint16_t wd)
+void AD9833_write_word(uint8_t chips, uint16_t wd)
 {
-        // TODO
+        send(chips, &wd, 1);
+}
+
+static void frequency_words(chip_t* p, int which, uint32_t freq, words_t* w)
+{
+        uint32_t* shadow = &p->frequency[which ? 1 : 0];
+        uint16_t addr = which ? ADDR_FREQ1 : ADDR_FREQ0;
+        uint32_t changed = freq ^ *shadow;
+
+        w->n = 0;
+        if (changed == 0)
+        {
+                return;
+        }
+        *shadow = freq;
+        if ((changed >> 14) == 0)
+        {
+                set_load_mode(p, 0, w);
+                w->wd[w->n++] = addr | (uint16_t)(freq & HALF_MASK);
+        }
+        else if ((changed & HALF_MASK) == 0)
+        {
+                set_load_mode(p, CNTL_HLB, w);
+                w->wd[w->n++] = addr | (uint16_t)(freq >> 14);
+        }
+        else
+        {
+                set_load_mode(p, CNTL_B28, w);
+                w->wd[w->n++] = addr | (uint16_t)(freq & HALF_MASK);
+                w->wd[w->n++] = addr | (uint16_t)(freq >> 14);
+        }
+}
+
+void AD9833_set_frequency(uint8_t chips, int which, uint32_t freq)
+{
+        words_t w;
+        freq &= 0x0fffffffUL;
+        for (uint8_t c = 0; c < AD9833_CHANNELS; c++)
+        {
+                if (chips & AD9833_CH(c))
+                {
+                        frequency_words(&chip[c], which, freq, &w);
+                        group_add(c, &w);
+                }
+        }
+        group_end();
+}
+
+void AD9833_set_phase(uint8_t chips, int which, uint32_t phase)
+{
+        words_t w;
+        uint16_t ph = (uint16_t)phase & PHASE_MASK;
+        for (uint8_t c = 0; c < AD9833_CHANNELS; c++)
+        {
+                if (chips & AD9833_CH(c))
+                {
+                        uint16_t* shadow = &chip[c].phase[which ? 1 : 0];
+                        w.n = 0;
+                        if (ph != *shadow)
+                        {
+                                *shadow = ph;
+                                w.wd[w.n++] = (which ? ADDR_PHASE1
+                                               : ADDR_PHASE0) | ph;
+                        }
+                        group_add(c, &w);
+                }
+        }
+        group_end();
+}
+
+// Sets bits in, and clears bits out, of the chips' wanted control words
+static void set_control(uint8_t chips, uint16_t bits, uint16_t in)
+{
+        for (uint8_t c = 0; c < AD9833_CHANNELS; c++)
+        {
+                if (chips & AD9833_CH(c))
+                {
+                        chip[c].controlReg = (chip[c].controlReg & ~bits) | in;
+                }
+        }
+}
+
+void AD9833_select_freq(uint8_t chips, int which)
+{
+        set_control(chips, CNTL_FS, which ? CNTL_FS : 0);
+}
+
+void AD9833_select_phase(uint8_t chips, int which)
+{
+        set_control(chips, CNTL_PS, which ? CNTL_PS : 0);
+}
+
+void AD9833_reset(uint8_t chips, int res)
+{
+        set_control(chips, CNTL_RESET, res ? CNTL_RESET : 0);
+}
+
+void AD9833_sleep(uint8_t chips, int sleepMode)
+{
+        uint16_t in = 0;
+        if (sleepMode & AD9833_SLEEP_BIT_DAC)
+        {
+                in |= CNTL_SLEEP12;
+        }
+        if (sleepMode & AD9833_SLEEP_BIT_MCLK)
+        {
+                in |= CNTL_SLEEP1;
+        }
+        set_control(chips, CNTL_SLEEP, in);
+}
+
+void AD9833_set_wave_mode(uint8_t chips, AD9833_WaveMode_t md)
+{
+        uint16_t in = 0;
+        switch (md)
+        {
+        case AD9833_RAMP_MODE:
+                in = CNTL_MODE;
+                break;
+        case AD9833_SQR_FULL:
+                in = CNTL_OPBITEN | CNTL_DIV2;
+                break;
+        case AD9833_SQR_HALF:
+                in = CNTL_OPBITEN;
+                break;
+        default:
+                break;
+        }
+        set_control(chips, CNTL_WAVE, in);
+}
+
+void AD9833_run_mode(uint8_t chips, AD9833_SleepMode_t md)
+{
+        switch (md)
+        {
+        case AD9833_SLEEP_STOP:
+                AD9833_sleep(chips, AD9833_SLEEP_BIT_MCLK);
+                break;
+        case AD9833_SLEEP_DAC_OFF:
+                AD9833_sleep(chips, AD9833_SLEEP_BIT_DAC);
+                break;
+        case AD9833_SLEEP_STOP_DAC_OFF:
+                AD9833_sleep(chips, AD9833_SLEEP_BIT_MCLK
+                             | AD9833_SLEEP_BIT_DAC);
+                break;
+        default:
+                AD9833_sleep(chips, 0);
+                break;
+        }
+}
+
+uint32_t AD9833_get_frequency(uint8_t ch, int which)
+{
+        return chip[ch].frequency[which ? 1 : 0];
+}
+
+int AD9833_get_selected_freq(uint8_t ch)
+{
+        return (chip[ch].controlReg & CNTL_FS) ? 1 : 0;
+}
+
+// The control word chip p should get, keeping its load mode
+static uint16_t wanted(const chip_t* p)
+{
+        return (p->controlReg & ~CNTL_LOAD) | (p->chipControl & CNTL_LOAD);
+}
+
+uint16_t AD9833_select_word(uint8_t ch, int freq, int phase)
+{
+        uint16_t wd = chip[ch].chipControl & ~(CNTL_FS | CNTL_PS);
+        if (freq)
+        {
+                wd |= CNTL_FS;
+        }
+        if (phase)
+        {
+                wd |= CNTL_PS;
+        }
+        return wd;
+}
+
+uint16_t AD9833_gate_word(uint8_t ch, int res, int sleepMode)
+{
+        uint16_t wd = chip[ch].chipControl & ~(CNTL_RESET | CNTL_SLEEP);
+        if (res)
+        {
+                wd |= CNTL_RESET;
+        }
+        if (sleepMode & AD9833_SLEEP_BIT_DAC)
+        {
+                wd |= CNTL_SLEEP12;
+        }
+        if (sleepMode & AD9833_SLEEP_BIT_MCLK)
+        {
+                wd |= CNTL_SLEEP1;
+        }
+        return wd;
+}
+
+uint8_t AD9833_stream_freq(uint8_t chips, int which, uint32_t lo,
+                           uint32_t hi, uint16_t* addr)
+{
+        uint16_t load = (lo >> 14) == (hi >> 14) ? 0 : CNTL_B28;
+        for (uint8_t c = 0; c < AD9833_CHANNELS; c++)
+        {
+                if (chips & AD9833_CH(c))
+                {
+                        chip_t* p = &chip[c];
+                        p->chipControl = (p->chipControl & ~CNTL_LOAD) | load;
+                        p->control_stale = 1;
+                        p->frequency[which ? 1 : 0] = 0xffffffffUL;
+                }
+        }
+        *addr = which ? ADDR_FREQ1 : ADDR_FREQ0;
+        return load ? 2 : 1;
+}
+
+// Stages the control words that differ from what the chips hold.  Chips
+// leaving RESET together first get one shared word, so their phase
+// accumulators start on the same clock edge even if their own control
+// words differ.
+static void stage_control(uint8_t chips)
+{
+        words_t w;
+        uint8_t leaving = 0;
+        uint8_t first = 0;
+        for (uint8_t c = AD9833_CHANNELS; c-- > 0; )
+        {
+                chip_t* p = &chip[c];
+                if ((chips & AD9833_CH(c)) && (p->chipControl & CNTL_RESET)
+                    && !(p->controlReg & CNTL_RESET))
+                {
+                        leaving |= AD9833_CH(c);
+                        first = c;
+                }
+        }
+        if (leaving & (leaving - 1))
+        {
+                uint16_t wd = wanted(&chip[first]);
+                for (uint8_t c = 0; c < AD9833_CHANNELS; c++)
+                {
+                        if (leaving & AD9833_CH(c))
+                        {
+                                chip[c].chipControl = wd;
+                                chip[c].control_stale = 0;
+                        }
+                }
+                stage(leaving, wd);
+        }
+        for (uint8_t c = 0; c < AD9833_CHANNELS; c++)
+        {
+                if (chips & AD9833_CH(c))
+                {
+                        chip_t* p = &chip[c];
+                        uint16_t wd = wanted(p);
+                        w.n = 0;
+                        if (wd != p->chipControl || p->control_stale)
+                        {
+                                p->chipControl = wd;
+                                p->control_stale = 0;
+                                w.wd[w.n++] = wd;
+                        }
+                        group_add(c, &w);
+                }
+        }
+        group_end();
+}
+
+void AD9833_update(uint8_t chips)
+{
+        stage_control(chips);
+        flush();
+        sent_early = 0;
+}
+
+uint8_t AD9833_take(uint8_t chips, uint16_t* wds, uint8_t max, uint8_t* to)
+{
+        uint8_t n;
+        stage_control(chips);
+        if (sent_early || n_pending > max)
+        {
+                flush();
+                sent_early = 0;
+                return 0;
+        }
+        n = n_pending;
+        for (uint8_t i = 0; i < n; i++)
+        {
+                wds[i] = pending[i];
+        }
+        *to = pending_chips;
+        n_pending = 0;
+        return n;
+}
+
+void AD9833_invalidate(uint8_t chips)
+{
+        // B28 and HLB together is a load mode never chosen, and the
+        // frequency and phase values are ones no register can hold, so
+        // every setter writes in full
+        for (uint8_t c = 0; c < AD9833_CHANNELS; c++)
+        {
+                if (chips & AD9833_CH(c))
+                {
+                        chip_t* p = &chip[c];
+                        p->chipControl = p->controlReg | CNTL_LOAD;
+                        p->control_stale = 1;
+                        p->frequency[0] = 0xffffffffUL;
+                        p->frequency[1] = 0xffffffffUL;
+                        p->phase[0] = 0xffff;
+                        p->phase[1] = 0xffff;
+                }
+        }
 }
 
 
 #ifdef __cplusplus
 }
 #endif  // __cplusplus
-
@@ -6,6 +6,20 @@
 ///
 ///  @brief Control Analog Devices AD9833 DDS chip.
 ///
+///  All chip traffic goes through this driver.  It keeps a shadow copy of
+///  every register and only sends what changed: nothing for an unchanged
+///  value, a single 14 bit HLB write when only the LSB or MSB half of a
+///  frequency register moved.  Setters stage words; AD9833_update() sends
+///  everything staged as one SPI transaction.
+///
+///  Up to four chips share SCLK, SDATA and MCLK, each with its own FSYNC.
+///  Setters take a mask of chips, AD9833_CH(n) or AD9833_ALL, and keep a
+///  shadow per chip.  Chips that need the same words get them in one
+///  transaction with all their FSYNCs low, so they change on the same
+///  clock edge.  When AD9833_update() takes more than one chip out of
+///  RESET it does it with one shared control word, which starts their
+///  phase accumulators together.
+///
 //////////////////////////////////////////////////////////////////////////////
 
 #ifndef AD9833_H
@@ -17,16 +31,33 @@ extern "C"
 #endif
 
 #include <stdint.h>
-        
+
 #include "device_config.h"
 #include "gpio.h"
 #include "softspi.h"
 
-#define SOFTSPI_VERSION_MAJOR     0
-#define SOFTSPI_VERSION_MINOR     1
-#define SOFTSPI_VERSION_BUILD     0
-#define SOFTSPI_VERSION_DATE      (20230623L)
+#define AD9833_VERSION_MAJOR      0
+#define AD9833_VERSION_MINOR      3
+#define AD9833_VERSION_BUILD      0
+#define AD9833_VERSION_DATE       (20230712L)
 
+// 1: hardware SPI through ddsbus.c, 0: SOFTSPI interface n for chip n,
+// one at a time, so chips change a few microseconds apart
+#ifndef AD9833_HWSPI
+#define AD9833_HWSPI              1
+#endif
+
+// Chips fitted; chip n's FSYNC is PC5 - n
+#ifndef AD9833_CHANNELS
+#define AD9833_CHANNELS           1
+#endif
+#if AD9833_CHANNELS < 1 || AD9833_CHANNELS > 4
+#error "AD9833_CHANNELS must be 1 to 4"
+#endif
+
+// Chip masks for the setters
+#define AD9833_CH(n)              ((uint8_t)(1 << (n)))
+#define AD9833_ALL                ((uint8_t)((1 << AD9833_CHANNELS) - 1))
 
         typedef enum AD9833_WaveMode
         {
@@ -41,46 +72,167 @@ extern "C"
                 AD9833_SLEEP_STOP    = 0,
                 AD9833_SLEEP_DAC_OFF = 1,
                 AD9833_SLEEP_STOP_DAC_OFF  = 2,
-                AD9833_SLEEP_,
-                TODO
+                AD9833_SLEEP_NONE    = 3
         } AD9833_SleepMode_t;
-        
+
+// Bits for AD9833_sleep()
+#define AD9833_SLEEP_BIT_DAC      1      // SLEEP12: DAC powered down
+#define AD9833_SLEEP_BIT_MCLK     2      // SLEEP1: internal clock stopped
+
 
 //////////////////////////////////////////////////////////////////////////////
 /// @function AD9833_init
-/// @brief   Initializes AD9833 
-/// @return
+/// @brief   Initializes AD9833
+///          Sets up the SPI transport, then leaves every chip in RESET
+///          with all frequency and phase registers zero, sine output.
+/// @return  0
 /////////////////////////////////////////////////////////////////////////////
         int AD9833_init();
 
   ////////////////////////////////////////////////////////////////////////////
   /// @fn AD9833_write_word
-  /// @brief Write a raw 16 bit word to the chip.
-  /// @param[in] wd  The word to write.
+  /// @brief Write a raw 16 bit word to the chips.
+  ///        Sends at once, ahead of anything staged, and bypasses the
+  ///        shadow registers.  For bring-up only.
+  /// @param[in] chips  AD9833_CH() mask.
+  /// @param[in] wd     The word to write.
+  ////////////////////////////////////////////////////////////////////////////
+ void AD9833_write_word(uint8_t chips, uint16_t wd);
+
+  ////////////////////////////////////////////////////////////////////////////
+  /// @fn AD9833_set_frequency
+  /// @brief Stages a frequency register write for each chip whose value
+  ///        changed.
+  /// @param[in] chips  AD9833_CH() mask.
+  /// @param[in] which  Register 0 or 1.
+  /// @param[in] freq   28 bit tuning word.
+  ////////////////////////////////////////////////////////////////////////////
+        void AD9833_set_frequency(uint8_t chips, int which, uint32_t freq);
+
+  ////////////////////////////////////////////////////////////////////////////
+  /// @fn AD9833_set_phase
+  /// @brief Stages a phase register write for each chip whose value
+  ///        changed.
+  /// @param[in] chips  AD9833_CH() mask.
+  /// @param[in] which  Register 0 or 1.
+  /// @param[in] phase  12 bit phase word, 4096 = 360 degrees.
+  ////////////////////////////////////////////////////////////////////////////
+        void AD9833_set_phase(uint8_t chips, int which, uint32_t phase);
+
+        void AD9833_select_freq(uint8_t chips, int which);
+
+        void AD9833_select_phase(uint8_t chips, int which);
+
+  ////////////////////////////////////////////////////////////////////////////
+  /// @fn AD9833_reset
+  /// @param[in] chips  AD9833_CH() mask.
+  /// @param[in] res    Non zero holds the phase accumulator in RESET.
+  ////////////////////////////////////////////////////////////////////////////
+        void AD9833_reset(uint8_t chips, int res);
+
+  ////////////////////////////////////////////////////////////////////////////
+  /// @fn AD9833_sleep
+  /// @param[in] chips      AD9833_CH() mask.
+  /// @param[in] sleepMode  AD9833_SLEEP_BIT_ flags, 0 for fully awake.
   ////////////////////////////////////////////////////////////////////////////
- void AD9833_write_word(uint16_t wd);
-    
-        void AD9833_set_frequency(int which, uint32_t freq);
+        void AD9833_sleep(uint8_t chips, int sleepMode);
 
-        void AD9833_set_phase(int which, uint32_t phase);
+        void AD9833_set_wave_mode(uint8_t chips, AD9833_WaveMode_t md);
 
-        void AD9833_select_freq(int which);
+  ////////////////////////////////////////////////////////////////////////////
+  /// @fn AD9833_run_mode
+  /// @brief AD9833_sleep() by name: SLEEP1 stops the clock and holds the
+  ///        output level, SLEEP12 powers the DAC down, both draw least.
+  ///        AD9833_SLEEP_NONE wakes them.  Sent by the next update.
+  ////////////////////////////////////////////////////////////////////////////
+        void AD9833_run_mode(uint8_t chips, AD9833_SleepMode_t md);
 
-        void AD9833_select_phase(int which);
+  ////////////////////////////////////////////////////////////////////////////
+  /// @fn AD9833_get_frequency
+  /// @param[in] ch     Chip 0 to AD9833_CHANNELS - 1.
+  /// @param[in] which  Register 0 or 1.
+  /// @return The tuning word the chip holds in that register.
+  ////////////////////////////////////////////////////////////////////////////
+        uint32_t AD9833_get_frequency(uint8_t ch, int which);
+
+  ////////////////////////////////////////////////////////////////////////////
+  /// @fn AD9833_get_selected_freq
+  /// @param[in] ch  Chip 0 to AD9833_CHANNELS - 1.
+  /// @return Frequency register selected by FSEL, staged or sent.
+  ////////////////////////////////////////////////////////////////////////////
+        int AD9833_get_selected_freq(uint8_t ch);
+
+  ////////////////////////////////////////////////////////////////////////////
+  /// @fn AD9833_select_word
+  /// @brief For keying FSEL and PSEL with single words sent elsewhere.
+  /// @param[in] ch     Chip 0 to AD9833_CHANNELS - 1.
+  /// @param[in] freq   FREQ register 0 or 1.
+  /// @param[in] phase  PHASE register 0 or 1.
+  /// @return The control word last sent to the chip, with FSEL and PSEL
+  ///         selecting these registers.
+  ////////////////////////////////////////////////////////////////////////////
+        uint16_t AD9833_select_word(uint8_t ch, int freq, int phase);
 
-        void AD9833_reset(int res);
+  ////////////////////////////////////////////////////////////////////////////
+  /// @fn AD9833_gate_word
+  /// @brief For switching the output off and on with single words sent
+  ///        elsewhere.
+  /// @param[in] ch         Chip 0 to AD9833_CHANNELS - 1.
+  /// @param[in] res        Non zero sets RESET.
+  /// @param[in] sleepMode  AD9833_SLEEP_BIT_ flags.
+  /// @return The control word last sent to the chip, with RESET and the
+  ///         sleep bits as given.
+  ////////////////////////////////////////////////////////////////////////////
+        uint16_t AD9833_gate_word(uint8_t ch, int res, int sleepMode);
 
-        void AD9833_sleep(int sleepMode);
+  ////////////////////////////////////////////////////////////////////////////
+  /// @fn AD9833_stream_freq
+  /// @brief For rewriting one frequency register many times a second with
+  ///        words sent elsewhere.  Puts the chips in LSB load mode if the
+  ///        upper 14 bits are the same for every value from lo to hi,
+  ///        else in 28 bit mode, with the control word going out at the
+  ///        next update, and forgets the register's value.
+  /// @param[in]  chips  AD9833_CH() mask.
+  /// @param[in]  which  Register 0 or 1.
+  /// @param[in]  lo     Lowest tuning word to be written.
+  /// @param[in]  hi     Highest.
+  /// @param[out] addr   Address bits to OR with each 14 bit half.
+  /// @return Words per value: 1, the low half only, or 2, low then high.
+  ////////////////////////////////////////////////////////////////////////////
+        uint8_t AD9833_stream_freq(uint8_t chips, int which, uint32_t lo,
+                                   uint32_t hi, uint16_t* addr);
 
-        void AD9833_set_wave_mode(AD9833_WaveMode_t md);
+  ////////////////////////////////////////////////////////////////////////////
+  /// @fn AD9833_update
+  /// @brief Adds the control words that changed and sends everything
+  ///        staged.  Does nothing if nothing changed.
+  /// @param[in] chips  Chips whose control words to bring up to date.
+  ////////////////////////////////////////////////////////////////////////////
+        void AD9833_update(uint8_t chips);
 
-        void AD9833_run_mode(AD9833_SleepMode_t md);
+  ////////////////////////////////////////////////////////////////////////////
+  /// @fn AD9833_take
+  /// @brief Like AD9833_update(), but hands the words to the caller to
+  ///        send later instead of sending them.  The shadow registers
+  ///        assume they will be sent, in order, before any later update.
+  /// @param[in]  chips  Chips whose control words to bring up to date.
+  /// @param[out] wds    Room for max words.
+  /// @param[in]  max    If more are staged, or the chips needed different
+  ///                    words, they are sent now and 0 returned.
+  /// @param[out] to     The chips wds is for.
+  /// @return Number of words in wds.
+  ////////////////////////////////////////////////////////////////////////////
+        uint8_t AD9833_take(uint8_t chips, uint16_t* wds, uint8_t max,
+                            uint8_t* to);
 
-        
+  ////////////////////////////////////////////////////////////////////////////
+  /// @fn AD9833_invalidate
+  /// @brief Forgets what the chips hold, e.g. after taken words were
+  ///        dropped, so the next writes go out in full.
+  ////////////////////////////////////////////////////////////////////////////
+        void AD9833_invalidate(uint8_t chips);
 
-        void AD9833_update(void);
 
-        
 #ifdef __cplusplus
 }
 #endif  // __cplusplus
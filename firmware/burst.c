@@ -0,0 +1,235 @@
+//////////////////////////////////////////////////////////////////////////////
+///
+///  \file burst.c
+///
+///  \copy copyright (c) 2023 William R Cooke
+///
+///  @brief Gated bursts and on/off keying played through ddsq.
+///
+//////////////////////////////////////////////////////////////////////////////
+
+#include <stdint.h>
+#include "AD9833.h"
+#include "timer1.h"
+#include "ddsq.h"
+#include "trig.h"
+#include "burst.h"
+
+// Time from BURST_start() to the first burst, so it is queued ahead
+#define START_DELAY     TIMER1_CYCLES_PER_MS
+
+static uint8_t  chips;
+static uint8_t  gate;
+static uint32_t on_cycles;
+static uint32_t period;
+static uint16_t count;
+
+static uint8_t  active;         // the output is gated by us
+static uint8_t  playing;
+static uint8_t  waiting;        // held in ddsq, times from the edge
+static uint8_t  queued_all;     // done once the queue is played out
+static uint8_t  next_on;        // the next word turns the output on
+static uint32_t next_at;        // its TIMER1_now() cycle
+static uint16_t left;           // bursts still to finish, 0 for no end
+static uint16_t bursts;
+static uint16_t skipped;
+
+uint32_t BURST_cycles(uint16_t n, uint32_t hz)
+{
+        if (hz == 0 || n == 0)
+        {
+                return 0;
+        }
+        uint32_t f = TIMER1_CYCLES_PER_MS * 1000UL;
+        uint32_t q = f / hz;
+        uint32_t r = f % hz;
+        if (q > 0xffffffffUL / n)
+        {
+                return 0;
+        }
+        // n * r / hz a bit of n at a time from the top, so the remainder
+        // stays below 3 * hz and no 64 bit divide is needed
+        uint32_t whole = 0;
+        uint32_t rem = 0;
+        for (uint16_t bit = 0x8000; bit; bit >>= 1)
+        {
+                whole <<= 1;
+                rem <<= 1;
+                if (n & bit)
+                {
+                        rem += r;
+                }
+                while (rem >= hz)
+                {
+                        rem -= hz;
+                        whole++;
+                }
+        }
+        whole += rem >= hz - rem;
+        uint32_t c = q * n + whole;
+        return c < whole ? 0 : c;
+}
+
+uint8_t BURST_set(uint8_t ch, uint8_t g, uint32_t on, uint32_t p,
+                  uint16_t n)
+{
+        if (g > BURST_SLEEP || on < BURST_MIN_CYCLES
+            || (p && (p < BURST_MIN_PERIOD || p < on
+                      || p - on < BURST_MIN_CYCLES)))
+        {
+                return 0;
+        }
+        chips = ch;
+        gate = g;
+        on_cycles = on;
+        period = p;
+        count = n;
+        return 1;
+}
+
+// Puts the gate bits for on or off in the driver, to go out later.  The
+// other gate's bit is cleared, in case the gate changed since the last.
+static void stage(uint8_t on)
+{
+        AD9833_reset(chips, !on && gate == BURST_RESET);
+        AD9833_sleep(chips, !on && gate == BURST_SLEEP
+                     ? AD9833_SLEEP_BIT_MCLK : 0);
+}
+
+static uint8_t queue(uint32_t at, uint8_t on)
+{
+        if (gate == BURST_SLEEP)
+        {
+                return DDSQ_sleep(at, on ? 0 : AD9833_SLEEP_BIT_MCLK);
+        }
+        return DDSQ_reset(at, !on);
+}
+
+// Drops anything queued or armed and turns the output off now
+static void gate_off(void)
+{
+        playing = 0;
+        waiting = 0;
+        DDSQ_flush();
+        TRIG_disarm();
+        stage(0);
+        AD9833_update(chips);
+        active = 1;
+}
+
+// Queues bursts while there is room
+static void fill(void)
+{
+        while (playing && !queued_all && DDSQ_room())
+        {
+                if (next_on && period && !waiting
+                    && (int32_t)(next_at - TIMER1_now()) < 0)
+                {
+                        // Already due: played now it would come out short
+                        skipped++;
+                        next_at += period;
+                        if (left && --left == 0)
+                        {
+                                queued_all = 1;
+                        }
+                        continue;
+                }
+                queue(next_at, next_on);
+                if (next_on)
+                {
+                        next_at += on_cycles;
+                        next_on = 0;
+                        bursts++;
+                }
+                else
+                {
+                        next_at += period - on_cycles;
+                        next_on = 1;
+                        if (!period || (left && --left == 0))
+                        {
+                                queued_all = 1;
+                        }
+                }
+        }
+}
+
+static void begin(uint32_t at)
+{
+        next_at = at;
+        next_on = 1;
+        left = count;
+        bursts = 0;
+        skipped = 0;
+        queued_all = 0;
+        playing = 1;
+        fill();
+}
+
+void BURST_start(void)
+{
+        gate_off();
+        begin(TIMER1_now() + START_DELAY);
+}
+
+void BURST_arm(uint8_t edge)
+{
+        gate_off();
+        // The first bursts wait in ddsq for the capture interrupt
+        DDSQ_hold();
+        waiting = 1;
+        begin(0);
+        TRIG_arm_queue(edge);
+}
+
+void BURST_trigger(uint32_t at)
+{
+        if (waiting)
+        {
+                next_at += at;
+                waiting = 0;
+                fill();
+        }
+}
+
+void BURST_service(void)
+{
+        // Nothing more while held: the edge may come in the middle
+        if (!waiting)
+        {
+                fill();
+        }
+}
+
+void BURST_stop(void)
+{
+        if (!active)
+        {
+                return;
+        }
+        active = 0;
+        playing = 0;
+        waiting = 0;
+        DDSQ_flush();
+        TRIG_disarm();
+        stage(1);
+        AD9833_update(chips);
+}
+
+uint8_t BURST_playing(void)
+{
+        if (playing && queued_all && !DDSQ_pending())
+        {
+                playing = 0;
+        }
+        return playing;
+}
+
+uint16_t BURST_bursts(void)
+{
+        return bursts;
+}
+
+uint16_t BURST_skipped(void)
+{
+        return skipped;
+}
@@ -0,0 +1,143 @@
+//////////////////////////////////////////////////////////////////////////////
+///
+///  \file burst.h
+///
+///  \copy copyright (c) 2023 William R Cooke
+///
+///  @brief Gated bursts and on/off keying played through ddsq.
+///
+///  A burst is two queued control words, one turning the output on and
+///  one turning it off again, each tagged with its Timer1 cycle.  Both
+///  go out from the compare A interrupt the same way, so the time between
+///  them, the burst length, is exact to the cycle whatever run() is
+///  doing, unless one lands in a stretch with interrupts off: an LCD byte
+///  holds it up to about 700 cycles.  The length is given in Timer1
+///  cycles; BURST_cycles() turns a count of carrier periods into them.
+///
+///  The gate is RESET or SLEEP1.  RESET holds the phase accumulator at
+///  zero and the output at midscale, so every burst starts at zero phase
+///  and N carrier periods end on a zero crossing.  SLEEP1 stops the
+///  internal clock: the output holds whatever level it had, and the next
+///  burst carries on at the same phase.
+///
+///  Bursts repeat every period cycles, a given number of times or until
+///  BURST_stop().  The queue holds three bursts ahead, topped up by
+///  BURST_service() every tick; if run() falls further behind than that,
+///  whole bursts are skipped rather than played short, and counted.
+///
+///  BURST_arm() gates the output off and queues the first bursts with
+///  ddsq held, timed from 0; an edge on the trigger input releases them
+///  from the capture interrupt, so even a burst shorter than a tick is
+///  as long as asked.  BURST_trigger() then queues the rest.
+///
+///  While bursting the driver's shadows describe the chip as it will be
+///  after the last queued word, so run() must not write the DDS until
+///  BURST_stop().
+///
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef BURST_H
+#define BURST_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include "timer1.h"
+
+        typedef enum BURST_GATE
+        {
+                BURST_RESET        = 0,
+                BURST_SLEEP        = 1
+        } BurstGate_t;
+
+// Shortest on or off time.  The on word must be off the wire, two SPI
+// bytes and their interrupts, before the off word starts.
+#define BURST_MIN_CYCLES   256
+
+// Shortest repeat period, so three bursts queued outlast a late tick
+#define BURST_MIN_PERIOD   TIMER1_CYCLES_PER_MS
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn BURST_cycles
+/// @return Timer1 cycles in n periods of hz, to the nearest, or 0 if
+///         that does not fit 32 bits or hz is 0.
+//////////////////////////////////////////////////////////////////////////////
+        uint32_t BURST_cycles(uint16_t n, uint32_t hz);
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn BURST_set
+/// @brief Sets what BURST_start() and BURST_arm() play.
+/// @param[in] chips   AD9833_CH() mask, the ones DDSQ_chips() was given.
+/// @param[in] gate    BurstGate_t.
+/// @param[in] on      Burst length in Timer1 cycles.
+/// @param[in] period  Cycles from one burst's start to the next, or 0
+///                    for a single burst.
+/// @param[in] count   Bursts per start, 0 for no end.
+/// @return 1, or 0 if on or the time off is below BURST_MIN_CYCLES, or
+///         period is below BURST_MIN_PERIOD.
+//////////////////////////////////////////////////////////////////////////////
+        uint8_t BURST_set(uint8_t chips, uint8_t gate, uint32_t on,
+                          uint32_t period, uint16_t count);
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn BURST_start
+/// @brief Gates the output off now and starts bursting 1 ms later.
+//////////////////////////////////////////////////////////////////////////////
+        void BURST_start(void);
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn BURST_arm
+/// @brief Gates the output off now, queues the first bursts and arms the
+///        trigger input to start them.  Call BURST_trigger() when
+///        TRIG_fired() reports the edge.
+/// @param[in] edge  TRIG_RISING or TRIG_FALLING.
+//////////////////////////////////////////////////////////////////////////////
+        void BURST_arm(uint8_t edge);
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn BURST_trigger
+/// @brief Carries on queueing bursts after the ones the edge released.
+/// @param[in] at  TRIG_sent(), the cycle they count from.
+//////////////////////////////////////////////////////////////////////////////
+        void BURST_trigger(uint32_t at);
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn BURST_service
+/// @brief Queues bursts while ddsq has room.  Call every tick.
+//////////////////////////////////////////////////////////////////////////////
+        void BURST_service(void);
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn BURST_stop
+/// @brief Drops queued bursts and turns the output back on.  Nothing
+///        unless started or armed since the last stop.
+//////////////////////////////////////////////////////////////////////////////
+        void BURST_stop(void);
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn BURST_playing
+/// @return 1 until the last of a counted or single run is played out.
+///         The output then stays off until started, armed or stopped.
+//////////////////////////////////////////////////////////////////////////////
+        uint8_t BURST_playing(void);
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn BURST_bursts
+/// @return Bursts queued since the last start, modulo 2^16.
+//////////////////////////////////////////////////////////////////////////////
+        uint16_t BURST_bursts(void);
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn BURST_skipped
+/// @return Bursts skipped since the last start because their time had
+///         passed before there was room to queue them.
+//////////////////////////////////////////////////////////////////////////////
+        uint16_t BURST_skipped(void);
+
+#ifdef __cplusplus
+}
+#endif  // __cplusplus
+#endif  // #ifndef BURST_H
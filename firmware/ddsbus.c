@@ -0,0 +1,74 @@
+//////////////////////////////////////////////////////////////////////////////
+///
+///  \file ddsbus.c
+///
+///  \copy copyright (c) 2023 William R Cooke
+///
+///  @brief Hardware SPI transport for the AD9833.
+///
+//////////////////////////////////////////////////////////////////////////////
+
+#include <stdint.h>
+#include <avr/io.h>
+#include <util/atomic.h>
+#include "ddsbus.h"
+
+// SCK PB5, MOSI PB3, SS PB2 (output so it can't drop us out of master)
+#define FSYNC_LOW(bits)   (PORTC &= ~(bits))
+#define FSYNC_HIGH(bits)  (PORTC |= (bits))
+
+// Clocks one byte out and waits the 16 cycles it takes
+static void put(uint8_t b)
+{
+        SPDR = b;
+        while (!(SPSR & _BV(SPIF)))
+        {
+        }
+}
+
+// PORTC bits of the chips' FSYNCs
+static uint8_t fsync_bits(uint8_t chips)
+{
+        uint8_t bits = 0;
+        for (uint8_t c = 0; c < DDSBUS_CHIPS; c++)
+        {
+                if (chips & (1 << c))
+                {
+                        bits |= _BV(PC5 - c);
+                }
+        }
+        return bits;
+}
+
+void DDSBUS_init(uint8_t chips)
+{
+        uint8_t bits = fsync_bits(chips);
+        DDRB |= _BV(PB2) | _BV(PB3) | _BV(PB5);
+        FSYNC_HIGH(bits);
+        DDRC |= bits;
+        // Mode 2: clock idles high, data sampled on the falling edge
+        SPCR = _BV(SPE) | _BV(MSTR) | _BV(CPOL);
+        SPSR = _BV(SPI2X);
+}
+
+uint8_t DDSBUS_write(uint8_t chips, const uint16_t* words, uint8_t n)
+{
+        if (n == 0 || n > DDSBUS_MAX_WORDS)
+        {
+                return 0;
+        }
+        uint8_t bits = fsync_bits(chips);
+        // The ddsq, keyer, trigger and modulation interrupts write too,
+        // and must not start their words inside this transaction
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+        {
+                FSYNC_LOW(bits);
+                for (uint8_t i = 0; i < n; i++)
+                {
+                        put((uint8_t)(words[i] >> 8));
+                        put((uint8_t)words[i]);
+                }
+                FSYNC_HIGH(bits);
+        }
+        return 1;
+}
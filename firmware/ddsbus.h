@@ -0,0 +1,65 @@
+//////////////////////////////////////////////////////////////////////////////
+///
+///  \file ddsbus.h
+///
+///  \copy copyright (c) 2023 William R Cooke
+///
+///  @brief Hardware SPI transport for the AD9833.
+///
+///  Words are written in batches.  A batch goes out as one transaction:
+///  FSYNC is taken low once, every word of the batch is clocked out,
+///  and FSYNC goes high after the last one, which the AD9833 accepts as
+///  consecutive 16 bit writes.
+///
+///  The SPI runs at F_CPU/2, 16 cycles a byte, and the caller polls it
+///  to the end of the batch with interrupts off.  An interrupt per byte
+///  would cost more in entry and exit than the byte takes on the wire.
+///  A three word tuning batch keeps interrupts off for about 150
+///  cycles, and the DDSBUS_MAX_WORDS longest batch for about 650, under
+///  an LCD byte.
+///
+///  Several chips share the bus with an FSYNC each, chip n on PC5 - n.
+///  A batch names its chips, and all of their FSYNCs go low together, so
+///  they all take the same words.
+///
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef DDSBUS_H
+#define DDSBUS_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+
+// Most words in one batch
+#define DDSBUS_MAX_WORDS   15
+
+// Most chips, FSYNC on PC5 down to PC2
+#define DDSBUS_CHIPS       4
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn DDSBUS_init
+/// @brief Sets up the SPI peripheral as master, mode 2, F_CPU/2, and
+///        the FSYNC pins.
+/// @param[in] chips  Chips fitted, bit n for chip n.
+//////////////////////////////////////////////////////////////////////////////
+        void DDSBUS_init(uint8_t chips);
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn DDSBUS_write
+/// @brief Sends words as one FSYNC transaction.
+/// @param[in] chips  Chips to send to, bit n for chip n.
+/// @param[in] words  The words to send.
+/// @param[in] n      Number of words, 1 to DDSBUS_MAX_WORDS.
+/// @return 1 once sent, 0 if n is out of range.  Safe from an ISR.
+//////////////////////////////////////////////////////////////////////////////
+        uint8_t DDSBUS_write(uint8_t chips, const uint16_t* words,
+                             uint8_t n);
+
+#ifdef __cplusplus
+}
+#endif  // __cplusplus
+#endif  // #ifndef DDSBUS_H
@@ -0,0 +1,251 @@
+//////////////////////////////////////////////////////////////////////////////
+///
+///  \file ddsq.c
+///
+///  \copy copyright (c) 2023 William R Cooke
+///
+///  @brief Time-tagged DDS operations played from the Timer1 compare A ISR.
+///
+//////////////////////////////////////////////////////////////////////////////
+
+#include <stdint.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <util/atomic.h>
+#include "AD9833.h"
+#include "ddsbus.h"
+#include "timer1.h"
+#include "ddsq.h"
+#include "ring.h"
+
+RING_CHECK(DDSQ_SIZE);
+
+// An operation due within this many cycles is played at once, spinning
+// the few cycles left, rather than risk setting a compare point that
+// has already passed.
+#define LEAD_CYCLES     64
+
+typedef struct DDSQ_OP
+{
+        uint32_t at;
+        uint8_t  n;
+        uint8_t  chips;
+        uint16_t words[DDSQ_WORDS];
+} ddsq_op_t;
+
+static ddsq_op_t        queue[DDSQ_SIZE];
+static volatile uint8_t head;        // next free slot, moved by run()
+static volatile uint8_t tail;        // next to play, moved by the ISR
+static volatile uint16_t done;
+static volatile uint16_t late;
+static volatile uint8_t held;        // times are from DDSQ_release()
+static uint8_t          chips = AD9833_CH(0);
+
+// Plays everything that is due and sets compare A for the next one.
+// Interrupts must be off.
+static void play_due(void)
+{
+        while (tail != head)
+        {
+                ddsq_op_t* op = &queue[tail];
+                int32_t d = (int32_t)(op->at - TIMER1_now());
+                if (d > LEAD_CYCLES)
+                {
+                        OCR1A = (uint16_t)op->at;
+                        if ((int32_t)(op->at - TIMER1_now()) > LEAD_CYCLES)
+                        {
+                                return;
+                        }
+                        continue;
+                }
+                while (d > 0)
+                {
+                        d = (int32_t)(op->at - TIMER1_now());
+                }
+                if (op->n)
+                {
+                        DDSBUS_write(op->chips, op->words, op->n);
+                }
+                uint32_t behind = (uint32_t)-d;
+                if (behind > late)
+                {
+                        late = behind > 0xffff ? 0xffff : (uint16_t)behind;
+                }
+                tail = RING_NEXT(tail, DDSQ_SIZE);
+                done++;
+        }
+        TIMSK &= ~_BV(OCIE1A);
+}
+
+// Takes the words the driver staged into the next slot and queues it.
+// The caller has checked there is room.
+static uint8_t put(uint32_t at)
+{
+        ddsq_op_t* op = &queue[head];
+        op->at = at;
+        op->n = AD9833_take(chips, op->words, DDSQ_WORDS, &op->chips);
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+        {
+                head = RING_NEXT(head, DDSQ_SIZE);
+                if (!held)
+                {
+                        TIMSK |= _BV(OCIE1A);
+                        play_due();
+                }
+        }
+        return 1;
+}
+
+void DDSQ_init(void)
+{
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+        {
+                head = tail = 0;
+                done = 0;
+                late = 0;
+                held = 0;
+                TIMSK &= ~_BV(OCIE1A);
+        }
+}
+
+void DDSQ_chips(uint8_t c)
+{
+        chips = c;
+}
+
+uint8_t DDSQ_room(void)
+{
+        return RING_ROOM(head, tail, DDSQ_SIZE);
+}
+
+uint8_t DDSQ_pending(void)
+{
+        return RING_USED(head, tail, DDSQ_SIZE);
+}
+
+uint8_t DDSQ_frequency(uint32_t at, uint8_t which, uint32_t word)
+{
+        if (!DDSQ_room())
+        {
+                return 0;
+        }
+        AD9833_set_frequency(chips, which, word);
+        return put(at);
+}
+
+uint8_t DDSQ_phase(uint32_t at, uint8_t which, uint16_t phase)
+{
+        if (!DDSQ_room())
+        {
+                return 0;
+        }
+        AD9833_set_phase(chips, which, phase);
+        return put(at);
+}
+
+uint8_t DDSQ_select(uint32_t at, uint8_t freq, uint8_t phase)
+{
+        if (!DDSQ_room())
+        {
+                return 0;
+        }
+        AD9833_select_freq(chips, freq);
+        AD9833_select_phase(chips, phase);
+        return put(at);
+}
+
+uint8_t DDSQ_reset(uint32_t at, uint8_t on)
+{
+        if (!DDSQ_room())
+        {
+                return 0;
+        }
+        AD9833_reset(chips, on);
+        return put(at);
+}
+
+uint8_t DDSQ_sleep(uint32_t at, uint8_t mode)
+{
+        if (!DDSQ_room())
+        {
+                return 0;
+        }
+        AD9833_sleep(chips, mode);
+        return put(at);
+}
+
+uint8_t DDSQ_hop(uint32_t at, uint32_t word)
+{
+        if (!DDSQ_room())
+        {
+                return 0;
+        }
+        // FSEL as the lowest of the chips has it
+        int idle = !AD9833_get_selected_freq(__builtin_ctz(chips));
+        AD9833_set_frequency(chips, idle, word);
+        AD9833_select_freq(chips, idle);
+        return put(at);
+}
+
+uint16_t DDSQ_done(void)
+{
+        uint16_t n;
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+        {
+                n = done;
+        }
+        return n;
+}
+
+uint16_t DDSQ_late(void)
+{
+        uint16_t n;
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+        {
+                n = late;
+        }
+        return n;
+}
+
+void DDSQ_flush(void)
+{
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+        {
+                if (head != tail)
+                {
+                        head = tail;
+                        AD9833_invalidate(chips);
+                }
+                held = 0;
+                TIMSK &= ~_BV(OCIE1A);
+        }
+}
+
+void DDSQ_hold(void)
+{
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+        {
+                held = 1;
+                TIMSK &= ~_BV(OCIE1A);
+        }
+}
+
+void DDSQ_release(uint32_t base)
+{
+        if (!held)
+        {
+                return;
+        }
+        held = 0;
+        for (uint8_t i = tail; i != head; i = RING_NEXT(i, DDSQ_SIZE))
+        {
+                queue[i].at += base;
+        }
+        TIMSK |= _BV(OCIE1A);
+        play_due();
+}
+
+ISR(TIMER1_COMPA_vect)
+{
+        play_due();
+}
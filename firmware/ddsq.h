@@ -0,0 +1,128 @@
+//////////////////////////////////////////////////////////////////////////////
+///
+///  \file ddsq.h
+///
+///  \copy copyright (c) 2023 William R Cooke
+///
+///  @brief Time-tagged DDS operations played from the Timer1 compare A ISR.
+///
+///  Each operation is turned into AD9833 words when it is queued, through
+///  the driver's shadow registers, and tagged with the TIMER1_now() cycle
+///  it should happen at.  The TIMER1_COMPA interrupt hands the words to
+///  ddsbus at that cycle, so output changes land within a few
+///  microseconds of their time however busy run() is.
+///
+///  While operations are queued the driver's shadows describe the chip as
+///  it will be after the last one, so run() must not write the DDS
+///  directly until the queue is empty or DDSQ_flush() is called.
+///
+///  Operations go to the chips set with DDSQ_chips(), chip 0 unless told
+///  otherwise.  Chips holding the same registers get each operation in
+///  one transaction; words for chips that differ go out when queued.
+///
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef DDSQ_H
+#define DDSQ_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+
+// Queued operations, a power of 2
+#define DDSQ_SIZE          8
+
+// Most AD9833 words one operation may need
+#define DDSQ_WORDS         4
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn DDSQ_init
+/// @brief Empties the queue and enables the compare A interrupt.
+///        TIMER1_init() must have been called.
+//////////////////////////////////////////////////////////////////////////////
+        void DDSQ_init(void);
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn DDSQ_chips
+/// @brief Sets the chips later operations go to.
+/// @param[in] chips  AD9833_CH() mask.
+//////////////////////////////////////////////////////////////////////////////
+        void DDSQ_chips(uint8_t chips);
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn DDSQ_frequency
+/// @brief Queues a tuning word for register which.
+/// @param[in] at     TIMER1_now() cycle to apply it.
+/// @param[in] which  FREQ register 0 or 1.
+/// @param[in] word   28 bit tuning word.
+/// @return 1 if queued, 0 if the queue is full.
+//////////////////////////////////////////////////////////////////////////////
+        uint8_t DDSQ_frequency(uint32_t at, uint8_t which, uint32_t word);
+
+        uint8_t DDSQ_phase(uint32_t at, uint8_t which, uint16_t phase);
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn DDSQ_select
+/// @brief Queues FSEL and PSEL, one control word.
+//////////////////////////////////////////////////////////////////////////////
+        uint8_t DDSQ_select(uint32_t at, uint8_t freq, uint8_t phase);
+
+        uint8_t DDSQ_reset(uint32_t at, uint8_t on);
+
+        uint8_t DDSQ_sleep(uint32_t at, uint8_t mode);
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn DDSQ_hop
+/// @brief Queues a glitch-free frequency change: the word goes into the
+///        idle FREQ register and FSEL switches to it at cycle at.
+//////////////////////////////////////////////////////////////////////////////
+        uint8_t DDSQ_hop(uint32_t at, uint32_t word);
+
+        uint8_t DDSQ_room(void);
+
+        uint8_t DDSQ_pending(void);
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn DDSQ_done
+/// @return Operations played since DDSQ_init(), modulo 2^16.
+//////////////////////////////////////////////////////////////////////////////
+        uint16_t DDSQ_done(void);
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn DDSQ_late
+/// @return Largest lateness seen, in cycles after the tagged time.
+//////////////////////////////////////////////////////////////////////////////
+        uint16_t DDSQ_late(void);
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn DDSQ_hold
+/// @brief Stops playing.  Operations queued from now on are tagged with
+///        cycles after a time not yet known, given to DDSQ_release().
+///        The queue must be empty.
+//////////////////////////////////////////////////////////////////////////////
+        void DDSQ_hold(void);
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn DDSQ_release
+/// @brief Adds base to every queued time and plays on.  Interrupts must
+///        be off; for an interrupt handler such as the trigger capture.
+///        Nothing unless held.
+/// @param[in] base  TIMER1_now() cycle the held times count from.
+//////////////////////////////////////////////////////////////////////////////
+        void DDSQ_release(uint32_t base);
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn DDSQ_flush
+/// @brief Drops everything not yet played, ends a hold and tells the
+///        driver its shadows are no longer known, so direct writes can
+///        resume.
+//////////////////////////////////////////////////////////////////////////////
+        void DDSQ_flush(void);
+
+#ifdef __cplusplus
+}
+#endif  // __cplusplus
+#endif  // #ifndef DDSQ_H
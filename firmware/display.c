@@ -0,0 +1,145 @@
+//////////////////////////////////////////////////////////////////////////////
+///
+///  \file display.c
+///
+///  \copy copyright (c) 2023 William R Cooke
+///
+///  @brief 2x16 shadow framebuffer for the HD44780.
+///
+//////////////////////////////////////////////////////////////////////////////
+
+#include <stdint.h>
+
+#ifndef F_CPU
+#define F_CPU 16000000UL
+#endif
+
+#include <avr/interrupt.h>
+#include <avr/pgmspace.h>
+#include <util/delay.h>
+#include "lcd.h"
+#include "display.h"
+
+#define CELLS           (DISPLAY_COLS * DISPLAY_ROWS)
+#define NO_CURSOR       0xff
+
+// HD44780 clear and display control commands, the display on bit and
+// how long a clear keeps the controller busy
+#define LCD_CLEAR       0x01
+#define LCD_DISPLAY     0x08
+#define LCD_DISPLAY_ON  0x04
+#define LCD_CLEAR_US    1600
+
+static uint8_t frame[CELLS];      // what the UI wants
+static uint8_t shown[CELLS];      // what the LCD has
+static uint8_t cursor;            // frame position being drawn
+static uint8_t lcd_cursor;        // LCD address counter, as a cell index
+static uint8_t scan;              // where the next flush starts looking
+
+void DISPLAY_init(void)
+{
+        // Only the command byte needs interrupts off; the controller's
+        // 1.52 ms clearing is waited out with them on
+        cli();
+        LCD_write_command(LCD_CLEAR);
+        sei();
+        _delay_us(LCD_CLEAR_US);
+        for (uint8_t i = 0; i < CELLS; i++)
+        {
+                frame[i] = ' ';
+                shown[i] = ' ';
+        }
+        cursor = 0;
+        lcd_cursor = 0;
+        scan = 0;
+}
+
+void DISPLAY_clear(void)
+{
+        for (uint8_t i = 0; i < CELLS; i++)
+        {
+                frame[i] = ' ';
+        }
+        cursor = 0;
+}
+
+void DISPLAY_goto(uint8_t x, uint8_t y)
+{
+        cursor = (uint8_t)(y * DISPLAY_COLS + x);
+}
+
+void DISPLAY_write_char(uint8_t ch)
+{
+        if (cursor < CELLS)
+        {
+                frame[cursor++] = ch;
+        }
+}
+
+void DISPLAY_write_string(const uint8_t* str)
+{
+        // Text past the end of a line is dropped
+        uint8_t end = (uint8_t)((cursor / DISPLAY_COLS + 1) * DISPLAY_COLS);
+        while (*str && cursor < end)
+        {
+                frame[cursor++] = *str++;
+        }
+}
+
+void DISPLAY_write_string_P(const char* str)
+{
+        uint8_t end = (uint8_t)((cursor / DISPLAY_COLS + 1) * DISPLAY_COLS);
+        uint8_t ch;
+        while ((ch = pgm_read_byte(str++)) != '\0' && cursor < end)
+        {
+                frame[cursor++] = ch;
+        }
+}
+
+void DISPLAY_enable(uint8_t on)
+{
+        cli();
+        LCD_write_command(on ? LCD_DISPLAY | LCD_DISPLAY_ON
+                                : LCD_DISPLAY);
+        sei();
+}
+
+uint8_t DISPLAY_flush(uint8_t max_cells)
+{
+        uint8_t dirty = 0;
+        uint8_t i = scan;
+        for (uint8_t n = 0; n < CELLS; n++)
+        {
+                if (frame[i] != shown[i])
+                {
+                        if (max_cells == 0)
+                        {
+                                if (dirty++ == 0)
+                                {
+                                        scan = i;
+                                }
+                        }
+                        else
+                        {
+                                max_cells--;
+                                // The LCD advances its address by itself,
+                                // so a run of changed cells needs one goto
+                                if (lcd_cursor != i)
+                                {
+                                        cli();
+                                        LCD_goto(i % DISPLAY_COLS,
+                                                       i / DISPLAY_COLS);
+                                        sei();
+                                }
+                                cli();
+                                LCD_write_data(frame[i]);
+                                sei();
+                                shown[i] = frame[i];
+                                lcd_cursor = (i + 1) % DISPLAY_COLS
+                                        ? i + 1 : NO_CURSOR;
+                        }
+                }
+                i = (i + 1) % CELLS;
+        }
+        return dirty;
+}
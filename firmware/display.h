@@ -0,0 +1,71 @@
+//////////////////////////////////////////////////////////////////////////////
+///
+///  \file display.h
+///
+///  \copy copyright (c) 2023 William R Cooke
+///
+///  @brief 2x16 shadow framebuffer for the HD44780.
+///
+///  UI code draws into RAM only.  DISPLAY_flush() compares the frame with
+///  what the LCD already shows and sends just the changed cells, a few per
+///  call.  Interrupts are masked around one LCD access at a time, never
+///  around a whole redraw.
+///
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef DISPLAY_H
+#define DISPLAY_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+
+#define DISPLAY_COLS          16
+#define DISPLAY_ROWS          2
+
+// Cells sent per DISPLAY_flush() call from the 1 ms loop
+#define DISPLAY_FLUSH_CELLS   4
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn DISPLAY_init
+/// @brief Clears the LCD and the framebuffer.
+//////////////////////////////////////////////////////////////////////////////
+        void DISPLAY_init(void);
+
+        void DISPLAY_clear(void);
+
+        void DISPLAY_goto(uint8_t x, uint8_t y);
+
+        void DISPLAY_write_char(uint8_t ch);
+
+        void DISPLAY_write_string(const uint8_t* str);
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn DISPLAY_write_string_P
+/// @brief DISPLAY_write_string() for a string in flash, such as PSTR().
+//////////////////////////////////////////////////////////////////////////////
+        void DISPLAY_write_string_P(const char* str);
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn DISPLAY_enable
+/// @brief Turns the LCD's display on or off.  Off, the controller keeps
+///        its memory and the frame, so turning it on again shows the
+///        same text without a redraw.
+//////////////////////////////////////////////////////////////////////////////
+        void DISPLAY_enable(uint8_t on);
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn DISPLAY_flush
+/// @brief Sends changed cells to the LCD.
+/// @param[in] max_cells  Most characters to write in this call.
+/// @return Number of cells still differing from the LCD.
+//////////////////////////////////////////////////////////////////////////////
+        uint8_t DISPLAY_flush(uint8_t max_cells);
+
+#ifdef __cplusplus
+}
+#endif  // __cplusplus
+#endif  // #ifndef DISPLAY_H
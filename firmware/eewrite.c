@@ -0,0 +1,110 @@
+//////////////////////////////////////////////////////////////////////////////
+///
+///  \file eewrite.c
+///
+///  \copy copyright (c) 2023 William R Cooke
+///
+///  @brief Background EEPROM writer driven by the EE_READY interrupt.
+///
+//////////////////////////////////////////////////////////////////////////////
+
+#include <stdint.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <util/atomic.h>
+#include "eewrite.h"
+#include "ring.h"
+
+RING_CHECK(EEWRITE_SIZE);
+RING_CHECK(EEWRITE_BLOCKS);
+
+static uint8_t          data[EEWRITE_SIZE];
+static volatile uint8_t data_head;        // next free byte, moved by queue
+static volatile uint8_t data_tail;        // next to write, moved by the ISR
+
+static uint8_t*         block_addr[EEWRITE_BLOCKS];  // next byte's address
+static uint8_t          block_left[EEWRITE_BLOCKS];
+static volatile uint8_t block_head;
+static volatile uint8_t block_tail;
+
+static volatile uint8_t completed;
+static volatile uint8_t finishing;        // last byte of a block in flight
+
+uint8_t EEWRITE_queue(void* dst, const void* src, uint8_t n)
+{
+        const uint8_t* s = src;
+        // The tails only move toward the heads, so stale reads under-count
+        uint8_t room = RING_ROOM(data_head, data_tail, EEWRITE_SIZE);
+        uint8_t blocks = RING_ROOM(block_head, block_tail, EEWRITE_BLOCKS);
+        if (n == 0 || n > room || blocks == 0)
+        {
+                return 0;
+        }
+        uint8_t h = data_head;
+        for (uint8_t i = 0; i < n; i++)
+        {
+                data[h] = s[i];
+                h = RING_NEXT(h, EEWRITE_SIZE);
+        }
+        block_addr[block_head] = dst;
+        block_left[block_head] = n;
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+        {
+                data_head = h;
+                block_head = RING_NEXT(block_head, EEWRITE_BLOCKS);
+                EECR |= _BV(EERIE);
+        }
+        return 1;
+}
+
+uint8_t EEWRITE_busy(void)
+{
+        return block_head != block_tail || finishing
+                || (EECR & (_BV(EERIE) | _BV(EEWE)));
+}
+
+uint8_t EEWRITE_completed(void)
+{
+        return completed;
+}
+
+// Runs whenever EEWE is clear and EERIE set, so once per finished byte
+// and then once more to find the queue empty
+ISR(EE_RDY_vect)
+{
+        if (finishing)
+        {
+                finishing = 0;
+                completed++;
+        }
+        while (block_tail != block_head)
+        {
+                uint8_t t = block_tail;
+                uint8_t* addr = block_addr[t];
+                uint8_t b = data[data_tail];
+                data_tail = RING_NEXT(data_tail, EEWRITE_SIZE);
+                block_addr[t] = addr + 1;
+                if (--block_left[t] == 0)
+                {
+                        block_tail = RING_NEXT(t, EEWRITE_BLOCKS);
+                        finishing = 1;
+                }
+
+                EEAR = (uintptr_t)addr;
+                EECR |= _BV(EERE);
+                if (EEDR != b)
+                {
+                        EEDR = b;
+                        EECR |= _BV(EEMWE);
+                        EECR |= _BV(EEWE);
+                        return;
+                }
+                if (finishing)
+                {
+                        // Unchanged last byte, nothing in flight
+                        finishing = 0;
+                        completed++;
+                }
+        }
+        EECR &= ~_BV(EERIE);
+}
@@ -0,0 +1,59 @@
+//////////////////////////////////////////////////////////////////////////////
+///
+///  \file eewrite.h
+///
+///  \copy copyright (c) 2023 William R Cooke
+///
+///  @brief Background EEPROM writer driven by the EE_READY interrupt.
+///
+///  EEWRITE_queue() copies the data and returns at once; the EE_RDY
+///  interrupt then writes one byte per 3.4 ms EEPROM cycle, skipping
+///  bytes that already hold the right value.  Nothing else may touch the
+///  EEPROM registers while EEWRITE_busy(), so reads wait for it: an
+///  eeprom_read_block() racing the interrupt could read from the address
+///  the ISR just set.
+///
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef EEWRITE_H
+#define EEWRITE_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+
+// Bytes waiting to be written, a power of 2
+#define EEWRITE_SIZE       64
+
+// Blocks waiting to be written, a power of 2
+#define EEWRITE_BLOCKS     4
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn EEWRITE_queue
+/// @brief Queues a block write.
+/// @param[in] dst  EEPROM address.
+/// @param[in] src  Data, copied before returning.
+/// @param[in] n    Bytes, 1 to EEWRITE_SIZE - 1.
+/// @return 1 if queued, 0 if there is no room for the whole block.
+//////////////////////////////////////////////////////////////////////////////
+        uint8_t EEWRITE_queue(void* dst, const void* src, uint8_t n);
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn EEWRITE_busy
+/// @return Non zero while blocks are queued or a byte is being written.
+//////////////////////////////////////////////////////////////////////////////
+        uint8_t EEWRITE_busy(void);
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn EEWRITE_completed
+/// @return Blocks fully written since reset, modulo 256.
+//////////////////////////////////////////////////////////////////////////////
+        uint8_t EEWRITE_completed(void);
+
+#ifdef __cplusplus
+}
+#endif  // __cplusplus
+#endif  // #ifndef EEWRITE_H
@@ -0,0 +1,219 @@
+//////////////////////////////////////////////////////////////////////////////
+///
+///  \file fmt.c
+///
+///  \copy copyright (c) 2023 William R Cooke
+///
+///  @brief Division-free decimal formatting and parsing.
+///
+//////////////////////////////////////////////////////////////////////////////
+
+#include <stdint.h>
+#include <avr/pgmspace.h>
+#include "fmt.h"
+
+#define DIGITS          10       // in a uint32_t
+
+static const uint32_t pow10[DIGITS - 1] PROGMEM =
+{
+        1000000000UL, 100000000UL, 10000000UL, 1000000UL, 100000UL,
+        10000UL, 1000UL, 100UL, 10UL
+};
+
+// All ten digits of v, most significant first, as ASCII
+static void digits(uint8_t* d, uint32_t v)
+{
+        for (uint8_t i = 0; i < DIGITS - 1; i++)
+        {
+                uint32_t p = pgm_read_dword(&pow10[i]);
+                uint8_t ch = '0';
+                while (v >= p)
+                {
+                        v -= p;
+                        ch++;
+                }
+                d[i] = ch;
+        }
+        d[DIGITS - 1] = (uint8_t)('0' + v);
+}
+
+// Copies d[from..to) to out, blanking zeros until the first other digit
+// or the last one copied
+static uint8_t* copy_digits(uint8_t* out, const uint8_t* d, uint8_t from,
+                            uint8_t to, uint8_t* leading)
+{
+        for (uint8_t i = from; i < to; i++)
+        {
+                if (*leading && d[i] == '0' && i != to - 1)
+                {
+                        *out++ = ' ';
+                        continue;
+                }
+                *leading = 0;
+                *out++ = d[i];
+        }
+        return out;
+}
+
+static uint8_t* blanks(uint8_t* out, uint8_t n)
+{
+        while (n--)
+        {
+                *out++ = ' ';
+        }
+        return out;
+}
+
+void FMT_uint(uint8_t* buf, uint32_t v, uint8_t width)
+{
+        uint8_t d[DIGITS];
+        uint8_t leading = 1;
+        digits(d, v);
+        // Zeros above the window are leading even when cut off
+        for (uint8_t i = 0; i < DIGITS - width; i++)
+        {
+                if (d[i] != '0')
+                {
+                        leading = 0;
+                }
+        }
+        copy_digits(buf, d, DIGITS - width, DIGITS, &leading);
+        buf[width] = '\0';
+}
+
+uint32_t FMT_split_freq(freq_t f, uint16_t* mhz)
+{
+        // Long division by 1000, a quotient bit at a time; f is below
+        // 2^34, so the quotient is below 2^25
+        uint32_t hz = 0;
+        freq_t p = (freq_t)FREQ_MHZ_PER_HZ << (FREQ_BITS - 10);
+        for (uint32_t bit = 1UL << (FREQ_BITS - 10); bit; bit >>= 1)
+        {
+                if (f >= p)
+                {
+                        f -= p;
+                        hz |= bit;
+                }
+                p >>= 1;
+        }
+        if (mhz)
+        {
+                *mhz = (uint16_t)f;
+        }
+        return hz;
+}
+
+void FMT_freq(uint8_t* buf, freq_t f)
+{
+        // d[2..3] MHz, d[4..6] kHz, d[7..9] Hz, m[7..9] mHz
+        uint8_t d[DIGITS];
+        uint8_t m[DIGITS];
+        uint8_t leading = 1;
+        uint8_t* p = buf;
+        const char* unit;
+        uint16_t mhz;
+        uint32_t hz = FMT_split_freq(f, &mhz);
+        digits(d, hz);
+        digits(m, mhz);
+        if (hz >= 1000000UL)
+        {
+                p = copy_digits(p, d, 2, 4, &leading);
+                *p++ = '.';
+                p = copy_digits(p, d, 4, 7, &leading);
+                *p++ = ' ';
+                p = copy_digits(p, d, 7, 10, &leading);
+                *p++ = ' ';
+                p = copy_digits(p, m, 7, 9, &leading);
+                unit = PSTR("MHz");
+        }
+        else if (hz >= 1000)
+        {
+                p = blanks(p, 2);
+                p = copy_digits(p, d, 4, 7, &leading);
+                *p++ = '.';
+                p = copy_digits(p, d, 7, 10, &leading);
+                *p++ = ' ';
+                p = copy_digits(p, m, 7, 10, &leading);
+                unit = PSTR("kHz");
+        }
+        else
+        {
+                p = blanks(p, 6);
+                p = copy_digits(p, d, 7, 10, &leading);
+                *p++ = '.';
+                p = copy_digits(p, m, 7, 10, &leading);
+                unit = PSTR(" Hz");
+        }
+        while ((*p = pgm_read_byte(unit++)) != '\0')
+        {
+                p++;
+        }
+}
+
+uint32_t FMT_parse_uint(const uint8_t* str)
+{
+        uint32_t v = 0;
+        while (*str && (*str < '0' || *str > '9'))
+        {
+                str++;
+        }
+        while (*str >= '0' && *str <= '9')
+        {
+                v = (v << 3) + (v << 1) + (uint8_t)(*str - '0');
+                str++;
+        }
+        return v;
+}
+
+// Whole Hz from which a frequency is FREQ_LIMIT or more
+#define HZ_LIMIT        ((uint32_t)(FREQ_LIMIT / FREQ_MHZ_PER_HZ))
+
+freq_t FMT_parse_freq(const uint8_t* str, const uint8_t** end)
+{
+        uint32_t hz = 0;
+        uint16_t mhz = 0;
+        uint8_t decimals = 0;
+        while (*str && *str != '.' && (*str < '0' || *str > '9'))
+        {
+                str++;
+        }
+        while (*str >= '0' && *str <= '9')
+        {
+                // Once past the limit the rest are read and dropped, so
+                // hz stays far below 2^32
+                if (hz < HZ_LIMIT)
+                {
+                        hz = (hz << 3) + (hz << 1) + (uint8_t)(*str - '0');
+                }
+                str++;
+        }
+        if (*str == '.')
+        {
+                str++;
+                while (*str >= '0' && *str <= '9')
+                {
+                        if (decimals < 3)
+                        {
+                                mhz = (mhz << 3) + (mhz << 1)
+                                        + (uint8_t)(*str - '0');
+                                decimals++;
+                        }
+                        str++;
+                }
+        }
+        for (; decimals < 3; decimals++)
+        {
+                mhz = (mhz << 3) + (mhz << 1);
+        }
+        if (end)
+        {
+                *end = str;
+        }
+        if (hz >= HZ_LIMIT)
+        {
+                return FREQ_LIMIT;
+        }
+        // hz * 1000 as 1024 - 16 - 8
+        freq_t f = hz;
+        return (f << 10) - (f << 4) - (f << 3) + mhz;
+}
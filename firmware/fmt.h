@@ -0,0 +1,81 @@
+//////////////////////////////////////////////////////////////////////////////
+///
+///  \file fmt.h
+///
+///  \copy copyright (c) 2023 William R Cooke
+///
+///  @brief Division-free decimal formatting and parsing.
+///
+///  Digits come from subtracting powers of ten, at most nine 32 bit
+///  subtractions per digit, and parsing multiplies by ten with two
+///  shifts and an add, so neither pulls in the AVR's software divide or
+///  multiply.  Frequencies are freq_t millihertz, split into whole Hz
+///  and millihertz by a shift and subtract division by 1000.
+///
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef FMT_H
+#define FMT_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include "freq.h"
+
+// Characters FMT_freq() writes, not counting the null
+#define FMT_FREQ_WIDTH     16
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn FMT_uint
+/// @brief Writes v right aligned in width characters, blank padded.
+///        If v has more digits only the lowest width are written.
+/// @param[out] buf    Room for width + 1 characters, null terminated.
+/// @param[in]  width  1 to 10.
+//////////////////////////////////////////////////////////////////////////////
+        void FMT_uint(uint8_t* buf, uint32_t v, uint8_t width);
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn FMT_split_freq
+/// @brief Splits a frequency below FREQ_LIMIT into whole Hz and mHz.
+/// @param[out] mhz  The millihertz left over, 0 to 999, unless NULL.
+/// @return Whole Hz.
+//////////////////////////////////////////////////////////////////////////////
+        uint32_t FMT_split_freq(freq_t f, uint16_t* mhz);
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn FMT_freq
+/// @brief Writes a frequency below 100 MHz in FMT_FREQ_WIDTH characters,
+///        digits grouped in threes and the unit picked to fit.  Below
+///        1 MHz it shows millihertz, above, 10 mHz, finer than the
+///        AD9833's 0.09 Hz step: "10.999 999 99MHz", "   60.000 000kHz",
+///        "      400.000 Hz".
+/// @param[out] buf  Room for FMT_FREQ_WIDTH + 1 characters.
+//////////////////////////////////////////////////////////////////////////////
+        void FMT_freq(uint8_t* buf, freq_t f);
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn FMT_parse_uint
+/// @brief Skips anything before the first digit and reads the digits
+///        from there.  Wraps modulo 2^32 like the C conversions.
+/// @return The value, 0 if there are no digits.
+//////////////////////////////////////////////////////////////////////////////
+        uint32_t FMT_parse_uint(const uint8_t* str);
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn FMT_parse_freq
+/// @brief Reads Hz with up to three decimals, "12.5" or "7040000.125",
+///        skipping anything before the first digit or point.  Decimals
+///        past the third are read and dropped.
+/// @param[out] end  Where reading stopped, unless NULL.
+/// @return The frequency, 0 if there are no digits, FREQ_LIMIT if it is
+///         that or more, however many digits there are.
+//////////////////////////////////////////////////////////////////////////////
+        freq_t FMT_parse_freq(const uint8_t* str, const uint8_t** end);
+
+#ifdef __cplusplus
+}
+#endif  // __cplusplus
+#endif  // #ifndef FMT_H
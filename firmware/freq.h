@@ -0,0 +1,43 @@
+//////////////////////////////////////////////////////////////////////////////
+///
+///  \file freq.h
+///
+///  \copy copyright (c) 2023 William R Cooke
+///
+///  @brief Millihertz fixed-point frequency type.
+///
+///  A freq_t counts millihertz.  The output range needs 34 bits, so it
+///  is 64 bits wide; code working on it adds, subtracts, compares and
+///  multiplies, but never divides, so the AVR's 64 bit divide is never
+///  pulled in.  fmt splits it into whole Hz and millihertz by shift and
+///  subtract, and tuning turns it into a tuning word by a reciprocal.
+///
+///  The hop list, keying, modulation tones and bursts keep whole Hz.
+///
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef FREQ_H
+#define FREQ_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+
+        typedef uint64_t freq_t;
+
+#define FREQ_MHZ_PER_HZ    1000
+
+// Bits a frequency below FREQ_LIMIT needs, 2^34 mHz, about 17 MHz
+#define FREQ_BITS          34
+#define FREQ_LIMIT         ((freq_t)1 << FREQ_BITS)
+
+// Whole Hz to a freq_t
+#define FREQ_HZ(hz)        ((freq_t)(hz) * FREQ_MHZ_PER_HZ)
+
+#ifdef __cplusplus
+}
+#endif  // __cplusplus
+#endif  // #ifndef FREQ_H
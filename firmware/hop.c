@@ -0,0 +1,180 @@
+//////////////////////////////////////////////////////////////////////////////
+///
+///  \file hop.c
+///
+///  \copy copyright (c) 2023 William R Cooke
+///
+///  @brief Frequency-hop list kept in EEPROM and played through ddsq.
+///
+//////////////////////////////////////////////////////////////////////////////
+
+#include <stdint.h>
+#include <avr/eeprom.h>
+#include "tuning.h"
+#include "timer1.h"
+#include "ddsq.h"
+#include "eewrite.h"
+#include "hop.h"
+
+// Time from HOP_start() to the first hop, so it is queued ahead
+#define START_DELAY     TIMER1_CYCLES_PER_MS
+
+static hop_t hop_list[HOP_MAX] EEMEM;
+static hop_t hops[HOP_MAX];     // RAM copy, so playing never waits on EEPROM
+
+static uint8_t  playing;
+static uint8_t  count;          // entries in the list
+static uint8_t  next;           // entry to queue next
+static uint32_t next_at;        // its TIMER1_now() cycle
+static uint16_t seen_done;      // DDSQ_done() last time we looked
+static uint8_t  on_air;         // entry on the output
+static uint8_t  started;        // the first hop has been played
+static uint8_t  once;           // a triggered pass: no wrap to hop 0
+static uint8_t  queued_all;     // once: every hop is queued, done at next_at
+
+void HOP_init(void)
+{
+        eeprom_read_block(hops, hop_list, sizeof(hops));
+}
+
+uint8_t HOP_set(uint8_t i, uint32_t hz, uint16_t dwell_ms)
+{
+        if (i >= HOP_MAX)
+        {
+                return 0;
+        }
+        hop_t hop = { hz, dwell_ms };
+        if (!EEWRITE_queue(&hop_list[i], &hop, sizeof(hop_t)))
+        {
+                return 0;
+        }
+        hops[i] = hop;
+        return 1;
+}
+
+void HOP_get(uint8_t i, hop_t* hop)
+{
+        *hop = hops[i];
+}
+
+// Entries up to the first zero dwell
+static uint8_t length(void)
+{
+        hop_t hop;
+        uint8_t n;
+        for (n = 0; n < HOP_MAX; n++)
+        {
+                HOP_get(n, &hop);
+                // Erased EEPROM reads 0xffff, which also ends the list
+                if (hop.dwell_ms == 0 || hop.dwell_ms == 0xffff)
+                {
+                        break;
+                }
+        }
+        return n;
+}
+
+uint8_t HOP_start(void)
+{
+        HOP_stop();
+        count = length();
+        if (count == 0)
+        {
+                return 0;
+        }
+        next = 0;
+        next_at = TIMER1_now() + START_DELAY;
+        seen_done = DDSQ_done();
+        on_air = count - 1;
+        started = 0;
+        once = 0;
+        queued_all = 0;
+        playing = 1;
+        HOP_service();
+        return count;
+}
+
+uint8_t HOP_trigger(uint32_t at)
+{
+        hop_t hop;
+        HOP_stop();
+        count = length();
+        if (count == 0)
+        {
+                return 0;
+        }
+        HOP_get(0, &hop);
+        next = 1;
+        next_at = at + (uint32_t)hop.dwell_ms * TIMER1_CYCLES_PER_MS;
+        seen_done = DDSQ_done();
+        on_air = 0;
+        started = 1;
+        once = 1;
+        queued_all = count == 1;
+        playing = 1;
+        HOP_service();
+        return count;
+}
+
+uint8_t HOP_count(void)
+{
+        return length();
+}
+
+void HOP_service(void)
+{
+        hop_t hop;
+        while (playing && !queued_all && DDSQ_room())
+        {
+                HOP_get(next, &hop);
+                DDSQ_hop(next_at, TUNING_hz_to_word(hop.hz));
+                next_at += (uint32_t)hop.dwell_ms * TIMER1_CYCLES_PER_MS;
+                if (++next == count)
+                {
+                        next = 0;
+                        queued_all = once;
+                }
+        }
+}
+
+void HOP_stop(void)
+{
+        if (playing)
+        {
+                playing = 0;
+                DDSQ_flush();
+        }
+}
+
+uint8_t HOP_playing(void)
+{
+        // The queue is played out, so the shadows are right as they stand
+        if (playing && queued_all && !DDSQ_pending()
+            && (int32_t)(TIMER1_now() - next_at) >= 0)
+        {
+                playing = 0;
+        }
+        return playing;
+}
+
+uint32_t HOP_current_hz(void)
+{
+        hop_t hop;
+        if (!playing)
+        {
+                return 0;
+        }
+        uint16_t played = DDSQ_done() - seen_done;
+        seen_done += played;
+        while (played--)
+        {
+                on_air = on_air + 1 == count ? 0 : on_air + 1;
+                started = 1;
+        }
+        if (!started)
+        {
+                return 0;
+        }
+        HOP_get(on_air, &hop);
+        return hop.hz;
+}
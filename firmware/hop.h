@@ -0,0 +1,100 @@
+//////////////////////////////////////////////////////////////////////////////
+///
+///  \file hop.h
+///
+///  \copy copyright (c) 2023 William R Cooke
+///
+///  @brief Frequency-hop list kept in EEPROM and played through ddsq.
+///
+///  A list is up to HOP_MAX entries of frequency and dwell time; the first
+///  entry with a zero dwell ends it.  Playing keeps the DDS queue topped
+///  up from run(), so each hop happens on its Timer1 cycle and every dwell
+///  is exact no matter when run() gets round to the next one.
+///
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef HOP_H
+#define HOP_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+
+#define HOP_MAX            16
+
+        typedef struct HOP
+        {
+                uint32_t hz;
+                uint16_t dwell_ms;      // 0 ends the list
+        } hop_t;
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn HOP_init
+/// @brief Loads the list from EEPROM.  Call before queuing EEPROM writes.
+//////////////////////////////////////////////////////////////////////////////
+        void HOP_init(void);
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn HOP_set
+/// @brief Sets entry i of the list and queues it for EEPROM.
+/// @return 1 if stored, 0 if i is out of range or the write queue is full.
+//////////////////////////////////////////////////////////////////////////////
+        uint8_t HOP_set(uint8_t i, uint32_t hz, uint16_t dwell_ms);
+
+        void HOP_get(uint8_t i, hop_t* hop);
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn HOP_start
+/// @brief Starts playing the list in a loop, first hop 1 ms from now.
+/// @return Number of entries, 0 if the list is empty and nothing started.
+//////////////////////////////////////////////////////////////////////////////
+        uint8_t HOP_start(void);
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn HOP_trigger
+/// @brief Plays the list once, as if hop 0 went on the output at cycle at.
+///        The caller has put hop 0 there; the rest follow on their dwells
+///        and the last stays on.  HOP_playing() is 0 once its dwell ends.
+/// @param[in] at  TIMER1_now() cycle hop 0 started.
+/// @return Number of entries, 0 if the list is empty and nothing started.
+//////////////////////////////////////////////////////////////////////////////
+        uint8_t HOP_trigger(uint32_t at);
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn HOP_count
+/// @return Entries in the list, up to the first zero dwell.
+//////////////////////////////////////////////////////////////////////////////
+        uint8_t HOP_count(void);
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn HOP_service
+/// @brief Queues upcoming hops while there is room.  Call every pass.
+//////////////////////////////////////////////////////////////////////////////
+        void HOP_service(void);
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn HOP_stop
+/// @brief Stops and drops hops not yet played.
+//////////////////////////////////////////////////////////////////////////////
+        void HOP_stop(void);
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn HOP_playing
+/// @return 1 while the list plays, 0 once stopped or a triggered pass has
+///         run its last dwell.
+//////////////////////////////////////////////////////////////////////////////
+        uint8_t HOP_playing(void);
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn HOP_current_hz
+/// @return Frequency of the hop now on the output, 0 before the first.
+//////////////////////////////////////////////////////////////////////////////
+        uint32_t HOP_current_hz(void);
+
+#ifdef __cplusplus
+}
+#endif  // __cplusplus
+#endif  // #ifndef HOP_H
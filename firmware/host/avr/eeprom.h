@@ -0,0 +1,33 @@
+//////////////////////////////////////////////////////////////////////////////
+///
+///  \file avr/eeprom.h
+///
+///  \copy copyright (c) 2023 William R Cooke
+///
+///  @brief Host stand-in for avr-libc EEPROM access.
+///
+///  EEPROM variables live in ordinary host memory, gathered in their own
+///  section so the bench can load and save them as an image.  Writes are
+///  charged the 3.4 ms per byte the ATmega8 takes.
+///
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef HOST_AVR_EEPROM_H
+#define HOST_AVR_EEPROM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define EEMEM   __attribute__((section("host_eeprom")))
+
+void eeprom_read_block(void* dst, const void* src, size_t n);
+void eeprom_write_block(const void* src, void* dst, size_t n);
+void eeprom_update_block(const void* src, void* dst, size_t n);
+uint8_t eeprom_read_byte(const uint8_t* p);
+uint16_t eeprom_read_word(const uint16_t* p);
+uint32_t eeprom_read_dword(const uint32_t* p);
+void eeprom_write_byte(uint8_t* p, uint8_t value);
+void eeprom_write_word(uint16_t* p, uint16_t value);
+void eeprom_write_dword(uint32_t* p, uint32_t value);
+
+#endif  // #ifndef HOST_AVR_EEPROM_H
@@ -0,0 +1,26 @@
+//////////////////////////////////////////////////////////////////////////////
+///
+///  \file avr/interrupt.h
+///
+///  \copy copyright (c) 2023 William R Cooke
+///
+///  @brief Host stand-in for avr-libc interrupt control.
+///
+///  cli()/sei() are tracked so the harness can measure how long interrupts
+///  stay masked.  An ISR becomes an ordinary function named after its
+///  vector that the harness calls when the interrupt would fire.
+///
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef HOST_AVR_INTERRUPT_H
+#define HOST_AVR_INTERRUPT_H
+
+#include <avr/io.h>
+#include "host.h"
+
+#define cli()   host_cli()
+#define sei()   host_sei()
+
+#define ISR(vector, ...)   void vector(void); void vector(void)
+
+#endif  // #ifndef HOST_AVR_INTERRUPT_H
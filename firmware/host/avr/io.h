@@ -0,0 +1,194 @@
+//////////////////////////////////////////////////////////////////////////////
+///
+///  \file avr/io.h
+///
+///  \copy copyright (c) 2023 William R Cooke
+///
+///  @brief Host stand-in for the ATmega8 I/O registers.
+///
+///  Registers are plain variables defined in hal.c.  A register whose
+///  access starts hardware activity is a macro around a hal.c function.
+///
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef HOST_AVR_IO_H
+#define HOST_AVR_IO_H
+
+#include <stdint.h>
+
+#define _BV(bit)   (1 << (bit))
+
+extern volatile uint8_t DDRB;
+extern volatile uint8_t DDRC;
+extern volatile uint8_t DDRD;
+extern volatile uint8_t PORTB;
+extern volatile uint8_t PORTC;
+extern volatile uint8_t PORTD;
+extern volatile uint8_t PINB;
+extern volatile uint8_t PINC;
+extern volatile uint8_t PIND;
+
+#define PB0     0
+#define PB1     1
+#define PB2     2
+#define PB3     3
+#define PB4     4
+#define PB5     5
+#define PB6     6
+#define PB7     7
+#define PC0     0
+#define PC1     1
+#define PC2     2
+#define PC3     3
+#define PC4     4
+#define PC5     5
+#define PC6     6
+#define PD0     0
+#define PD1     1
+#define PD2     2
+#define PD3     3
+#define PD4     4
+#define PD5     5
+#define PD6     6
+#define PD7     7
+
+// External interrupts
+extern volatile uint8_t MCUCR;
+extern volatile uint8_t GICR;
+extern volatile uint8_t GIFR;
+
+#define ISC00   0
+#define ISC01   1
+#define ISC10   2
+#define ISC11   3
+#define INT0    6
+#define INT1    7
+#define INTF0   6
+#define INTF1   7
+
+// Timers.  TCNT1 is read through hal.c, which derives it from the cycle
+// count; the firmware treats Timer1 as free-running and never writes it.
+extern volatile uint8_t TIMSK;
+extern volatile uint8_t TIFR;
+extern volatile uint8_t TCCR1A;
+extern volatile uint8_t TCCR1B;
+extern volatile uint16_t OCR1A;
+extern volatile uint16_t OCR1B;
+extern volatile uint16_t ICR1;
+volatile uint16_t* host_tcnt1(void);
+#define TCNT1   (*host_tcnt1())
+
+// Timer2 is modelled in CTC mode only, counting from TCNT2 as written
+// when its clock is selected
+extern volatile uint8_t TCCR2;
+extern volatile uint8_t TCNT2;
+extern volatile uint8_t OCR2;
+
+#define OCIE2   7
+#define TOIE2   6
+#define TICIE1  5
+#define OCIE1A  4
+#define OCIE1B  3
+#define TOIE1   2
+#define TOIE0   0
+#define OCF2    7
+#define TOV2    6
+#define ICF1    5
+#define OCF1A   4
+#define OCF1B   3
+#define TOV1    2
+#define TOV0    0
+#define COM1A1  7
+#define COM1A0  6
+#define COM1B1  5
+#define COM1B0  4
+#define FOC1A   3
+#define FOC1B   2
+#define WGM11   1
+#define WGM10   0
+#define ICNC1   7
+#define ICES1   6
+#define WGM13   4
+#define WGM12   3
+#define CS12    2
+#define CS11    1
+#define CS10    0
+#define FOC2    7
+#define WGM20   6
+#define COM21   5
+#define COM20   4
+#define WGM21   3
+#define CS22    2
+#define CS21    1
+#define CS20    0
+
+// EEPROM.  EEAR is pointer wide so it can hold the host address of an
+// EEMEM variable; EECR and EEDR go through hal.c, which starts reads and
+// 3.4 ms byte writes as the strobe bits are set.
+extern volatile uintptr_t EEAR;
+volatile uint8_t* host_eecr(void);
+volatile uint8_t* host_eedr(void);
+#define EECR    (*host_eecr())
+#define EEDR    (*host_eedr())
+
+#define EERIE   3
+#define EEMWE   2
+#define EEWE    1
+#define EERE    0
+
+// USART.  UDR is wider than the real register so hal.c can tell a
+// write from a read; the low 8 bits are the data.
+extern volatile uint8_t UCSRA;
+extern volatile uint8_t UCSRB;
+extern volatile uint8_t UCSRC;
+extern volatile uint8_t UBRRH;
+extern volatile uint8_t UBRRL;
+volatile uint16_t* host_udr(void);
+#define UDR     (*host_udr())
+
+#define RXC     7
+#define TXC     6
+#define UDRE    5
+#define FE      4
+#define DOR     3
+#define PE      2
+#define U2X     1
+#define MPCM    0
+#define RXCIE   7
+#define TXCIE   6
+#define UDRIE   5
+#define RXEN    4
+#define TXEN    3
+#define UCSZ2   2
+#define RXB8    1
+#define TXB8    0
+#define URSEL   7
+#define UMSEL   6
+#define UPM1    5
+#define UPM0    4
+#define USBS    3
+#define UCSZ1   2
+#define UCSZ0   1
+#define UCPOL   0
+
+// SPI
+extern volatile uint8_t SPCR;
+// SPSR goes through hal.c so a loop polling SPIF moves the clock on
+volatile uint8_t* host_spsr(void);
+volatile uint8_t* host_spdr(void);
+#define SPSR    (*host_spsr())
+#define SPDR    (*host_spdr())
+
+#define SPIE    7
+#define SPE     6
+#define DORD    5
+#define MSTR    4
+#define CPOL    3
+#define CPHA    2
+#define SPR1    1
+#define SPR0    0
+#define SPIF    7
+#define WCOL    6
+#define SPI2X   0
+
+#endif  // #ifndef HOST_AVR_IO_H
@@ -0,0 +1,35 @@
+//////////////////////////////////////////////////////////////////////////////
+///
+///  \file avr/pgmspace.h
+///
+///  \copy copyright (c) 2023 William R Cooke
+///
+///  @brief Host stand-in for avr-libc program memory access.
+///
+///  The host has one address space, so flash tables and PSTR() strings
+///  are ordinary const data and a flash read is a load.  Each read is charged the LPM cost.
+///
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef HOST_AVR_PGMSPACE_H
+#define HOST_AVR_PGMSPACE_H
+
+#include <stdint.h>
+#include <string.h>
+#include "host.h"
+
+#define PROGMEM
+
+#define PSTR(s)         (s)
+
+#define pgm_read_byte(addr) \
+        (host_charge(HOST_COST_FLASH_READ), *(const uint8_t*)(addr))
+
+#define pgm_read_dword(addr) \
+        (host_charge(4 * HOST_COST_FLASH_READ), *(const uint32_t*)(addr))
+
+#define strcpy_P(dst, src) \
+        (host_charge((strlen(src) + 1) * HOST_COST_FLASH_READ), \
+         strcpy((dst), (src)))
+
+#endif  // #ifndef HOST_AVR_PGMSPACE_H
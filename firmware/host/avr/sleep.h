@@ -0,0 +1,37 @@
+//////////////////////////////////////////////////////////////////////////////
+///
+///  \file avr/sleep.h
+///
+///  \copy copyright (c) 2023 William R Cooke
+///
+///  @brief Host stand-in for avr-libc sleep control.
+///
+///  sleep_cpu() lets the simulated clock run to the next interrupt, or to
+///  the next millisecond, where the SYSTICK timer would wake the CPU.
+///  Cycles spent asleep are counted in host_stats.sleep_cycles.
+///
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef HOST_AVR_SLEEP_H
+#define HOST_AVR_SLEEP_H
+
+#include <stdint.h>
+#include "host.h"
+
+#define SLEEP_MODE_IDLE           0
+#define SLEEP_MODE_ADC            1
+#define SLEEP_MODE_PWR_DOWN       2
+#define SLEEP_MODE_PWR_SAVE       3
+#define SLEEP_MODE_STANDBY        6
+
+extern volatile uint8_t host_sleep_mode;
+extern volatile uint8_t host_sleep_enabled;
+
+#define set_sleep_mode(mode)   (host_sleep_mode = (mode))
+#define sleep_enable()         (host_sleep_enabled = 1)
+#define sleep_disable()        (host_sleep_enabled = 0)
+#define sleep_cpu()            host_sleep()
+#define sleep_mode()           do { sleep_enable(); sleep_cpu();      \
+                                    sleep_disable(); } while (0)
+
+#endif  // #ifndef HOST_AVR_SLEEP_H
@@ -0,0 +1,630 @@
+//////////////////////////////////////////////////////////////////////////////
+///
+///  \file bench.c
+///
+///  \copy copyright (c) 2023 William R Cooke
+///
+///  @brief Runs the firmware on the host and reports what the loop costs.
+///
+///  Usage: softrock33_host [-m ms] [-w ms] [-s script] [-t spi.txt]
+///                         [-l lcd.txt] [-u uart.txt] [-e eeprom.bin] [-p]
+///                         [-x max_missed]
+///
+///  -m  simulated run time, default 12000 ms
+///  -w  start measuring at this time, default 2500 ms (after the splash)
+///  -s  input script, one event per line:
+///          <ms> key <chars>          press keypad keys, one per ms
+///          <ms> button [n]           press button n (default 0)
+///          <ms> enc <detents>        turn the encoder
+///          <ms> spin <detents> <n>   turn the encoder every ms for n ms
+///          <ms> uart <text>          send text to the serial port; C
+///                                    escapes \r \n \\ and \xHH work
+///          <ms> trig [us]            10 us pulse on the trigger input,
+///                                    rising us into the ms (default 0)
+///      '#' starts a comment.  Without -s a built-in scenario is used,
+///      unless -p is given.
+///  -t  write every SPI word as "<cycle> <iface> <word>" to a file
+///  -l  write every LCD write as "<cycle> <op> <x> <y> <value>" to a file
+///  -u  write everything the firmware sends on the serial port to a file
+///  -e  EEPROM image, read at power-up if it exists and written back at
+///      the end, so runs follow each other like power cycles.  Without
+///      it the EEPROM starts erased.
+///  -p  connect the serial port to a new pseudo terminal, whose name is
+///      printed, and run in real time so a terminal or script can talk
+///      to the firmware
+///  -x  exit with status 1 if more than this many ticks were missed
+///
+//////////////////////////////////////////////////////////////////////////////
+
+#define _DEFAULT_SOURCE
+#define _XOPEN_SOURCE 600
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "host.h"
+#include "ddsq.h"
+#include "keyer.h"
+#include "input.h"
+#include "trig.h"
+#include "mod.h"
+#include "burst.h"
+#include "sched.h"
+#include "prof.h"
+
+int firmware_main(int argc, char** argv);
+
+typedef enum EVENT_TYPE
+{
+        EVENT_KEY,
+        EVENT_BUTTON,
+        EVENT_ENCODER,
+        EVENT_UART,
+        EVENT_TRIGGER
+} EventType_t;
+
+typedef struct EVENT
+{
+        uint32_t    ms;
+        EventType_t type;
+        int32_t     value;
+        char*       text;          // EVENT_UART bytes, value is the length
+} event_t;
+
+static event_t* events;
+static size_t n_events;
+static size_t cap_events;
+static size_t next_event;
+
+static uint32_t warmup_ms = 2500;
+static host_stats_t at_warmup;
+static uint32_t mod_since_ms;          // tick modulation was last started
+static uint64_t warmup_cycles;
+static uint32_t start_ms;
+
+static FILE* spi_file;
+static FILE* lcd_file;
+static FILE* uart_file;
+static int pty_fd = -1;
+static struct timespec pty_start;
+
+static const char* default_script[] =
+{
+        "3000 spin 1 2000",            // tune up one detent per ms
+        "5000 spin -3 1000",           // and back down faster
+        "6500 key 7040000#",           // direct keypad entry
+        "7000 key *",                  // MODE: into the sweep setup
+        "7100 key 1000000#",
+        "7200 key 2000000#",
+        "7300 key 5#",
+        "8000 key s3",                 // store in slot 3
+        "9000 key *",                  // back to TRACK
+        "9500 spin 10 500",
+        "10500 key r3",                // recall slot 3
+        "11000 uart ?\\r",             // serial status query
+        "11200 uart H 0 1000000 2\\rH 1 1500000 3\\rG\\r",  // hop list
+        NULL
+};
+
+static void add_event(uint32_t ms, EventType_t type, int32_t value,
+                      char* text)
+{
+        if (n_events == cap_events)
+        {
+                cap_events = cap_events ? cap_events * 2 : 64;
+                events = realloc(events, cap_events * sizeof(event_t));
+                if (!events)
+                {
+                        perror("realloc");
+                        exit(2);
+                }
+        }
+        events[n_events].ms = ms;
+        events[n_events].type = type;
+        events[n_events].value = value;
+        events[n_events].text = text;
+        n_events++;
+}
+
+// Copies the text after "<ms> uart " with C escapes resolved
+static char* parse_text(const char* p, int32_t* len)
+{
+        char* out = malloc(strlen(p) + 1);
+        int32_t n = 0;
+        if (!out)
+        {
+                perror("malloc");
+                exit(2);
+        }
+        while (*p && *p != '\n')
+        {
+                if (*p != '\\' || !p[1])
+                {
+                        out[n++] = *p++;
+                        continue;
+                }
+                p++;
+                switch (*p)
+                {
+                case 'r':
+                        out[n++] = '\r';
+                        p++;
+                        break;
+                case 'n':
+                        out[n++] = '\n';
+                        p++;
+                        break;
+                case 'x':
+                        out[n++] = (char)strtoul(p + 1, (char**)&p, 16);
+                        break;
+                default:
+                        out[n++] = *p++;
+                        break;
+                }
+        }
+        *len = n;
+        return out;
+}
+
+static int parse_line(const char* line, int lineno)
+{
+        char cmd[16];
+        char arg[64];
+        unsigned ms;
+        int a;
+        int n;
+
+        while (*line == ' ' || *line == '\t')
+        {
+                line++;
+        }
+        if (*line == '\0' || *line == '\n' || *line == '#')
+        {
+                return 0;
+        }
+        if (sscanf(line, "%u %15s", &ms, cmd) != 2)
+        {
+                fprintf(stderr, "script line %d: expected <ms> <command>\n",
+                        lineno);
+                return -1;
+        }
+        if (strcmp(cmd, "key") == 0 && sscanf(line, "%*u %*s %63s", arg) == 1)
+        {
+                for (int i = 0; arg[i]; i++)
+                {
+                        add_event(ms + i, EVENT_KEY, arg[i], NULL);
+                }
+        }
+        else if (strcmp(cmd, "button") == 0)
+        {
+                if (sscanf(line, "%*u %*s %d", &a) != 1)
+                {
+                        a = 0;
+                }
+                add_event(ms, EVENT_BUTTON, a, NULL);
+        }
+        else if (strcmp(cmd, "enc") == 0
+                 && sscanf(line, "%*u %*s %d", &a) == 1)
+        {
+                add_event(ms, EVENT_ENCODER, a, NULL);
+        }
+        else if (strcmp(cmd, "uart") == 0)
+        {
+                int pos = 0;
+                int32_t len;
+                sscanf(line, "%*u %*s %n", &pos);
+                char* text = parse_text(line + pos, &len);
+                add_event(ms, EVENT_UART, len, text);
+        }
+        else if (strcmp(cmd, "trig") == 0)
+        {
+                if (sscanf(line, "%*u %*s %d", &a) != 1 || a < 0 || a > 999)
+                {
+                        a = 0;
+                }
+                add_event(ms, EVENT_TRIGGER, a, NULL);
+        }
+        else if (strcmp(cmd, "spin") == 0
+                 && sscanf(line, "%*u %*s %d %d", &a, &n) == 2)
+        {
+                for (int i = 0; i < n; i++)
+                {
+                        add_event(ms + i, EVENT_ENCODER, a, NULL);
+                }
+        }
+        else
+        {
+                fprintf(stderr, "script line %d: bad command '%s'\n",
+                        lineno, cmd);
+                return -1;
+        }
+        return 0;
+}
+
+static int by_time(const void* a, const void* b)
+{
+        const event_t* ea = a;
+        const event_t* eb = b;
+        if (ea->ms != eb->ms)
+        {
+                return ea->ms < eb->ms ? -1 : 1;
+        }
+        return ea < eb ? -1 : 1;
+}
+
+// Passes terminal input to the USART and holds the simulation to real time
+static void serve_pty(uint32_t ms)
+{
+        uint8_t buf[256];
+        ssize_t n;
+        if (host_uart_pending() < sizeof(buf)
+            && (n = read(pty_fd, buf, sizeof(buf))) > 0)
+        {
+                host_uart_input(buf, (size_t)n);
+        }
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        int64_t ahead_us = (int64_t)ms * 1000
+                - ((int64_t)(now.tv_sec - pty_start.tv_sec) * 1000000
+                   + (now.tv_nsec - pty_start.tv_nsec) / 1000);
+        if (ahead_us > 0)
+        {
+                usleep((useconds_t)ahead_us);
+        }
+}
+
+static int open_pty(void)
+{
+        int fd = posix_openpt(O_RDWR | O_NOCTTY);
+        if (fd < 0 || grantpt(fd) < 0 || unlockpt(fd) < 0)
+        {
+                perror("pty");
+                return -1;
+        }
+        // Raw mode, so the firmware sees bytes exactly as sent
+        int slave = open(ptsname(fd), O_RDWR | O_NOCTTY);
+        struct termios tio;
+        if (slave >= 0 && tcgetattr(slave, &tio) == 0)
+        {
+                cfmakeraw(&tio);
+                tcsetattr(slave, TCSANOW, &tio);
+        }
+        // The slave stays open so the master never sees a hangup when a
+        // client disconnects
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+        printf("serial port: %s\n", ptsname(fd));
+        fflush(stdout);
+        return fd;
+}
+
+static void on_tick(uint32_t ms)
+{
+        if (!MOD_running())
+        {
+                mod_since_ms = ms;
+        }
+        if (ms == warmup_ms)
+        {
+                at_warmup = host_stats;
+                warmup_cycles = host_cycles();
+                start_ms = ms;
+        }
+        while (next_event < n_events && events[next_event].ms <= ms)
+        {
+                const event_t* e = &events[next_event++];
+                switch (e->type)
+                {
+                case EVENT_KEY:
+                        host_press_key((char)e->value);
+                        break;
+                case EVENT_BUTTON:
+                        host_press_button(e->value);
+                        break;
+                case EVENT_ENCODER:
+                        host_turn_encoder(e->value);
+                        break;
+                case EVENT_UART:
+                        host_uart_input((const uint8_t*)e->text,
+                                        (size_t)e->value);
+                        break;
+                case EVENT_TRIGGER:
+                        host_trigger((uint32_t)e->value * (HOST_F_CPU / 1000000),
+                                     10 * (HOST_F_CPU / 1000000));
+                        break;
+                }
+        }
+        if (pty_fd >= 0)
+        {
+                serve_pty(ms);
+        }
+}
+
+static void write_spi(const host_spi_record_t* rec)
+{
+        fprintf(spi_file, "%llu %u %04x\n", (unsigned long long)rec->cycle,
+                rec->iface, rec->word);
+}
+
+static void write_lcd(const host_lcd_record_t* rec)
+{
+        static const char* ops[] = { "clear", "goto", "data", "cmd" };
+        fprintf(lcd_file, "%llu %s %u %u %02x\n",
+                (unsigned long long)rec->cycle, ops[rec->op], rec->x, rec->y,
+                rec->value);
+}
+
+static void write_uart(uint8_t ch)
+{
+        if (uart_file)
+        {
+                fputc(ch, uart_file);
+        }
+        if (pty_fd >= 0 && write(pty_fd, &ch, 1) < 0)
+        {
+                // Nobody is reading; the byte is gone, as on the wire
+        }
+}
+
+static double per(uint64_t n, uint64_t d)
+{
+        return d ? (double)n / (double)d : 0.0;
+}
+
+int main(int argc, char** argv)
+{
+        uint32_t run_ms = 12000;
+        long max_missed = -1;
+        const char* script = NULL;
+        const char* eeprom_file = NULL;
+        size_t eeprom_size;
+        uint8_t* eeprom = host_eeprom(&eeprom_size);
+        int opt;
+
+        while ((opt = getopt(argc, argv, "m:w:s:t:l:u:e:px:")) != -1)
+        {
+                switch (opt)
+                {
+                case 'm':
+                        run_ms = (uint32_t)strtoul(optarg, NULL, 0);
+                        break;
+                case 'w':
+                        warmup_ms = (uint32_t)strtoul(optarg, NULL, 0);
+                        break;
+                case 's':
+                        script = optarg;
+                        break;
+                case 't':
+                        spi_file = fopen(optarg, "w");
+                        if (!spi_file)
+                        {
+                                perror(optarg);
+                                return 2;
+                        }
+                        host_trace_spi(write_spi);
+                        break;
+                case 'l':
+                        lcd_file = fopen(optarg, "w");
+                        if (!lcd_file)
+                        {
+                                perror(optarg);
+                                return 2;
+                        }
+                        host_trace_lcd(write_lcd);
+                        break;
+                case 'u':
+                        uart_file = fopen(optarg, "w");
+                        if (!uart_file)
+                        {
+                                perror(optarg);
+                                return 2;
+                        }
+                        host_trace_uart(write_uart);
+                        break;
+                case 'e':
+                        eeprom_file = optarg;
+                        break;
+                case 'p':
+                        pty_fd = open_pty();
+                        if (pty_fd < 0)
+                        {
+                                return 2;
+                        }
+                        host_trace_uart(write_uart);
+                        break;
+                case 'x':
+                        max_missed = strtol(optarg, NULL, 0);
+                        break;
+                default:
+                        fprintf(stderr, "usage: %s [-m ms] [-w ms] [-s script]"
+                                " [-t spi.txt] [-l lcd.txt] [-u uart.txt]"
+                                " [-e eeprom.bin] [-p] [-x max_missed]\n",
+                                argv[0]);
+                        return 2;
+                }
+        }
+        if (warmup_ms >= run_ms)
+        {
+                warmup_ms = 0;
+        }
+
+        if (script)
+        {
+                FILE* f = fopen(script, "r");
+                char* line = NULL;
+                size_t size = 0;
+                int lineno = 0;
+                if (!f)
+                {
+                        perror(script);
+                        return 2;
+                }
+                // Lines are unlimited; a uart line may carry a long stream
+                while (getline(&line, &size, f) >= 0)
+                {
+                        if (parse_line(line, ++lineno) < 0)
+                        {
+                                free(line);
+                                fclose(f);
+                                return 2;
+                        }
+                }
+                free(line);
+                fclose(f);
+        }
+        else if (pty_fd < 0)
+        {
+                for (int i = 0; default_script[i]; i++)
+                {
+                        parse_line(default_script[i], i + 1);
+                }
+        }
+        qsort(events, n_events, sizeof(event_t), by_time);
+
+        memset(eeprom, 0xff, eeprom_size);
+        if (eeprom_file)
+        {
+                FILE* f = fopen(eeprom_file, "rb");
+                if (f)
+                {
+                        if (fread(eeprom, 1, eeprom_size, f) != eeprom_size)
+                        {
+                                fprintf(stderr, "%s: short image, rest erased\n",
+                                        eeprom_file);
+                        }
+                        fclose(f);
+                }
+        }
+
+        struct timespec t0;
+        struct timespec t1;
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        pty_start = t0;
+        host_run(firmware_main, run_ms, on_tick);
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+
+        host_stats_t s = host_stats;
+        uint64_t cycles = host_cycles() - warmup_cycles;
+        uint32_t ms = host_milliseconds() - start_ms;
+        uint64_t passes = s.passes - at_warmup.passes;
+        uint64_t missed = s.missed_ticks - at_warmup.missed_ticks;
+        uint64_t idle = s.idle_cycles - at_warmup.idle_cycles;
+        uint64_t asleep = s.sleep_cycles - at_warmup.sleep_cycles;
+        double host_ns = (t1.tv_sec - t0.tv_sec) * 1e9
+                + (t1.tv_nsec - t0.tv_nsec);
+
+        printf("SoftRock33 host bench: %u ms measured (from %u ms)\n",
+               ms, start_ms);
+        printf("  loop passes        : %llu (%.3f per ms)\n",
+               (unsigned long long)passes, per(passes, ms));
+        printf("  missed ticks       : %llu\n", (unsigned long long)missed);
+        printf("  busy cycles / pass : %.0f (load %.1f %%)\n",
+               per(cycles - idle - asleep, passes),
+               100.0 * per(cycles - idle - asleep, cycles));
+        printf("  asleep             : %.1f %%\n", 100.0 * per(asleep, cycles));
+        printf("  scheduler overruns : %u passes cut short\n",
+               SCHED_tick_overruns());
+        printf("  SPI words          : %llu (%.2f per pass)\n",
+               (unsigned long long)(s.spi_words - at_warmup.spi_words),
+               per(s.spi_words - at_warmup.spi_words, passes));
+        printf("  LCD writes         : %llu (%.2f per pass)\n",
+               (unsigned long long)(s.lcd_writes - at_warmup.lcd_writes),
+               per(s.lcd_writes - at_warmup.lcd_writes, passes));
+        printf("  UART bytes         : %llu in, %llu out, %llu overruns\n",
+               (unsigned long long)(s.uart_rx_bytes - at_warmup.uart_rx_bytes),
+               (unsigned long long)(s.uart_tx_bytes - at_warmup.uart_tx_bytes),
+               (unsigned long long)(s.uart_overruns
+                                    - at_warmup.uart_overruns));
+        printf("  input events       : %llu, %llu dropped, queue peak %u\n",
+               (unsigned long long)s.input_events,
+               (unsigned long long)s.input_dropped, INPUT_peak());
+        printf("  EEPROM bytes       : %llu\n",
+               (unsigned long long)(s.eeprom_bytes_written
+                                    - at_warmup.eeprom_bytes_written));
+        printf("  DDS output         : %.2f ms after reset\n",
+               per(s.dds_on_cycle, HOST_CYCLES_PER_MS));
+        printf("  DDS queue          : %u ops played, latest %u cycles\n",
+               DDSQ_done(), DDSQ_late());
+        if (KEYER_running())
+        {
+                printf("  keyer              : %u symbols, latest %u cycles\n",
+                       KEYER_symbols(), KEYER_late());
+        }
+        if (TRIG_edges() || TRIG_pulses())
+        {
+                printf("  trigger            : %u edges, worst %u cycles"
+                       " to SPI, %u sync pulses\n",
+                       TRIG_edges(), TRIG_latency(), TRIG_pulses());
+        }
+        if (MOD_running())
+        {
+                uint32_t ms = host_milliseconds() - mod_since_ms;
+                printf("  modulation         : %u updates/s asked, %.0f"
+                       " made, worst %u cycles\n",
+                       MOD_rate(), per((uint64_t)MOD_updates() * 1000, ms),
+                       MOD_worst());
+        }
+        if (BURST_bursts() || BURST_skipped())
+        {
+                printf("  bursts             : %u queued, %u skipped\n",
+                       BURST_bursts(), BURST_skipped());
+        }
+        printf("  interrupts masked  : %.1f %%, longest %llu cycles\n",
+               100.0 * per(s.masked_cycles - at_warmup.masked_cycles, cycles),
+               (unsigned long long)s.max_masked);
+#if PROF_ENABLE
+        printf("  cycles             :   calls      min      avg      max\n");
+        for (int i = 0; i < PROF_COUNT; i++)
+        {
+                prof_stat_t st;
+                PROF_get((ProfId_t)i, &st);
+                printf("    %s          : %7u %8u %8u %8u\n",
+                       PROF_name((ProfId_t)i), st.count, st.min, st.avg,
+                       st.max);
+        }
+#endif
+        printf("  host run time      : %.1f ms\n", host_ns / 1e6);
+        printf("  display            : |%s|\n", host_lcd[0]);
+        printf("                       |%s|\n", host_lcd[1]);
+
+        if (eeprom_file)
+        {
+                FILE* f = fopen(eeprom_file, "wb");
+                if (!f || fwrite(eeprom, 1, eeprom_size, f) != eeprom_size)
+                {
+                        perror(eeprom_file);
+                }
+                if (f)
+                {
+                        fclose(f);
+                }
+        }
+        if (spi_file)
+        {
+                fclose(spi_file);
+        }
+        if (lcd_file)
+        {
+                fclose(lcd_file);
+        }
+        if (uart_file)
+        {
+                fclose(uart_file);
+        }
+        for (size_t i = 0; i < n_events; i++)
+        {
+                free(events[i].text);
+        }
+        free(events);
+        if (max_missed >= 0 && missed > (uint64_t)max_missed)
+        {
+                fprintf(stderr, "FAIL: %llu missed ticks, limit %ld\n",
+                        (unsigned long long)missed, max_missed);
+                return 1;
+        }
+        return 0;
+}
@@ -0,0 +1,20 @@
+//////////////////////////////////////////////////////////////////////////////
+///
+///  \file button.h
+///
+///  \copy copyright (c) 2023 William R Cooke
+///
+///  @brief Host stand-in for avrlib BUTTON.
+///
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef HOST_BUTTON_H
+#define HOST_BUTTON_H
+
+#include <stdint.h>
+
+void BUTTON_init(void);
+int BUTTON_waiting(void);
+int BUTTON_get_button(void);
+
+#endif  // #ifndef HOST_BUTTON_H
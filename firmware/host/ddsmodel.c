@@ -0,0 +1,227 @@
+//////////////////////////////////////////////////////////////////////////////
+///
+///  \file ddsmodel.c
+///
+///  \copy copyright (c) 2023 William R Cooke
+///
+///  @brief AD9833 signal path model, one output sample per MCLK cycle.
+///
+//////////////////////////////////////////////////////////////////////////////
+
+#include <math.h>
+#include <string.h>
+#include "ddsmodel.h"
+
+// Control word bits, datasheet names
+#define B28             (1u << 13)
+#define HLB             (1u << 12)
+#define FSELECT         (1u << 11)
+#define PSELECT         (1u << 10)
+#define RESET           (1u << 8)
+#define SLEEP1          (1u << 7)
+#define SLEEP12         (1u << 6)
+#define OPBITEN         (1u << 5)
+#define DIV2            (1u << 3)
+#define MODE            (1u << 1)
+
+#define HALF_MASK       0x3fffu
+#define WORD_MASK       0x0fffffffu
+#define ACC_MASK        0x1fffffffu     // 28 bits and the MSB / 2 state
+
+#define LANES           8
+
+typedef uint32_t v8u32 __attribute__((vector_size(4 * LANES)));
+typedef uint16_t v8u16 __attribute__((vector_size(2 * LANES)));
+
+typedef enum SHAPE
+{
+        SHAPE_SINE,
+        SHAPE_RAMP,
+        SHAPE_MSB,
+        SHAPE_MSB_2,
+        SHAPE_OFF
+} Shape_t;
+
+static uint16_t rom[4096];
+
+static void make_rom(void)
+{
+        if (rom[1024])
+        {
+                return;
+        }
+        for (int i = 0; i < 4096; i++)
+        {
+                double s = sin(2 * M_PI * i / 4096);
+                rom[i] = (uint16_t)floor(511.5 + 511.5 * s + 0.5);
+        }
+}
+
+void ddsmodel_init(ddsmodel_t* m)
+{
+        make_rom();
+        memset(m, 0, sizeof(*m));
+        m->control = RESET;
+}
+
+void ddsmodel_write(ddsmodel_t* m, uint16_t word)
+{
+        uint16_t data = word & HALF_MASK;
+        m->words++;
+        switch (word >> 14)
+        {
+        case 0:
+                m->control = data;
+                if (!(data & B28))
+                {
+                        m->b28_lsb = 0;
+                }
+                break;
+        case 1:
+        case 2:
+        {
+                uint8_t r = (word >> 14) - 1;
+                uint32_t f = m->freq[r];
+                if (m->control & B28)
+                {
+                        // LSBs first, both halves land on the second
+                        if (!m->b28_lsb || m->b28_reg != r)
+                        {
+                                m->b28_lsb = 1;
+                                m->b28_reg = r;
+                                m->b28_half = data;
+                                break;
+                        }
+                        m->b28_lsb = 0;
+                        f = (uint32_t)data << 14 | m->b28_half;
+                }
+                else if (m->control & HLB)
+                {
+                        f = (f & HALF_MASK) | (uint32_t)data << 14;
+                }
+                else
+                {
+                        f = (f & ~HALF_MASK) | data;
+                }
+                m->freq[r] = f & WORD_MASK;
+                break;
+        }
+        case 3:
+                // D13 picks the register, D12 is don't care
+                m->phase[(word >> 13) & 1] = word & 0x0fff;
+                break;
+        }
+}
+
+static Shape_t shape_of(uint16_t c)
+{
+        if (c & OPBITEN)
+        {
+                return (c & DIV2) ? SHAPE_MSB : SHAPE_MSB_2;
+        }
+        if (c & SLEEP12)
+        {
+                return SHAPE_OFF;
+        }
+        return (c & MODE) ? SHAPE_RAMP : SHAPE_SINE;
+}
+
+// DAC codes for eight accumulator values, phase already added
+static inline __attribute__((always_inline))
+v8u32 shape8(v8u32 p, Shape_t s)
+{
+        v8u32 idx = (p >> 16) & 0x0fff;
+        v8u32 v;
+        switch (s)
+        {
+        case SHAPE_SINE:
+                for (int j = 0; j < LANES; j++)
+                {
+                        v[j] = rom[idx[j]];
+                }
+                return v;
+        case SHAPE_RAMP:
+                // Up the first half of the cycle, down the second
+                return (idx ^ (-(idx >> 11) & 0x0fff)) >> 1;
+        case SHAPE_MSB:
+                return ((p >> 27) & 1) * DDSMODEL_FULL_SCALE;
+        case SHAPE_MSB_2:
+                return ((p >> 28) & 1) * DDSMODEL_FULL_SCALE;
+        default:
+                return p & 0;
+        }
+}
+
+static inline __attribute__((always_inline))
+void render(uint32_t acc, uint32_t step, uint32_t off, Shape_t s,
+            uint16_t* out, size_t n)
+{
+        v8u32 a;
+        for (int j = 0; j < LANES; j++)
+        {
+                a[j] = acc + (uint32_t)j * step;
+        }
+        const uint32_t stride = step * LANES;
+        size_t i = 0;
+        for (; i + LANES <= n; i += LANES)
+        {
+                v8u16 v = __builtin_convertvector(
+                        shape8((a + off) & ACC_MASK, s), v8u16);
+                memcpy(out + i, &v, sizeof(v));
+                a += stride;
+        }
+        if (i < n)
+        {
+                v8u32 v = shape8((a + off) & ACC_MASK, s);
+                for (int j = 0; i < n; i++, j++)
+                {
+                        out[i] = (uint16_t)v[j];
+                }
+        }
+}
+
+void ddsmodel_render(ddsmodel_t* m, uint16_t* out, size_t n)
+{
+        uint16_t c = m->control;
+        uint32_t step = m->freq[(c & FSELECT) != 0];
+        uint32_t off = (uint32_t)m->phase[(c & PSELECT) != 0] << 16;
+        if (c & RESET)
+        {
+                m->acc = 0;
+        }
+        if (c & (RESET | SLEEP1))
+        {
+                step = 0;
+        }
+        // One loop per shape, so the choice is made once
+        switch (shape_of(c))
+        {
+        case SHAPE_SINE:
+                render(m->acc, step, off, SHAPE_SINE, out, n);
+                break;
+        case SHAPE_RAMP:
+                render(m->acc, step, off, SHAPE_RAMP, out, n);
+                break;
+        case SHAPE_MSB:
+                render(m->acc, step, off, SHAPE_MSB, out, n);
+                break;
+        case SHAPE_MSB_2:
+                render(m->acc, step, off, SHAPE_MSB_2, out, n);
+                break;
+        default:
+                memset(out, 0, n * sizeof(*out));
+                break;
+        }
+        m->acc = (uint32_t)((m->acc + (uint64_t)step * n) & ACC_MASK);
+}
+
+double ddsmodel_hz(const ddsmodel_t* m, double mclk)
+{
+        uint16_t c = m->control;
+        if (c & (RESET | SLEEP1))
+        {
+                return 0;
+        }
+        double hz = m->freq[(c & FSELECT) != 0] * mclk / (1UL << 28);
+        return shape_of(c) == SHAPE_MSB_2 ? hz / 2 : hz;
+}
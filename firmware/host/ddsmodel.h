@@ -0,0 +1,84 @@
+//////////////////////////////////////////////////////////////////////////////
+///
+///  \file ddsmodel.h
+///
+///  \copy copyright (c) 2023 William R Cooke
+///
+///  @brief AD9833 signal path model, one output sample per MCLK cycle.
+///
+///  The model takes the same 16 bit words the chip does and keeps its
+///  registers as the datasheet describes them: two 28 bit FREQ and two
+///  12 bit PHASE registers, B28 pairs and HLB halves, and the control
+///  bits.  Each MCLK cycle the 28 bit phase accumulator adds the selected
+///  FREQ; the selected PHASE is added to its top 12 bits, which address
+///  the sine ROM or make the ramp, and the result is a 10 bit DAC code.
+///  OPBITEN replaces the DAC with the MSB, or with DIV2 clear, the MSB
+///  divided by two, as 0 or DDSMODEL_FULL_SCALE.
+///
+///  RESET holds the accumulator at zero, which with PHASE 0 is midscale.
+///  SLEEP1 stops the accumulator where it is and SLEEP12 powers the DAC
+///  down to 0.  The ROM is an ideal sine rounded to 10 bits; the real
+///  chip's ROM is not published, so codes may differ from it by one.
+///
+///  Rendering works eight samples at a time with GCC vector extensions;
+///  build with -O3 -march=native to get the wide instructions.
+///
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef DDSMODEL_H
+#define DDSMODEL_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define DDSMODEL_FULL_SCALE    1023
+
+        typedef struct DDSMODEL
+        {
+                uint32_t freq[2];       // 28 bit tuning words
+                uint16_t phase[2];      // 12 bit offsets
+                uint16_t control;       // last control word, D13 to D0
+                uint8_t  b28_lsb;       // B28: a LSB half is waiting
+                uint8_t  b28_reg;       // for this FREQ register
+                uint16_t b28_half;      // and is these 14 bits
+                uint32_t acc;           // phase accumulator, plus the
+                                        // MSB / 2 state in bit 28
+                uint64_t words;         // words taken
+        } ddsmodel_t;
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn ddsmodel_init
+/// @brief Power-up state as AD9833_init() leaves it: every register zero
+///        and RESET held.
+//////////////////////////////////////////////////////////////////////////////
+        void ddsmodel_init(ddsmodel_t* m);
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn ddsmodel_write
+/// @brief Takes one 16 bit word as the chip does on FSYNC rising.
+//////////////////////////////////////////////////////////////////////////////
+        void ddsmodel_write(ddsmodel_t* m, uint16_t word);
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn ddsmodel_render
+/// @brief Runs n MCLK cycles with the registers as they stand.
+/// @param[out] out  n DAC codes, 0 to DDSMODEL_FULL_SCALE.
+//////////////////////////////////////////////////////////////////////////////
+        void ddsmodel_render(ddsmodel_t* m, uint16_t* out, size_t n);
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn ddsmodel_hz
+/// @return Frequency the selected FREQ register makes at mclk Hz, 0 in
+///         RESET or SLEEP1.
+//////////////////////////////////////////////////////////////////////////////
+        double ddsmodel_hz(const ddsmodel_t* m, double mclk);
+
+#ifdef __cplusplus
+}
+#endif  // __cplusplus
+#endif  // #ifndef DDSMODEL_H
@@ -0,0 +1,372 @@
+//////////////////////////////////////////////////////////////////////////////
+///
+///  \file ddsplay.c
+///
+///  \copy copyright (c) 2023 William R Cooke
+///
+///  @brief Replays a bench SPI trace through the AD9833 model.
+///
+///  Usage: ddsplay [-i chip] [-m mclk] [-c cpu] [-s ms] [-l ms] [-d n]
+///                 [-o out.wav] [-z ms] trace.txt
+///
+///  -i  chip to follow, the trace's iface column, default 0
+///  -m  AD9833 master clock, default 25000000 Hz
+///  -c  clock the trace's cycle column counts, default 16000000 Hz
+///  -s  start this far into the trace, default 0 ms
+///  -l  render this long, default to the last word plus 1 ms
+///  -d  average every n MCLK samples into one, default 1
+///  -o  write the samples as a 16 bit mono WAV file at mclk / n
+///  -z  every this many ms print the time, the frequency the registers
+///      give and the frequency counted from the output's crossings
+///
+///  The trace is softrock33_host's -t output, "<cycle> <iface> <word>"
+///  per line, "-" for stdin.  Each word takes effect at the MCLK cycle
+///  its trace cycle falls in, and the model runs the cycles between
+///  words in one call.  At the end it prints how many words it took and
+///  how fast it rendered.
+///
+//////////////////////////////////////////////////////////////////////////////
+
+#define _DEFAULT_SOURCE
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "ddsmodel.h"
+
+#define CHUNK           65536           // MCLK samples per render call
+
+typedef struct OPTIONS
+{
+        unsigned chip;
+        double   mclk;
+        double   cpu;
+        double   start_ms;
+        double   length_ms;             // < 0: up to the last word
+        unsigned decimate;
+        const char* wav;
+        double   window_ms;             // 0: no frequency report
+} options_t;
+
+typedef struct TRACE_WORD
+{
+        uint64_t cycle;
+        uint16_t word;
+} trace_word_t;
+
+// Output side: decimation, WAV samples and the crossing counter
+typedef struct SINK
+{
+        FILE*    wav;
+        uint64_t wav_samples;
+        unsigned decimate;
+        unsigned have;                  // samples in sum so far
+        uint32_t sum;
+        uint64_t mclk_done;             // MCLK samples taken in
+        uint64_t window;                // MCLK samples per report, or 0
+        uint64_t window_end;
+        uint8_t  high;                  // above midscale, with hysteresis
+        uint64_t first_cross;           // first and last rising crossing
+        uint64_t last_cross;            // in the window, MCLK samples
+        uint32_t crossings;
+} sink_t;
+
+static trace_word_t* read_trace(const char* path, unsigned chip, size_t* n)
+{
+        FILE* f = strcmp(path, "-") ? fopen(path, "r") : stdin;
+        if (!f)
+        {
+                perror(path);
+                exit(2);
+        }
+        size_t cap = 4096;
+        trace_word_t* t = malloc(cap * sizeof(*t));
+        unsigned long long cycle;
+        unsigned iface;
+        unsigned word;
+        *n = 0;
+        while (fscanf(f, "%llu %u %x", &cycle, &iface, &word) == 3)
+        {
+                if (iface != chip)
+                {
+                        continue;
+                }
+                if (*n == cap)
+                {
+                        cap *= 2;
+                        t = realloc(t, cap * sizeof(*t));
+                }
+                t[*n].cycle = cycle;
+                t[*n].word = (uint16_t)word;
+                (*n)++;
+        }
+        if (f != stdin)
+        {
+                fclose(f);
+        }
+        return t;
+}
+
+static void put_le(FILE* f, uint32_t v, int bytes)
+{
+        for (int i = 0; i < bytes; i++)
+        {
+                fputc((v >> (8 * i)) & 0xff, f);
+        }
+}
+
+static void wav_header(FILE* f, uint32_t rate, uint64_t samples)
+{
+        uint32_t data = (uint32_t)(samples * 2);
+        fputs("RIFF", f);
+        put_le(f, 36 + data, 4);
+        fputs("WAVEfmt ", f);
+        put_le(f, 16, 4);
+        put_le(f, 1, 2);                // PCM
+        put_le(f, 1, 2);                // mono
+        put_le(f, rate, 4);
+        put_le(f, rate * 2, 4);
+        put_le(f, 2, 2);
+        put_le(f, 16, 2);
+        fputs("data", f);
+        put_le(f, data, 4);
+}
+
+static void report_window(sink_t* s, const ddsmodel_t* m, double mclk)
+{
+        double counted = 0;
+        if (s->crossings > 1)
+        {
+                counted = (s->crossings - 1) * mclk
+                        / (double)(s->last_cross - s->first_cross);
+        }
+        printf("%10.3f ms  registers %12.3f Hz  output %12.3f Hz\n",
+               s->window_end * 1000.0 / mclk, ddsmodel_hz(m, mclk),
+               counted);
+        s->crossings = 0;
+        s->window_end += s->window;
+}
+
+// 0 to 1023 averaged over have samples, onto most of the 16 bit range
+static int16_t pcm_of(uint32_t sum, unsigned have)
+{
+        return (int16_t)((int32_t)((sum * 64 + have / 2) / have) - 32736);
+}
+
+// Takes n MCLK samples: the WAV gets their averages, the counter their
+// crossings of midscale
+static void sink(sink_t* s, const ddsmodel_t* m, double mclk,
+                 const uint16_t* v, size_t n)
+{
+        static int16_t pcm[CHUNK];
+        size_t out = 0;
+        size_t i = 0;
+        const unsigned d = s->decimate;
+        for (size_t j = 0; s->window && j < n; j++)
+        {
+                uint64_t at = s->mclk_done + j;
+                if (!s->high && v[j] > 512 + 64)
+                {
+                        s->high = 1;
+                        if (s->crossings++ == 0)
+                        {
+                                s->first_cross = at;
+                        }
+                        s->last_cross = at;
+                }
+                else if (s->high && v[j] < 512 - 64)
+                {
+                        s->high = 0;
+                }
+                if (at + 1 == s->window_end)
+                {
+                        report_window(s, m, mclk);
+                }
+        }
+        s->mclk_done += n;
+        if (!s->wav)
+        {
+                return;
+        }
+        // A group the last call left open, whole groups, then the rest
+        for (; s->have && i < n; i++)
+        {
+                s->sum += v[i];
+                if (++s->have == d)
+                {
+                        pcm[out++] = pcm_of(s->sum, d);
+                        s->sum = 0;
+                        s->have = 0;
+                }
+        }
+        for (; i + d <= n; i += d)
+        {
+                uint32_t sum = 0;
+                for (unsigned j = 0; j < d; j++)
+                {
+                        sum += v[i + j];
+                }
+                pcm[out++] = pcm_of(sum, d);
+        }
+        for (; i < n; i++)
+        {
+                s->sum += v[i];
+                s->have++;
+        }
+        if (out)
+        {
+                // WAV data is little endian, as the hosts this runs on
+                fwrite(pcm, sizeof(pcm[0]), out, s->wav);
+                s->wav_samples += out;
+        }
+}
+
+// Renders from the model's position up to MCLK sample end
+static void run_to(ddsmodel_t* m, sink_t* s, double mclk, uint64_t end)
+{
+        static uint16_t buf[CHUNK];
+        while (s->mclk_done < end)
+        {
+                uint64_t n = end - s->mclk_done;
+                if (n > CHUNK)
+                {
+                        n = CHUNK;
+                }
+                ddsmodel_render(m, buf, (size_t)n);
+                sink(s, m, mclk, buf, (size_t)n);
+        }
+}
+
+static void usage(const char* prog)
+{
+        fprintf(stderr, "usage: %s [-i chip] [-m mclk] [-c cpu] [-s ms] "
+                "[-l ms] [-d n] [-o out.wav] [-z ms] trace.txt\n", prog);
+        exit(2);
+}
+
+int main(int argc, char** argv)
+{
+        options_t o = { 0, 25000000.0, 16000000.0, 0, -1, 1, NULL, 0 };
+        int opt;
+        while ((opt = getopt(argc, argv, "i:m:c:s:l:d:o:z:")) != -1)
+        {
+                switch (opt)
+                {
+                case 'i':
+                        o.chip = (unsigned)strtoul(optarg, NULL, 0);
+                        break;
+                case 'm':
+                        o.mclk = strtod(optarg, NULL);
+                        break;
+                case 'c':
+                        o.cpu = strtod(optarg, NULL);
+                        break;
+                case 's':
+                        o.start_ms = strtod(optarg, NULL);
+                        break;
+                case 'l':
+                        o.length_ms = strtod(optarg, NULL);
+                        break;
+                case 'd':
+                        o.decimate = (unsigned)strtoul(optarg, NULL, 0);
+                        break;
+                case 'o':
+                        o.wav = optarg;
+                        break;
+                case 'z':
+                        o.window_ms = strtod(optarg, NULL);
+                        break;
+                default:
+                        usage(argv[0]);
+                }
+        }
+        if (optind != argc - 1 || o.mclk < 1 || o.cpu < 1 || o.decimate < 1
+            || o.start_ms < 0 || o.window_ms < 0)
+        {
+                usage(argv[0]);
+        }
+
+        size_t count;
+        trace_word_t* t = read_trace(argv[optind], o.chip, &count);
+        // Trace cycle to MCLK sample
+        double k = o.mclk / o.cpu;
+        uint64_t start = (uint64_t)(o.start_ms * o.mclk / 1000);
+        uint64_t end = o.length_ms >= 0
+                ? start + (uint64_t)(o.length_ms * o.mclk / 1000)
+                : (count ? (uint64_t)(t[count - 1].cycle * k) : 0)
+                  + (uint64_t)(o.mclk / 1000);
+
+        ddsmodel_t m;
+        ddsmodel_init(&m);
+        size_t i = 0;
+        // Words before the start set the registers, nothing is rendered
+        while (i < count && (uint64_t)(t[i].cycle * k) <= start)
+        {
+                ddsmodel_write(&m, t[i++].word);
+        }
+        if (start)
+        {
+                uint64_t at = i ? (uint64_t)(t[i - 1].cycle * k) : 0;
+                static uint16_t skip[CHUNK];
+                // Keep the accumulator's phase: run it without output
+                for (uint64_t left = start - at; left; )
+                {
+                        size_t n = left > CHUNK ? CHUNK : (size_t)left;
+                        ddsmodel_render(&m, skip, n);
+                        left -= n;
+                }
+        }
+
+        sink_t s;
+        memset(&s, 0, sizeof(s));
+        s.decimate = o.decimate;
+        s.mclk_done = start;
+        s.window = (uint64_t)(o.window_ms * o.mclk / 1000);
+        s.window_end = start + s.window;
+        if (o.wav)
+        {
+                s.wav = fopen(o.wav, "wb");
+                if (!s.wav)
+                {
+                        perror(o.wav);
+                        exit(2);
+                }
+                wav_header(s.wav, (uint32_t)(o.mclk / o.decimate + 0.5), 0);
+        }
+
+        struct timespec t0;
+        struct timespec t1;
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        for (; i < count; i++)
+        {
+                uint64_t at = (uint64_t)(t[i].cycle * k);
+                if (at >= end)
+                {
+                        break;
+                }
+                run_to(&m, &s, o.mclk, at);
+                ddsmodel_write(&m, t[i].word);
+        }
+        run_to(&m, &s, o.mclk, end);
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+
+        if (s.wav)
+        {
+                fseek(s.wav, 0, SEEK_SET);
+                wav_header(s.wav, (uint32_t)(o.mclk / o.decimate + 0.5),
+                           s.wav_samples);
+                fclose(s.wav);
+        }
+        double secs = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec)
+                * 1e-9;
+        printf("ddsplay: %llu words, %.3f ms of output, %llu samples"
+               " written, %.1f Msamples/s\n",
+               (unsigned long long)m.words, (end - start) * 1000.0 / o.mclk,
+               (unsigned long long)s.wav_samples,
+               secs > 0 ? (end - start) / secs / 1e6 : 0.0);
+        free(t);
+        return 0;
+}
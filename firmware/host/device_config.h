@@ -0,0 +1,18 @@
+//////////////////////////////////////////////////////////////////////////////
+///
+///  \file device_config.h
+///
+///  \copy copyright (c) 2023 William R Cooke
+///
+///  @brief Host stand-in for avrlib device configuration.
+///
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef HOST_DEVICE_CONFIG_H
+#define HOST_DEVICE_CONFIG_H
+
+#include <stdint.h>
+
+#include <avr/io.h>
+
+#endif  // #ifndef HOST_DEVICE_CONFIG_H
@@ -0,0 +1,20 @@
+//////////////////////////////////////////////////////////////////////////////
+///
+///  \file encoder.h
+///
+///  \copy copyright (c) 2023 William R Cooke
+///
+///  @brief Host stand-in for avrlib ENCODER.
+///
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef HOST_ENCODER_H
+#define HOST_ENCODER_H
+
+#include <stdint.h>
+
+void ENCODER_init(void);
+int32_t ENCODER_get_count(uint8_t which);
+void ENCODER_set_count(uint8_t which, int32_t count);
+
+#endif  // #ifndef HOST_ENCODER_H
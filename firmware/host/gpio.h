@@ -0,0 +1,40 @@
+//////////////////////////////////////////////////////////////////////////////
+///
+///  \file gpio.h
+///
+///  \copy copyright (c) 2023 William R Cooke
+///
+///  @brief Host stand-in for avrlib GPIO.
+///
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef HOST_GPIO_H
+#define HOST_GPIO_H
+
+#include <stdint.h>
+
+typedef enum GPIO_PIN
+{
+        GPIO_PIN_B0, GPIO_PIN_B1, GPIO_PIN_B2, GPIO_PIN_B3,
+        GPIO_PIN_B4, GPIO_PIN_B5, GPIO_PIN_B6, GPIO_PIN_B7,
+        GPIO_PIN_C0, GPIO_PIN_C1, GPIO_PIN_C2, GPIO_PIN_C3,
+        GPIO_PIN_C4, GPIO_PIN_C5, GPIO_PIN_C6, GPIO_PIN_C7,
+        GPIO_PIN_D0, GPIO_PIN_D1, GPIO_PIN_D2, GPIO_PIN_D3,
+        GPIO_PIN_D4, GPIO_PIN_D5, GPIO_PIN_D6, GPIO_PIN_D7
+} GpioPin_t;
+
+typedef enum GPIO_PIN_MODE
+{
+        GPIO_PIN_MODE_INPUT,
+        GPIO_PIN_MODE_INPUT_PULLUP,
+        GPIO_PIN_MODE_OUTPUT
+} GpioPinMode_t;
+
+void GPIO_init(void);
+void GPIO_pin_mode(GpioPin_t pin, GpioPinMode_t mode);
+void GPIO_write_pin(GpioPin_t pin, uint8_t value);
+uint8_t GPIO_read_pin(GpioPin_t pin);
+uint8_t GPIO_read_output_pin(GpioPin_t pin);
+void GPIO_toggle_pin(GpioPin_t pin);
+
+#endif  // #ifndef HOST_GPIO_H
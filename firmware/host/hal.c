@@ -0,0 +1,1298 @@
+//////////////////////////////////////////////////////////////////////////////
+///
+///  \file hal.c
+///
+///  \copy copyright (c) 2023 William R Cooke
+///
+///  @brief Host-native stand-ins for avrlib and avr-libc.
+///
+//////////////////////////////////////////////////////////////////////////////
+
+#include <setjmp.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/eeprom.h>
+#include <avr/sleep.h>
+#include "host.h"
+#include "systick.h"
+#include "gpio.h"
+#include "button.h"
+#include "softspi.h"
+#include "lcd.h"
+#include "encoder.h"
+#include "keypad.h"
+
+volatile uint8_t DDRB;
+volatile uint8_t DDRC;
+volatile uint8_t DDRD;
+volatile uint8_t PORTB;
+volatile uint8_t PORTC;
+volatile uint8_t PORTD;
+volatile uint8_t PINB;
+volatile uint8_t PINC;
+volatile uint8_t PIND;
+volatile uint8_t MCUCR;
+volatile uint8_t GICR;
+volatile uint8_t GIFR;
+volatile uint8_t TIMSK;
+volatile uint8_t TIFR;
+volatile uint8_t TCCR1A;
+volatile uint8_t TCCR1B;
+volatile uint16_t OCR1A;
+volatile uint16_t OCR1B;
+volatile uint16_t ICR1;
+volatile uint8_t TCCR2;
+volatile uint8_t TCNT2;
+volatile uint8_t OCR2;
+volatile uintptr_t EEAR;
+volatile uint8_t UCSRA;
+volatile uint8_t UCSRB;
+volatile uint8_t UCSRC;
+volatile uint8_t UBRRH;
+volatile uint8_t UBRRL;
+volatile uint8_t SPCR;
+static volatile uint8_t spsr;
+static volatile uint8_t spdr;
+
+host_stats_t host_stats;
+uint8_t host_lcd[HOST_LCD_ROWS][HOST_LCD_COLS + 1];
+volatile uint8_t host_sreg_i;
+volatile uint8_t host_sleep_mode;
+volatile uint8_t host_sleep_enabled;
+
+static uint64_t cycles;
+static uint64_t end_cycles;
+static uint64_t masked_since;
+static uint32_t last_ms_seen;
+static jmp_buf exit_jmp;
+static void (*tick_fn)(uint32_t ms);
+static void (*spi_fn)(const host_spi_record_t* rec);
+static void (*lcd_fn)(const host_lcd_record_t* rec);
+static void (*uart_fn)(uint8_t ch);
+
+// Same order as keytable[] in softrock33.c
+static const char scan_codes[] = "*1470258#369rs?B";
+
+// As deep as the avrlib drivers' buffers, which hold one less
+#define KEY_FIFO_SIZE     8
+#define BUTTON_FIFO_SIZE  4
+static int key_fifo[KEY_FIFO_SIZE];
+static uint8_t key_head;
+static uint8_t key_tail;
+static int button_fifo[BUTTON_FIFO_SIZE];
+static uint8_t button_head;
+static uint8_t button_tail;
+static int32_t encoder_count[2];
+static int32_t encoder_edges;    // quadrature edges still to play out
+static uint32_t encoder_gap;     // cycles between them
+static uint32_t trigger_width;   // cycles ICP1 stays high
+
+static uint8_t lcd_x;
+static uint8_t lcd_y;
+
+static uint64_t event_due[HOST_EVENT_MAX];
+static void (*event_fn[HOST_EVENT_MAX])(void);
+static uint32_t irq_pending;
+static void (*irq_vector[32])(void);
+static uint8_t in_isr;
+static uint32_t isrs_taken;
+
+static uint16_t spi_shift;       // hardware SPI word being assembled
+static uint8_t spi_bytes;
+
+// Timer1: count = t1_count + (cycles - t1_since) / prescale
+static uint16_t tcnt1;
+static uint64_t t1_since;
+static uint16_t t1_count;
+static uint8_t  t1_cs;
+static uint64_t t1_due[3];       // compare A, compare B, overflow
+
+// Timer2: next compare match, under clock select t2_cs
+static uint64_t t2_due;
+static uint8_t  t2_cs;
+
+// EEPROM control and data registers, and the byte being written
+static volatile uint8_t eecr;
+static volatile uint8_t eedr;
+static uint8_t* ee_addr;
+static uint8_t ee_byte;
+
+// USART.  UDR reads back with bit 8 set; a firmware write clears it,
+// which is how a write is told from a read after the access.
+#define UART_IN_SIZE      4096
+static volatile uint16_t udr;
+static uint8_t udr_accessed;
+static uint8_t uart_in[UART_IN_SIZE];
+static uint16_t uart_in_head;
+static uint16_t uart_in_tail;
+static uint8_t rx_data;
+static uint8_t rx_full;
+static uint8_t tx_data;
+static uint8_t tx_buffered;      // byte waiting in UDR for the shifter
+static uint8_t tx_shifting;
+
+// Firmware interrupt handlers, NULL when the build has none
+void SPI_STC_vect(void) __attribute__((weak));
+void INT0_vect(void) __attribute__((weak));
+void INT1_vect(void) __attribute__((weak));
+void USART_RXC_vect(void) __attribute__((weak));
+void TIMER1_COMPA_vect(void) __attribute__((weak));
+void TIMER1_COMPB_vect(void) __attribute__((weak));
+void TIMER1_OVF_vect(void) __attribute__((weak));
+void TIMER1_CAPT_vect(void) __attribute__((weak));
+void TIMER2_COMP_vect(void) __attribute__((weak));
+void USART_UDRE_vect(void) __attribute__((weak));
+void EE_RDY_vect(void) __attribute__((weak));
+
+static void uart_sync(void);
+static void timer1_sync(void);
+static uint16_t timer1_count(void);
+static void timer2_sync(void);
+static void ee_sync(void);
+
+static void record_spi(uint8_t iface, uint16_t word)
+{
+        host_stats.spi_words++;
+        // AD9833 control word, D15 D14 = 00, with RESET (D8) clear
+        if (!host_stats.dds_on_cycle && (word & 0xc100) == 0)
+        {
+                host_stats.dds_on_cycle = cycles;
+        }
+        if (spi_fn)
+        {
+                host_spi_record_t rec = { cycles, iface, word };
+                spi_fn(&rec);
+        }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//  Simulated clock
+//////////////////////////////////////////////////////////////////////////////
+
+// Runs pending interrupt handlers, lowest vector first, as the AVR would
+static void dispatch(void)
+{
+        timer1_sync();
+        timer2_sync();
+        uart_sync();
+        ee_sync();
+        while (host_sreg_i && !in_isr && irq_pending)
+        {
+                uint8_t n = (uint8_t)__builtin_ctz(irq_pending);
+                irq_pending &= ~(1UL << n);
+                in_isr = 1;
+                isrs_taken++;
+                host_sreg_i = 0;
+                host_charge(HOST_COST_ISR);
+                irq_vector[n]();
+                host_sreg_i = 1;
+                in_isr = 0;
+                timer1_sync();
+                timer2_sync();
+                uart_sync();
+                ee_sync();
+        }
+}
+
+void host_charge(uint32_t n)
+{
+        uint64_t target = cycles + n;
+        for (;;)
+        {
+                uint64_t next_ms = (cycles / HOST_CYCLES_PER_MS + 1)
+                        * HOST_CYCLES_PER_MS;
+                uint64_t when = target < next_ms ? target : next_ms;
+                for (int i = 0; i < HOST_EVENT_MAX; i++)
+                {
+                        if (event_fn[i] && event_due[i] < when)
+                        {
+                                when = event_due[i];
+                        }
+                }
+                if (when > cycles)
+                {
+                        cycles = when;
+                }
+                if (cycles == next_ms)
+                {
+                        if (cycles >= end_cycles)
+                        {
+                                longjmp(exit_jmp, 1);
+                        }
+                        if (tick_fn)
+                        {
+                                tick_fn((uint32_t)(cycles / HOST_CYCLES_PER_MS));
+                        }
+                }
+                for (int i = 0; i < HOST_EVENT_MAX; i++)
+                {
+                        if (event_fn[i] && event_due[i] <= cycles)
+                        {
+                                void (*fn)(void) = event_fn[i];
+                                event_fn[i] = NULL;
+                                fn();
+                        }
+                }
+                dispatch();
+                if (cycles >= target)
+                {
+                        break;
+                }
+        }
+}
+
+void host_schedule(uint8_t id, uint64_t at, void (*fn)(void))
+{
+        event_due[id] = at;
+        event_fn[id] = fn;
+}
+
+void host_cancel(uint8_t id)
+{
+        event_fn[id] = NULL;
+}
+
+void host_irq_raise(uint8_t n, void (*vector)(void))
+{
+        if (vector)
+        {
+                irq_vector[n] = vector;
+                irq_pending |= 1UL << n;
+        }
+}
+
+void host_irq_clear(uint8_t n)
+{
+        irq_pending &= ~(1UL << n);
+}
+
+uint64_t host_cycles(void)
+{
+        return cycles;
+}
+
+uint32_t host_milliseconds(void)
+{
+        return (uint32_t)(cycles / HOST_CYCLES_PER_MS);
+}
+
+void host_cli(void)
+{
+        if (host_sreg_i)
+        {
+                masked_since = cycles;
+        }
+        host_sreg_i = 0;
+}
+
+void host_sei(void)
+{
+        if (!host_sreg_i)
+        {
+                uint64_t len = cycles - masked_since;
+                host_stats.masked_cycles += len;
+                if (len > host_stats.max_masked)
+                {
+                        host_stats.max_masked = len;
+                }
+        }
+        host_sreg_i = 1;
+        dispatch();
+}
+
+void host_sleep(void)
+{
+        uint32_t taken = isrs_taken;
+        uint64_t wake = (cycles / HOST_CYCLES_PER_MS + 1) * HOST_CYCLES_PER_MS;
+        if (!host_sleep_enabled)
+        {
+                return;
+        }
+        // Timed events may or may not raise an interrupt, so step from
+        // one to the next until one does
+        while (isrs_taken == taken && cycles < wake)
+        {
+                uint64_t until = wake;
+                for (int i = 0; i < HOST_EVENT_MAX; i++)
+                {
+                        if (event_fn[i] && event_due[i] < until)
+                        {
+                                until = event_due[i];
+                        }
+                }
+                uint64_t step = until > cycles ? until - cycles : 0;
+                host_stats.sleep_cycles += step;
+                host_charge((uint32_t)(step ? step : 1));
+        }
+}
+
+void host_run(int (*fw_main)(int, char**), uint32_t ms,
+              void (*on_tick)(uint32_t ms))
+{
+        end_cycles = (uint64_t)ms * HOST_CYCLES_PER_MS;
+        tick_fn = on_tick;
+        host_sreg_i = 1;
+        PIND |= 0x0c;            // encoder at rest, pulled up
+        UCSRA = 1 << UDRE;
+        if (setjmp(exit_jmp) == 0)
+        {
+                fw_main(0, NULL);
+        }
+        tick_fn = NULL;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//  Scripted input and traces
+//////////////////////////////////////////////////////////////////////////////
+
+void host_press_key(char ch)
+{
+        const char* p = strchr(scan_codes, ch);
+        if (!p || ch == ' ')
+        {
+                return;
+        }
+        host_stats.input_events++;
+        if ((uint8_t)(key_head + 1) % KEY_FIFO_SIZE == key_tail)
+        {
+                host_stats.input_dropped++;
+                return;
+        }
+        key_fifo[key_head] = (int)(p - scan_codes);
+        key_head = (key_head + 1) % KEY_FIFO_SIZE;
+}
+
+void host_press_button(int button)
+{
+        host_stats.input_events++;
+        if ((uint8_t)(button_head + 1) % BUTTON_FIFO_SIZE == button_tail)
+        {
+                host_stats.input_dropped++;
+                return;
+        }
+        button_fifo[button_head] = button;
+        button_head = (button_head + 1) % BUTTON_FIFO_SIZE;
+}
+
+// Raises INTn if its sense bits in MCUCR match this edge of the pin
+static void int_edge(uint8_t n, uint8_t was, uint8_t now)
+{
+        static const uint8_t vec[] = { HOST_IRQ_INT0, HOST_IRQ_INT1 };
+        uint8_t sense = (MCUCR >> (2 * n)) & 3;
+        if (was == now || sense == 0 || (sense == 2 && now)
+            || (sense == 3 && !now))
+        {
+                return;
+        }
+        GIFR |= (uint8_t)(1 << (INTF0 + n));
+        if (GICR & (1 << (INT0 + n)))
+        {
+                GIFR &= (uint8_t)~(1 << (INTF0 + n));
+                host_irq_raise(vec[n], n ? INT1_vect : INT0_vect);
+        }
+}
+
+// One quadrature transition on PD2 (A) and PD3 (B)
+static void encoder_edge(void)
+{
+        static const uint8_t forward[] = { 1, 3, 0, 2 };
+        static const uint8_t backward[] = { 2, 0, 3, 1 };
+        uint8_t was = (PIND >> 2) & 3;
+        uint8_t now = encoder_edges > 0 ? forward[was] : backward[was];
+
+        PIND = (uint8_t)((PIND & ~0x0c) | (now << 2));
+        encoder_edges += encoder_edges > 0 ? -1 : 1;
+        int_edge(0, was & 1, now & 1);
+        int_edge(1, was >> 1, now >> 1);
+        if (encoder_edges)
+        {
+                host_schedule(HOST_EVENT_ENCODER, cycles + encoder_gap,
+                              encoder_edge);
+        }
+}
+
+// ICP1 changes level; the capture unit latches TCNT1 on the ICES1 edge.
+// The noise canceller's 4 cycle delay is left out.
+static void trigger_edge(void)
+{
+        uint8_t high = !(PINB & 1);
+        PINB = (uint8_t)((PINB & ~1) | high);
+        if (high == !!(TCCR1B & (1 << ICES1)))
+        {
+                timer1_sync();
+                ICR1 = timer1_count();
+                TIFR |= 1 << ICF1;
+                timer1_sync();
+        }
+        if (high)
+        {
+                host_schedule(HOST_EVENT_TRIGGER, cycles + trigger_width,
+                              trigger_edge);
+        }
+}
+
+void host_trigger(uint32_t delay, uint32_t width)
+{
+        trigger_width = width ? width : 1;
+        host_schedule(HOST_EVENT_TRIGGER, cycles + delay, trigger_edge);
+}
+
+void host_turn_encoder(int32_t detents)
+{
+        encoder_count[0] += detents;
+        // Spread the edges over the next millisecond
+        encoder_edges += detents * 4;
+        if (encoder_edges)
+        {
+                int32_t n = encoder_edges < 0 ? -encoder_edges : encoder_edges;
+                encoder_gap = HOST_CYCLES_PER_MS / (uint32_t)n;
+                if (encoder_gap < 2 * HOST_COST_ISR)
+                {
+                        encoder_gap = 2 * HOST_COST_ISR;
+                }
+                host_schedule(HOST_EVENT_ENCODER, cycles + encoder_gap,
+                              encoder_edge);
+        }
+}
+
+void host_trace_spi(void (*fn)(const host_spi_record_t* rec))
+{
+        spi_fn = fn;
+}
+
+void host_trace_lcd(void (*fn)(const host_lcd_record_t* rec))
+{
+        lcd_fn = fn;
+}
+
+void host_trace_uart(void (*fn)(uint8_t ch))
+{
+        uart_fn = fn;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//  SYSTICK
+//////////////////////////////////////////////////////////////////////////////
+
+void SYSTICK_init(ClkDiv_t div)
+{
+        (void)div;
+        last_ms_seen = host_milliseconds();
+}
+
+uint32_t SYSTICK_get_milliseconds(void)
+{
+        host_charge(HOST_COST_SYSTICK_READ);
+        uint32_t ms = host_milliseconds();
+        if (ms == last_ms_seen)
+        {
+                host_stats.idle_cycles += HOST_COST_SYSTICK_READ;
+        }
+        else
+        {
+                host_stats.passes++;
+                host_stats.missed_ticks += ms - last_ms_seen - 1;
+                last_ms_seen = ms;
+        }
+        return ms;
+}
+
+uint32_t SYSTICK_get_ticks(void)
+{
+        host_charge(HOST_COST_SYSTICK_READ);
+        return (uint32_t)(cycles / (64 * 256));
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//  GPIO
+//////////////////////////////////////////////////////////////////////////////
+
+static volatile uint8_t* port_of(GpioPin_t pin)
+{
+        return pin < GPIO_PIN_C0 ? &PORTB : pin < GPIO_PIN_D0 ? &PORTC : &PORTD;
+}
+
+void GPIO_init(void)
+{
+}
+
+void GPIO_pin_mode(GpioPin_t pin, GpioPinMode_t mode)
+{
+        (void)pin;
+        (void)mode;
+}
+
+void GPIO_write_pin(GpioPin_t pin, uint8_t value)
+{
+        if (value)
+        {
+                *port_of(pin) |= (uint8_t)(1 << (pin & 7));
+        }
+        else
+        {
+                *port_of(pin) &= (uint8_t)~(1 << (pin & 7));
+        }
+}
+
+uint8_t GPIO_read_pin(GpioPin_t pin)
+{
+        volatile uint8_t* in = pin < GPIO_PIN_C0 ? &PINB
+                : pin < GPIO_PIN_D0 ? &PINC : &PIND;
+        return (*in >> (pin & 7)) & 1;
+}
+
+uint8_t GPIO_read_output_pin(GpioPin_t pin)
+{
+        return (*port_of(pin) >> (pin & 7)) & 1;
+}
+
+void GPIO_toggle_pin(GpioPin_t pin)
+{
+        *port_of(pin) ^= (uint8_t)(1 << (pin & 7));
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//  BUTTON, KEYPAD, ENCODER
+//////////////////////////////////////////////////////////////////////////////
+
+void BUTTON_init(void)
+{
+        button_head = button_tail = 0;
+}
+
+int BUTTON_waiting(void)
+{
+        return button_head != button_tail;
+}
+
+int BUTTON_get_button(void)
+{
+        host_charge(HOST_COST_INPUT_READ);
+        if (button_head == button_tail)
+        {
+                return -1;
+        }
+        int b = button_fifo[button_tail];
+        button_tail = (button_tail + 1) % BUTTON_FIFO_SIZE;
+        return b;
+}
+
+void KEYPAD_init(void)
+{
+        key_head = key_tail = 0;
+}
+
+int KEYPAD_waiting(void)
+{
+        return key_head != key_tail;
+}
+
+int KEYPAD_get_key(void)
+{
+        host_charge(HOST_COST_INPUT_READ);
+        if (key_head == key_tail)
+        {
+                return -1;
+        }
+        int k = key_fifo[key_tail];
+        key_tail = (key_tail + 1) % KEY_FIFO_SIZE;
+        return k;
+}
+
+void ENCODER_init(void)
+{
+        encoder_count[0] = encoder_count[1] = 0;
+}
+
+int32_t ENCODER_get_count(uint8_t which)
+{
+        host_charge(HOST_COST_INPUT_READ);
+        return encoder_count[which & 1];
+}
+
+void ENCODER_set_count(uint8_t which, int32_t count)
+{
+        encoder_count[which & 1] = count;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//  SOFTSPI
+//////////////////////////////////////////////////////////////////////////////
+
+void SOFTSPI_init(void)
+{
+}
+
+void SOFTSPI_init2(void)
+{
+}
+
+void SOFTSPI_set_interface(uint8_t iface, GpioPin_t ss, uint8_t bits,
+                           SpiMode_t mode, uint8_t delay)
+{
+        (void)iface;
+        (void)ss;
+        (void)bits;
+        (void)mode;
+        (void)delay;
+}
+
+uint32_t SOFTSPI_write(uint8_t iface, uint32_t data)
+{
+        host_charge(HOST_COST_SPI_WORD);
+        record_spi(iface, (uint16_t)data);
+        return 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//  Hardware SPI.  Bytes clocked out while a DDS FSYNC pin is low are
+//  assembled into 16 bit words and recorded like SOFTSPI words, once for
+//  each chip selected.
+//////////////////////////////////////////////////////////////////////////////
+
+static void spi_vector(void)
+{
+        spsr &= ~(1 << SPIF);
+        SPI_STC_vect();
+}
+
+// FSYNC bits driven low
+static uint8_t fsync_low(void)
+{
+        uint8_t bits = 0;
+        for (uint8_t n = 0; n < HOST_DDS_CHIPS; n++)
+        {
+                uint8_t bit = (uint8_t)(1 << (HOST_DDS_FSYNC_BIT - n));
+                if ((DDRC & bit) && !(PORTC & bit))
+                {
+                        bits |= bit;
+                }
+        }
+        return bits;
+}
+
+static void spi_done(void)
+{
+        uint8_t low = fsync_low();
+        if (low)
+        {
+                spi_shift = (uint16_t)(spi_shift << 8) | spdr;
+                if (++spi_bytes == 2)
+                {
+                        for (uint8_t n = 0; n < HOST_DDS_CHIPS; n++)
+                        {
+                                if (low & (1 << (HOST_DDS_FSYNC_BIT - n)))
+                                {
+                                        record_spi(n, spi_shift);
+                                }
+                        }
+                        spi_bytes = 0;
+                }
+        }
+        else
+        {
+                spi_bytes = 0;
+        }
+        spsr |= 1 << SPIF;
+        if ((SPCR & (1 << SPIE)) && SPI_STC_vect)
+        {
+                host_irq_raise(HOST_IRQ_SPI_STC, spi_vector);
+        }
+}
+
+volatile uint8_t* host_spsr(void)
+{
+        host_charge(HOST_COST_SPI_POLL);
+        return &spsr;
+}
+
+volatile uint8_t* host_spdr(void)
+{
+        if (SPCR & (1 << SPE))
+        {
+                static const uint8_t div[] = { 4, 16, 64, 128 };
+                uint32_t bit = div[SPCR & 3];
+                if (spsr & (1 << SPI2X))
+                {
+                        bit /= 2;
+                }
+                spsr &= ~(1 << SPIF);
+                host_schedule(HOST_EVENT_SPI, cycles + 8 * bit, spi_done);
+        }
+        return &spdr;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//  Timer1, normal mode.  Compare matches and overflow set their TIFR flag
+//  on the exact cycle; the flag is cleared when its vector runs.
+//////////////////////////////////////////////////////////////////////////////
+
+static uint32_t timer1_prescale(uint8_t cs)
+{
+        static const uint16_t div[] = { 0, 1, 8, 64, 256, 1024, 0, 0 };
+        return div[cs & 7];
+}
+
+// The count under the clock select last seen, t1_cs
+static uint16_t timer1_count(void)
+{
+        uint32_t p = timer1_prescale(t1_cs);
+        return p ? (uint16_t)(t1_count + (cycles - t1_since) / p) : t1_count;
+}
+
+static void timer1_event(void);
+
+// Works out when each flag next sets and schedules the earliest
+static void timer1_schedule(void)
+{
+        uint32_t p = timer1_prescale(t1_cs);
+        uint16_t now = timer1_count();
+        uint64_t tick = t1_since + (cycles - t1_since) / p * p;
+        uint16_t target[3] = { OCR1A, OCR1B, 0 };
+        uint64_t first = UINT64_MAX;
+        for (int i = 0; i < 3; i++)
+        {
+                uint32_t k = (uint16_t)(target[i] - now);
+                t1_due[i] = tick + (uint64_t)(k ? k : 0x10000) * p;
+                if (t1_due[i] < first)
+                {
+                        first = t1_due[i];
+                }
+        }
+        host_schedule(HOST_EVENT_TIMER1, first, timer1_event);
+}
+
+static void t1_compa_vector(void)
+{
+        TIFR &= ~(1 << OCF1A);
+        TIMER1_COMPA_vect();
+}
+
+static void t1_compb_vector(void)
+{
+        TIFR &= ~(1 << OCF1B);
+        TIMER1_COMPB_vect();
+}
+
+static void t1_ovf_vector(void)
+{
+        TIFR &= ~(1 << TOV1);
+        TIMER1_OVF_vect();
+}
+
+static void t1_capt_vector(void)
+{
+        TIFR &= ~(1 << ICF1);
+        TIMER1_CAPT_vect();
+}
+
+static void timer1_event(void)
+{
+        static const uint8_t flag[3] = { 1 << OCF1A, 1 << OCF1B, 1 << TOV1 };
+        for (int i = 0; i < 3; i++)
+        {
+                if (t1_due[i] == cycles)
+                {
+                        TIFR |= flag[i];
+                }
+        }
+        timer1_schedule();
+        timer1_sync();
+}
+
+// Follows prescaler and compare register changes, raises enabled flags
+static void timer1_sync(void)
+{
+        static uint16_t ocr[2];
+        uint8_t cs = timer1_prescale(TCCR1B) ? TCCR1B & 7 : 0;
+        if (cs != t1_cs)
+        {
+                t1_count = timer1_count();
+                t1_since = cycles;
+                t1_cs = cs;
+                if (cs)
+                {
+                        timer1_schedule();
+                }
+                else
+                {
+                        host_cancel(HOST_EVENT_TIMER1);
+                }
+        }
+        else if (cs && (OCR1A != ocr[0] || OCR1B != ocr[1]))
+        {
+                timer1_schedule();
+        }
+        ocr[0] = OCR1A;
+        ocr[1] = OCR1B;
+
+        if ((TIMSK & (1 << OCIE1A)) && (TIFR & (1 << OCF1A)))
+        {
+                host_irq_raise(HOST_IRQ_TIMER1_COMPA, t1_compa_vector);
+        }
+        else
+        {
+                host_irq_clear(HOST_IRQ_TIMER1_COMPA);
+        }
+        if ((TIMSK & (1 << OCIE1B)) && (TIFR & (1 << OCF1B)))
+        {
+                host_irq_raise(HOST_IRQ_TIMER1_COMPB, t1_compb_vector);
+        }
+        else
+        {
+                host_irq_clear(HOST_IRQ_TIMER1_COMPB);
+        }
+        if ((TIMSK & (1 << TOIE1)) && (TIFR & (1 << TOV1)))
+        {
+                host_irq_raise(HOST_IRQ_TIMER1_OVF, t1_ovf_vector);
+        }
+        else
+        {
+                host_irq_clear(HOST_IRQ_TIMER1_OVF);
+        }
+        if ((TIMSK & (1 << TICIE1)) && (TIFR & (1 << ICF1))
+            && TIMER1_CAPT_vect)
+        {
+                host_irq_raise(HOST_IRQ_TIMER1_CAPT, t1_capt_vector);
+        }
+        else
+        {
+                host_irq_clear(HOST_IRQ_TIMER1_CAPT);
+        }
+}
+
+volatile uint16_t* host_tcnt1(void)
+{
+        host_charge(HOST_COST_TIMER_READ);
+        timer1_sync();
+        tcnt1 = timer1_count();
+        return &tcnt1;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//  Timer2, CTC mode.  Selecting a clock starts the count from TCNT2; each
+//  match sets OCF2 and the next comes OCR2 + 1 counts later, with OCR2 as
+//  it is then.  The count itself is not modelled.
+//////////////////////////////////////////////////////////////////////////////
+
+static uint32_t timer2_prescale(uint8_t cs)
+{
+        static const uint16_t div[] = { 0, 1, 8, 32, 64, 128, 256, 1024 };
+        return div[cs & 7];
+}
+
+static void t2_comp_vector(void)
+{
+        TIFR &= ~(1 << OCF2);
+        TIMER2_COMP_vect();
+}
+
+static void timer2_event(void)
+{
+        TIFR |= 1 << OCF2;
+        t2_due += (uint64_t)(OCR2 + 1) * timer2_prescale(t2_cs);
+        host_schedule(HOST_EVENT_TIMER2, t2_due, timer2_event);
+        timer2_sync();
+}
+
+// Follows the clock select, raises the compare interrupt
+static void timer2_sync(void)
+{
+        uint8_t cs = TCCR2 & 7;
+        if (cs != t2_cs)
+        {
+                t2_cs = cs;
+                if (cs)
+                {
+                        uint8_t k = (uint8_t)(OCR2 - TCNT2) + 1;
+                        t2_due = cycles + (uint64_t)(k ? k : 256)
+                                * timer2_prescale(cs);
+                        host_schedule(HOST_EVENT_TIMER2, t2_due,
+                                      timer2_event);
+                }
+                else
+                {
+                        host_cancel(HOST_EVENT_TIMER2);
+                }
+        }
+        if ((TIMSK & (1 << OCIE2)) && (TIFR & (1 << OCF2))
+            && TIMER2_COMP_vect)
+        {
+                host_irq_raise(HOST_IRQ_TIMER2_COMP, t2_comp_vector);
+        }
+        else
+        {
+                host_irq_clear(HOST_IRQ_TIMER2_COMP);
+        }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//  EEPROM registers.  EERE reads at once; EEWE with EEMWE set starts a
+//  byte write that finishes HOST_COST_EEPROM_WRITE cycles later, during
+//  which reads are ignored.  EE_RDY is a level interrupt on EERIE while
+//  EEWE is clear.
+//////////////////////////////////////////////////////////////////////////////
+
+static void ee_write_done(void)
+{
+        *ee_addr = ee_byte;
+        host_stats.eeprom_bytes_written++;
+        eecr &= ~(1 << EEWE);
+        ee_sync();
+}
+
+static void ee_sync(void)
+{
+        static uint8_t writing;
+        static uint8_t mwe_set;
+        static uint64_t mwe_at;
+        if (writing && !(eecr & (1 << EEWE)))
+        {
+                writing = 0;
+        }
+        if ((eecr & (1 << EERE)) && !writing)
+        {
+                eedr = *(uint8_t*)EEAR;
+        }
+        eecr &= ~(1 << EERE);
+        // EEMWE holds for 4 cycles after it is set
+        if (!(eecr & (1 << EEMWE)))
+        {
+                mwe_set = 0;
+        }
+        else if (!mwe_set)
+        {
+                mwe_set = 1;
+                mwe_at = cycles;
+        }
+        if ((eecr & (1 << EEWE)) && !writing)
+        {
+                if (eecr & (1 << EEMWE))
+                {
+                        writing = 1;
+                        ee_addr = (uint8_t*)EEAR;
+                        ee_byte = eedr;
+                        host_schedule(HOST_EVENT_EEPROM,
+                                      cycles + HOST_COST_EEPROM_WRITE,
+                                      ee_write_done);
+                }
+                else
+                {
+                        eecr &= ~(1 << EEWE);   // EEWE without EEMWE
+                }
+        }
+        if (mwe_set && (writing || cycles > mwe_at + 4))
+        {
+                eecr &= ~(1 << EEMWE);
+                mwe_set = 0;
+        }
+        if ((eecr & (1 << EERIE)) && !(eecr & (1 << EEWE)))
+        {
+                host_irq_raise(HOST_IRQ_EE_RDY, EE_RDY_vect);
+        }
+        else
+        {
+                host_irq_clear(HOST_IRQ_EE_RDY);
+        }
+}
+
+volatile uint8_t* host_eecr(void)
+{
+        ee_sync();
+        return &eecr;
+}
+
+volatile uint8_t* host_eedr(void)
+{
+        ee_sync();
+        return &eedr;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//  USART.  Bytes arrive and leave one frame time (10 bits at the rate set
+//  by UBRR and U2X) apart.  RXC and UDRE are level interrupts, re-checked
+//  whenever interrupts could be taken.
+//////////////////////////////////////////////////////////////////////////////
+
+static uint32_t uart_frame_cycles(void)
+{
+        uint32_t ubrr = ((uint32_t)(UBRRH & 0x0f) << 8 | UBRRL) + 1;
+        return 10 * ubrr * ((UCSRA & (1 << U2X)) ? 8 : 16);
+}
+
+static void uart_rx_event(void)
+{
+        if (uart_in_tail == uart_in_head)
+        {
+                return;
+        }
+        uint8_t ch = uart_in[uart_in_tail];
+        uart_in_tail = (uart_in_tail + 1) % UART_IN_SIZE;
+        if (UCSRB & (1 << RXEN))
+        {
+                host_stats.uart_rx_bytes++;
+                if (rx_full)
+                {
+                        UCSRA |= 1 << DOR;
+                        host_stats.uart_overruns++;
+                }
+                else
+                {
+                        rx_data = ch;
+                        rx_full = 1;
+                }
+        }
+        if (uart_in_tail != uart_in_head)
+        {
+                host_schedule(HOST_EVENT_UART_RX,
+                              cycles + uart_frame_cycles(), uart_rx_event);
+        }
+        uart_sync();
+}
+
+static void uart_tx_start(void);
+
+static void uart_tx_event(void)
+{
+        tx_shifting = 0;
+        UCSRA |= 1 << TXC;
+        if (tx_buffered)
+        {
+                uart_tx_start();
+        }
+        uart_sync();
+}
+
+static void uart_tx_start(void)
+{
+        uint8_t ch = tx_data;
+        tx_buffered = 0;
+        tx_shifting = 1;
+        host_stats.uart_tx_bytes++;
+        if (uart_fn)
+        {
+                uart_fn(ch);
+        }
+        host_schedule(HOST_EVENT_UART_TX, cycles + uart_frame_cycles(),
+                      uart_tx_event);
+}
+
+static void uart_sync(void)
+{
+        if (udr_accessed)
+        {
+                udr_accessed = 0;
+                if (!(udr & 0x100))
+                {
+                        if (UCSRB & (1 << TXEN) && !tx_buffered)
+                        {
+                                tx_data = (uint8_t)udr;
+                                tx_buffered = 1;
+                                if (!tx_shifting)
+                                {
+                                        uart_tx_start();
+                                }
+                        }
+                }
+                else
+                {
+                        rx_full = 0;
+                        UCSRA &= ~(1 << DOR);
+                }
+        }
+        UCSRA = (UCSRA & ~((1 << RXC) | (1 << UDRE)))
+                | (rx_full ? 1 << RXC : 0) | (tx_buffered ? 0 : 1 << UDRE);
+        if ((UCSRB & (1 << RXCIE)) && rx_full)
+        {
+                host_irq_raise(HOST_IRQ_USART_RXC, USART_RXC_vect);
+        }
+        else
+        {
+                host_irq_clear(HOST_IRQ_USART_RXC);
+        }
+        if ((UCSRB & (1 << UDRIE)) && !tx_buffered)
+        {
+                host_irq_raise(HOST_IRQ_USART_UDRE, USART_UDRE_vect);
+        }
+        else
+        {
+                host_irq_clear(HOST_IRQ_USART_UDRE);
+        }
+}
+
+volatile uint16_t* host_udr(void)
+{
+        uart_sync();
+        udr_accessed = 1;
+        udr = 0x100 | rx_data;
+        return &udr;
+}
+
+void host_uart_input(const uint8_t* data, size_t n)
+{
+        uint8_t idle = uart_in_tail == uart_in_head;
+        for (size_t i = 0; i < n; i++)
+        {
+                uint16_t next = (uart_in_head + 1) % UART_IN_SIZE;
+                if (next == uart_in_tail)
+                {
+                        break;
+                }
+                uart_in[uart_in_head] = data[i];
+                uart_in_head = next;
+        }
+        if (idle && uart_in_tail != uart_in_head)
+        {
+                host_schedule(HOST_EVENT_UART_RX,
+                              cycles + uart_frame_cycles(), uart_rx_event);
+        }
+}
+
+size_t host_uart_pending(void)
+{
+        return (uart_in_head - uart_in_tail + UART_IN_SIZE) % UART_IN_SIZE;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//  LCD
+//////////////////////////////////////////////////////////////////////////////
+
+static void lcd_record(HostLcdOp_t op, uint8_t value)
+{
+        host_stats.lcd_writes++;
+        if (lcd_fn)
+        {
+                host_lcd_record_t rec = { cycles, op, value, lcd_x, lcd_y };
+                lcd_fn(&rec);
+        }
+}
+
+// What a clear does to the model, whichever call sent it
+static void lcd_blank(void)
+{
+        for (int y = 0; y < HOST_LCD_ROWS; y++)
+        {
+                memset(host_lcd[y], ' ', HOST_LCD_COLS);
+                host_lcd[y][HOST_LCD_COLS] = '\0';
+        }
+        lcd_x = lcd_y = 0;
+        lcd_record(HOST_LCD_CLEAR, 0);
+}
+
+// Charged as one clear; the power-up waits are left out
+void LCD_init(void)
+{
+        host_charge(HOST_COST_LCD_CLEAR);
+        lcd_blank();
+}
+
+void LCD_goto(uint8_t x, uint8_t y)
+{
+        host_charge(HOST_COST_LCD_WRITE);
+        lcd_x = x;
+        lcd_y = y & 1;
+        lcd_record(HOST_LCD_GOTO, 0);
+}
+
+void LCD_write_command(uint8_t cmd)
+{
+        host_charge(HOST_COST_LCD_WRITE);
+        if (cmd == 0x01)
+        {
+                // Only the byte is charged; the caller waits out the clear
+                lcd_blank();
+                return;
+        }
+        lcd_record(HOST_LCD_COMMAND, cmd);
+}
+
+void LCD_write_data(uint8_t data)
+{
+        host_charge(HOST_COST_LCD_WRITE);
+        lcd_record(HOST_LCD_DATA, data);
+        if (lcd_x < HOST_LCD_COLS)
+        {
+                host_lcd[lcd_y][lcd_x] = data;
+        }
+        lcd_x++;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//  EEPROM
+//////////////////////////////////////////////////////////////////////////////
+
+extern uint8_t __start_host_eeprom[];
+extern uint8_t __stop_host_eeprom[];
+
+uint8_t* host_eeprom(size_t* n)
+{
+        *n = (size_t)(__stop_host_eeprom - __start_host_eeprom);
+        return __start_host_eeprom;
+}
+
+void eeprom_read_block(void* dst, const void* src, size_t n)
+{
+        host_charge((uint32_t)(n * HOST_COST_EEPROM_READ));
+        memcpy(dst, src, n);
+}
+
+void eeprom_write_block(const void* src, void* dst, size_t n)
+{
+        host_charge((uint32_t)(n * HOST_COST_EEPROM_WRITE));
+        host_stats.eeprom_bytes_written += n;
+        memcpy(dst, src, n);
+}
+
+void eeprom_update_block(const void* src, void* dst, size_t n)
+{
+        const uint8_t* s = src;
+        uint8_t* d = dst;
+        for (size_t i = 0; i < n; i++)
+        {
+                host_charge(HOST_COST_EEPROM_READ);
+                if (d[i] != s[i])
+                {
+                        eeprom_write_block(&s[i], &d[i], 1);
+                }
+        }
+}
+
+uint8_t eeprom_read_byte(const uint8_t* p)
+{
+        uint8_t v;
+        eeprom_read_block(&v, p, sizeof(v));
+        return v;
+}
+
+uint16_t eeprom_read_word(const uint16_t* p)
+{
+        uint16_t v;
+        eeprom_read_block(&v, p, sizeof(v));
+        return v;
+}
+
+uint32_t eeprom_read_dword(const uint32_t* p)
+{
+        uint32_t v;
+        eeprom_read_block(&v, p, sizeof(v));
+        return v;
+}
+
+void eeprom_write_byte(uint8_t* p, uint8_t value)
+{
+        eeprom_write_block(&value, p, sizeof(value));
+}
+
+void eeprom_write_word(uint16_t* p, uint16_t value)
+{
+        eeprom_write_block(&value, p, sizeof(value));
+}
+
+void eeprom_write_dword(uint32_t* p, uint32_t value)
+{
+        eeprom_write_block(&value, p, sizeof(value));
+}
@@ -0,0 +1,217 @@
+//////////////////////////////////////////////////////////////////////////////
+///
+///  \file host.h
+///
+///  \copy copyright (c) 2023 William R Cooke
+///
+///  @brief Host-native stand-ins for avrlib and avr-libc.
+///
+///  The firmware is compiled unchanged against the headers in this
+///  directory.  Every HAL call charges an estimated number of ATmega8
+///  cycles to a simulated clock, so SYSTICK time advances as the firmware
+///  works and a loop that does too much shows up as missed milliseconds.
+///  SPI words and LCD writes are recorded with the cycle they happened on.
+///
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef HOST_H
+#define HOST_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Simulated CPU clock, matches the firmware
+#define HOST_F_CPU            16000000UL
+#define HOST_CYCLES_PER_MS    (HOST_F_CPU / 1000UL)
+
+// Estimated costs of the avrlib calls, in CPU cycles.
+// SOFTSPI bit-bangs through GPIO_write_pin, roughly 50 cycles per bit.
+// The HD44780 needs ~40 us per data/command write, 1.52 ms to clear.
+#define HOST_COST_SPI_WORD        900
+#define HOST_COST_LCD_WRITE       640
+#define HOST_COST_LCD_CLEAR       24320
+#define HOST_COST_SYSTICK_READ    30
+#define HOST_COST_INPUT_READ      40
+#define HOST_COST_TIMER_READ      4       // TCNT1 low/high pair
+#define HOST_COST_EEPROM_READ     4
+#define HOST_COST_FLASH_READ      3       // LPM
+#define HOST_COST_EEPROM_WRITE    54400   // 3.4 ms per byte
+#define HOST_COST_ISR             60      // entry, register saves, reti
+#define HOST_COST_SPI_POLL        4       // IN, SBRS, RJMP on SPSR
+
+// ATmega8 interrupt vector numbers, lower runs first
+#define HOST_IRQ_INT0             1
+#define HOST_IRQ_INT1             2
+#define HOST_IRQ_TIMER2_COMP      3
+#define HOST_IRQ_TIMER2_OVF       4
+#define HOST_IRQ_TIMER1_CAPT      5
+#define HOST_IRQ_TIMER1_COMPA     6
+#define HOST_IRQ_TIMER1_COMPB     7
+#define HOST_IRQ_TIMER1_OVF       8
+#define HOST_IRQ_TIMER0_OVF       9
+#define HOST_IRQ_SPI_STC          10
+#define HOST_IRQ_USART_RXC        11
+#define HOST_IRQ_USART_UDRE       12
+#define HOST_IRQ_USART_TXC        13
+#define HOST_IRQ_EE_RDY           15
+
+// Timed peripheral events
+#define HOST_EVENT_SPI            0
+#define HOST_EVENT_ENCODER        1
+#define HOST_EVENT_UART_RX        2
+#define HOST_EVENT_UART_TX        3
+#define HOST_EVENT_TIMER1         4
+#define HOST_EVENT_EEPROM         5
+#define HOST_EVENT_TRIGGER        6
+#define HOST_EVENT_TIMER2         7
+#define HOST_EVENT_MAX            8
+
+// The DDS FSYNC lines, chip n on PORTC bit 5 - n, for the chips the
+// build drives; with one, PC4 is the trigger's sync output.  A word
+// clocked out with several low is recorded once for each, with iface n.
+#define HOST_DDS_FSYNC_BIT        5
+#ifdef AD9833_CHANNELS
+#define HOST_DDS_CHIPS            AD9833_CHANNELS
+#else
+#define HOST_DDS_CHIPS            1
+#endif
+
+typedef struct HOST_SPI_RECORD
+{
+        uint64_t cycle;
+        uint8_t  iface;
+        uint16_t word;
+} host_spi_record_t;
+
+typedef enum HOST_LCD_OP
+{
+        HOST_LCD_CLEAR,
+        HOST_LCD_GOTO,
+        HOST_LCD_DATA,
+        HOST_LCD_COMMAND
+} HostLcdOp_t;
+
+typedef struct HOST_LCD_RECORD
+{
+        uint64_t    cycle;
+        HostLcdOp_t op;
+        uint8_t     value;
+        uint8_t     x;
+        uint8_t     y;
+} host_lcd_record_t;
+
+typedef struct HOST_STATS
+{
+        uint64_t spi_words;
+        uint64_t lcd_writes;
+        uint64_t eeprom_bytes_written;
+        uint64_t idle_cycles;          // cycles spent polling an unchanged tick
+        uint64_t sleep_cycles;         // cycles spent in sleep_cpu()
+        uint64_t masked_cycles;        // cycles spent between cli() and sei()
+        uint64_t max_masked;           // longest cli()/sei() window
+        uint64_t passes;               // times the firmware saw a new tick
+        uint64_t missed_ticks;         // ticks that were never observed
+        uint64_t uart_rx_bytes;
+        uint64_t uart_tx_bytes;
+        uint64_t uart_overruns;        // bytes lost because RXC was still set
+        uint64_t dds_on_cycle;         // first DDS control word out of reset
+        uint64_t input_events;         // keys and button presses scripted
+        uint64_t input_dropped;        // lost to a full driver FIFO
+} host_stats_t;
+
+// 2x16 character display as the HD44780 would show it
+#define HOST_LCD_COLS   16
+#define HOST_LCD_ROWS   2
+extern uint8_t host_lcd[HOST_LCD_ROWS][HOST_LCD_COLS + 1];
+
+extern host_stats_t host_stats;
+
+// Global interrupt enable, set by sei() and cleared by cli()
+extern volatile uint8_t host_sreg_i;
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn host_charge
+/// @brief Advances the simulated clock.
+/// @param[in] cycles  CPU cycles the current operation takes.
+//////////////////////////////////////////////////////////////////////////////
+void host_charge(uint32_t cycles);
+
+uint64_t host_cycles(void);
+
+uint32_t host_milliseconds(void);
+
+void host_cli(void);
+
+void host_sei(void);
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn host_sleep
+/// @brief sleep_cpu(): runs the clock until an interrupt is taken or the
+///        next millisecond starts.  Does nothing unless sleep_enable()d.
+//////////////////////////////////////////////////////////////////////////////
+void host_sleep(void);
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn host_schedule
+/// @brief Calls fn when the simulated clock reaches cycle at.
+/// @param[in] id  HOST_EVENT_ slot; rescheduling a slot replaces it.
+//////////////////////////////////////////////////////////////////////////////
+void host_schedule(uint8_t id, uint64_t at, void (*fn)(void));
+
+void host_cancel(uint8_t id);
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn host_irq_raise
+/// @brief Marks interrupt n pending; vector runs once interrupts are on.
+/// @param[in] n       HOST_IRQ_ number.
+/// @param[in] vector  Handler, nothing happens if NULL.
+//////////////////////////////////////////////////////////////////////////////
+void host_irq_raise(uint8_t n, void (*vector)(void));
+
+void host_irq_clear(uint8_t n);
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn host_run
+/// @brief Runs fw_main for a number of simulated milliseconds.
+/// @param[in] fw_main   The firmware entry point; it need not return.
+/// @param[in] ms        Simulated run time.
+/// @param[in] on_tick   Called once per simulated millisecond, may be NULL.
+//////////////////////////////////////////////////////////////////////////////
+void host_run(int (*fw_main)(int, char**), uint32_t ms,
+              void (*on_tick)(uint32_t ms));
+
+// Scripted input
+void host_press_key(char ch);
+void host_press_button(int button);
+// Plays out 4 quadrature edges per detent on PD2/PD3 over the next ms
+void host_turn_encoder(int32_t detents);
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn host_trigger
+/// @brief Drives ICP1 (PB0) high delay cycles from now, and low again
+///        width cycles later.  Timer1 captures whichever edge ICES1 picks.
+//////////////////////////////////////////////////////////////////////////////
+void host_trigger(uint32_t delay, uint32_t width);
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn host_uart_input
+/// @brief Queues bytes for the USART receiver, one per frame time.
+//////////////////////////////////////////////////////////////////////////////
+void host_uart_input(const uint8_t* data, size_t n);
+
+// Bytes queued by host_uart_input() not yet received
+size_t host_uart_pending(void);
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn host_eeprom
+/// @brief The firmware's EEMEM variables, in link order.
+/// @param[out] n  Bytes.
+//////////////////////////////////////////////////////////////////////////////
+uint8_t* host_eeprom(size_t* n);
+
+// Traces, NULL to disable.  Records are appended as they happen.
+void host_trace_spi(void (*fn)(const host_spi_record_t* rec));
+void host_trace_lcd(void (*fn)(const host_lcd_record_t* rec));
+void host_trace_uart(void (*fn)(uint8_t ch));
+
+#endif  // #ifndef HOST_H
@@ -0,0 +1,20 @@
+//////////////////////////////////////////////////////////////////////////////
+///
+///  \file keypad.h
+///
+///  \copy copyright (c) 2023 William R Cooke
+///
+///  @brief Host stand-in for avrlib KEYPAD.
+///
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef HOST_KEYPAD_H
+#define HOST_KEYPAD_H
+
+#include <stdint.h>
+
+void KEYPAD_init(void);
+int KEYPAD_waiting(void);
+int KEYPAD_get_key(void);
+
+#endif  // #ifndef HOST_KEYPAD_H
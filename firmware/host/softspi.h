@@ -0,0 +1,36 @@
+//////////////////////////////////////////////////////////////////////////////
+///
+///  \file softspi.h
+///
+///  \copy copyright (c) 2023 William R Cooke
+///
+///  @brief Host stand-in for avrlib SOFTSPI; records every word.
+///
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef HOST_SOFTSPI_H
+#define HOST_SOFTSPI_H
+
+#include <stdint.h>
+
+#include "gpio.h"
+
+typedef enum SPI_MODE
+{
+        SPI_MODE_0_MSB_FIRST,
+        SPI_MODE_1_MSB_FIRST,
+        SPI_MODE_2_MSB_FIRST,
+        SPI_MODE_3_MSB_FIRST,
+        SPI_MODE_0_LSB_FIRST,
+        SPI_MODE_1_LSB_FIRST,
+        SPI_MODE_2_LSB_FIRST,
+        SPI_MODE_3_LSB_FIRST
+} SpiMode_t;
+
+void SOFTSPI_init(void);
+void SOFTSPI_init2(void);
+void SOFTSPI_set_interface(uint8_t iface, GpioPin_t ss, uint8_t bits,
+                           SpiMode_t mode, uint8_t delay);
+uint32_t SOFTSPI_write(uint8_t iface, uint32_t data);
+
+#endif  // #ifndef HOST_SOFTSPI_H
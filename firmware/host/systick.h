@@ -0,0 +1,29 @@
+//////////////////////////////////////////////////////////////////////////////
+///
+///  \file systick.h
+///
+///  \copy copyright (c) 2023 William R Cooke
+///
+///  @brief Host stand-in for avrlib SYSTICK, driven by the simulated clock.
+///
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef HOST_SYSTICK_H
+#define HOST_SYSTICK_H
+
+#include <stdint.h>
+
+typedef enum CLK_DIV
+{
+        CLK_DIV_1,
+        CLK_DIV_8,
+        CLK_DIV_64,
+        CLK_DIV_256,
+        CLK_DIV_1024
+} ClkDiv_t;
+
+void SYSTICK_init(ClkDiv_t div);
+uint32_t SYSTICK_get_milliseconds(void);
+uint32_t SYSTICK_get_ticks(void);
+
+#endif  // #ifndef HOST_SYSTICK_H
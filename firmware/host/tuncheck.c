@@ -0,0 +1,566 @@
+//////////////////////////////////////////////////////////////////////////////
+///
+///  \file tuncheck.c
+///
+///  \copy copyright (c) 2023 William R Cooke
+///
+///  @brief Checks Hz to tuning word conversions against the exact value.
+///
+///  Usage: tuncheck [-f max_hz] [-c ppm,...] [-j threads] [-s step]
+///
+///  -f  check 1 Hz up to, not including, this; default 11000000, the
+///      firmware's MAX_OUTPUT_FREQ
+///  -c  master clock calibrations to check, each a ppm value or a
+///      lo:hi range; default -100,-10,-1,0,1,10,100
+///  -j  worker threads, default one per core
+///  -s  millihertz between the frequencies TUNING_freq_to_word() is
+///      checked at, default 997; 1 checks every one
+///
+///  Every frequency goes through each candidate conversion, the
+///  firmware's TUNING_hz_to_word() from tuning.c among them, for the
+///  master clock TUNING_set_ppm() gives at each calibration.  The word's
+///  error against the exact hz * 2^28 / mclk is measured in LSBs of the
+///  tuning word, without rounding: the residual (hz << 28) - word * mclk
+///  is exact in 64 bits, and a word is the exact floor when that is in
+///  [0, mclk).  The range is split into blocks handed out to the threads,
+///  and the residuals are worked out eight lanes at a time.
+///
+///  TUNING_freq_to_word() is checked the same way over millihertz, with
+///  the residual (f << 28) - word * 1000 * mclk, from 1 mHz up to max_hz
+///  in steps of -s.  It keeps its last result in globals, so that pass
+///  runs on the main thread.  Each frequency is converted twice, the
+///  second time from the cache, and each calibration starts with the
+///  frequency the previous one ended on, which only converts right if
+///  TUNING_set_ppm() dropped the cached word.
+///
+///  For each clock and candidate it prints the verdict, the worst error
+///  in Hz and where, how many words read back as the frequency through the
+///  candidate's word to Hz conversion, and a histogram of the error from
+///  -1 to +1 LSB.  The exit status is 1 if either firmware conversion is
+///  not exact at every clock.
+///
+//////////////////////////////////////////////////////////////////////////////
+
+#define _DEFAULT_SOURCE
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "avr/eeprom.h"
+#include "eewrite.h"
+#include "tuning.h"
+
+#define NOMINAL_HZ      25000000UL    // MASTER_CLOCK in softrock33.c
+#define MAX_HZ          11000000UL    // MAX_OUTPUT_FREQ in softrock33.c
+#define FREQ_STEP       997           // mHz, prime so every fraction is hit
+#define MAX_CLOCKS      512
+#define MAX_THREADS     64
+
+// Frequencies per unit of work, a multiple of LANES
+#define BLOCK           4096
+#define LANES           8
+
+// Histogram of error in LSBs: BINS from -1 to +1, plus one each side
+#define BINS            10
+
+typedef uint32_t v8u32 __attribute__((vector_size(4 * LANES)));
+typedef uint64_t v8u64 __attribute__((vector_size(8 * LANES)));
+typedef int64_t  v8i64 __attribute__((vector_size(8 * LANES)));
+typedef double   v8df  __attribute__((vector_size(8 * LANES)));
+
+typedef enum ROUNDING
+{
+        ROUND_FLOOR,            // passes if every word is the exact floor
+        ROUND_NEAREST           // passes if every word is within 1/2 LSB
+} Rounding_t;
+
+typedef struct CANDIDATE
+{
+        const char* name;
+        Rounding_t  rounding;
+        void      (*words)(const uint32_t* hz, uint32_t* w, int n,
+                           uint32_t mclk);
+        uint32_t  (*hz)(uint32_t w, uint32_t mclk);   // read back, or NULL
+} candidate_t;
+
+typedef struct STATS
+{
+        uint64_t count;
+        uint64_t fails;
+        uint64_t readback;      // words that read back as the frequency
+        uint64_t hist[BINS + 2];
+        int64_t  worst;         // residual furthest from zero
+        uint64_t worst_at;      // in Hz, or mHz for TUNING_freq_to_word()
+} stats_t;
+
+//////////////////////////////////////////////////////////////////////////////
+//  tuning.c reads its calibration from EEPROM at TUNING_init(); here the
+//  EEPROM is always erased, so it starts at 0 ppm, and nothing is saved.
+//////////////////////////////////////////////////////////////////////////////
+
+void eeprom_read_block(void* dst, const void* src, size_t n)
+{
+        (void)src;
+        memset(dst, 0xff, n);
+}
+
+uint8_t EEWRITE_queue(void* dst, const void* src, uint8_t n)
+{
+        (void)dst;
+        (void)src;
+        (void)n;
+        return 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//  Candidates
+//////////////////////////////////////////////////////////////////////////////
+
+// The firmware's conversion; TUNING_set_ppm() has set the clock
+static void firmware_words(const uint32_t* hz, uint32_t* w, int n,
+                           uint32_t mclk)
+{
+        (void)mclk;
+        for (int i = 0; i < n; i++)
+        {
+                w[i] = TUNING_hz_to_word(hz[i]);
+        }
+}
+
+static uint32_t firmware_hz(uint32_t w, uint32_t mclk)
+{
+        (void)mclk;
+        return TUNING_word_to_hz(w);
+}
+
+// docs/calc.c: a true floor, but always of the nominal clock
+static void calc_words(const uint32_t* hz, uint32_t* w, int n,
+                       uint32_t mclk)
+{
+        (void)mclk;
+        for (int i = 0; i < n; i++)
+        {
+                w[i] = (uint32_t)(((uint64_t)hz[i] << 28) / NOMINAL_HZ);
+        }
+}
+
+// docs/calc.c reads words back rounding up, where the firmware floors
+static uint32_t calc_hz(uint32_t w, uint32_t mclk)
+{
+        (void)mclk;
+        return (uint32_t)((NOMINAL_HZ * (uint64_t)w + 0x0fffffff) >> 28);
+}
+
+// The closest word there is, for reference
+static void nearest_words(const uint32_t* hz, uint32_t* w, int n,
+                          uint32_t mclk)
+{
+        for (int i = 0; i < n; i++)
+        {
+                w[i] = (uint32_t)((((uint64_t)hz[i] << 28) + mclk / 2)
+                                  / mclk);
+        }
+}
+
+static uint32_t nearest_hz(uint32_t w, uint32_t mclk)
+{
+        return (uint32_t)(((uint64_t)w * mclk + (1UL << 27)) >> 28);
+}
+
+// A single precision scale factor, the obvious shortcut
+static void float_words(const uint32_t* hz, uint32_t* w, int n,
+                        uint32_t mclk)
+{
+        float k = 268435456.0f / (float)mclk;
+        for (int i = 0; i < n; i++)
+        {
+                w[i] = (uint32_t)((float)hz[i] * k);
+        }
+}
+
+// Reported for the millihertz pass, which has a loop of its own
+static const candidate_t freq_candidate =
+{
+        "fw mHz", ROUND_FLOOR, NULL, NULL
+};
+
+static const candidate_t candidates[] =
+{
+        { "firmware", ROUND_FLOOR,   firmware_words, firmware_hz },
+        { "calc.c",   ROUND_FLOOR,   calc_words,     calc_hz },
+        { "nearest",  ROUND_NEAREST, nearest_words,  nearest_hz },
+        { "float",    ROUND_FLOOR,   float_words,    NULL },
+};
+
+#define CANDIDATES      (int)(sizeof(candidates) / sizeof(candidates[0]))
+
+//////////////////////////////////////////////////////////////////////////////
+//  Evaluation
+//////////////////////////////////////////////////////////////////////////////
+
+// Adds lane values r (residual), bin and bad to st
+static void tally(stats_t* st, int64_t r, int64_t bin, int64_t bad,
+                  uint64_t at)
+{
+        if (bin < 0)
+        {
+                bin = 0;
+        }
+        else if (bin > BINS + 1)
+        {
+                bin = BINS + 1;
+        }
+        st->hist[bin]++;
+        st->fails += bad != 0;
+        int64_t a = r < 0 ? -r : r;
+        int64_t b = st->worst < 0 ? -st->worst : st->worst;
+        if (a > b)
+        {
+                st->worst = r;
+                st->worst_at = at;
+        }
+}
+
+// Error in LSBs is e = -r / mclk, where r = (hz << 28) - w * mclk.
+// Histogram bin 1 + (e + 1) * BINS / 2 puts e = -1 in bin 1 and e = +1
+// in bin BINS + 1; bin 0 holds anything below -1 LSB.
+static void evaluate(const uint32_t* hz, const uint32_t* w, int n,
+                     uint32_t mclk, Rounding_t rounding, stats_t* st)
+{
+        const int64_t m = mclk;
+        const double scale = -(double)BINS / 2 / (double)mclk;
+        int i = 0;
+        for (; i + LANES <= n; i += LANES)
+        {
+                v8u32 h32;
+                v8u32 w32;
+                memcpy(&h32, hz + i, sizeof(h32));
+                memcpy(&w32, w + i, sizeof(w32));
+                v8u64 h = __builtin_convertvector(h32, v8u64);
+                v8u64 wd = __builtin_convertvector(w32, v8u64);
+                v8i64 r = (v8i64)((h << 28) - wd * (uint64_t)mclk);
+                v8i64 bad;
+                if (rounding == ROUND_FLOOR)
+                {
+                        bad = (r < 0) | (r >= m);
+                }
+                else
+                {
+                        bad = (2 * r > m) | (2 * r < -m);
+                }
+                v8df e = __builtin_convertvector(r, v8df) * scale
+                        + (double)(BINS / 2 + 1);
+                v8i64 bin = __builtin_convertvector(e, v8i64);
+                for (int j = 0; j < LANES; j++)
+                {
+                        tally(st, r[j], bin[j], bad[j], hz[i + j]);
+                }
+        }
+        for (; i < n; i++)
+        {
+                int64_t r = (int64_t)(((uint64_t)hz[i] << 28)
+                                      - (uint64_t)w[i] * mclk);
+                int64_t bad = rounding == ROUND_FLOOR ? r < 0 || r >= m
+                        : 2 * r > m || 2 * r < -m;
+                double e = (double)r * scale + (double)(BINS / 2 + 1);
+                tally(st, r, (int64_t)e, bad, hz[i]);
+        }
+        st->count += n;
+}
+
+// One TUNING_freq_to_word(), and again from its cache, against the exact
+// f * 2^28 / d with d = 1000 * mclk, in LSBs as evaluate() does
+static void check_one(uint64_t f, uint64_t d, stats_t* st)
+{
+        const double scale = -(double)BINS / 2 / (double)d;
+        uint32_t w = TUNING_freq_to_word(f);
+        // f * 2^28 is under 2^62 and w * d under 2^63
+        int64_t r = (int64_t)((f << 28) - (uint64_t)w * d);
+        int64_t bad = r < 0 || r >= (int64_t)d
+                || TUNING_freq_to_word(f) != w;
+        double e = (double)r * scale + (double)(BINS / 2 + 1);
+        tally(st, r, (int64_t)e, bad, f);
+        st->count++;
+}
+
+// Every step-th mHz below max_mhz.  The conversion's cache is shared, so
+// this runs on one thread.
+static void check_freq(uint64_t max_mhz, uint32_t step, uint32_t mclk,
+                       stats_t* st)
+{
+        static uint64_t last;     // the previous clock's last frequency
+        const uint64_t d = (uint64_t)mclk * 1000;
+        if (last)
+        {
+                // Still cached unless TUNING_set_ppm() dropped it
+                check_one(last, d, st);
+        }
+        for (uint64_t f = 1; f < max_mhz; f += step)
+        {
+                check_one(f, d, st);
+                last = f;
+        }
+}
+
+typedef struct JOB
+{
+        uint32_t mclk;
+        uint32_t max_hz;
+        uint32_t blocks;
+        uint32_t next;          // next block, taken atomically
+} job_t;
+
+typedef struct WORKER
+{
+        pthread_t thread;
+        job_t*    job;
+        stats_t   st[CANDIDATES];
+} worker_t;
+
+static void* work(void* arg)
+{
+        worker_t* wk = arg;
+        job_t* job = wk->job;
+        static __thread uint32_t hz[BLOCK];
+        static __thread uint32_t w[BLOCK];
+        while (1)
+        {
+                uint32_t b = __atomic_fetch_add(&job->next, 1,
+                                                __ATOMIC_RELAXED);
+                if (b >= job->blocks)
+                {
+                        break;
+                }
+                uint32_t lo = 1 + b * BLOCK;
+                int n = job->max_hz - lo < BLOCK ? (int)(job->max_hz - lo)
+                        : BLOCK;
+                for (int i = 0; i < n; i++)
+                {
+                        hz[i] = lo + i;
+                }
+                for (int c = 0; c < CANDIDATES; c++)
+                {
+                        const candidate_t* cd = &candidates[c];
+                        stats_t* st = &wk->st[c];
+                        cd->words(hz, w, n, job->mclk);
+                        evaluate(hz, w, n, job->mclk, cd->rounding, st);
+                        if (cd->hz)
+                        {
+                                for (int i = 0; i < n; i++)
+                                {
+                                        st->readback +=
+                                                cd->hz(w[i], job->mclk)
+                                                == hz[i];
+                                }
+                        }
+                }
+        }
+        return NULL;
+}
+
+static void merge(stats_t* to, const stats_t* from)
+{
+        int64_t a = from->worst < 0 ? -from->worst : from->worst;
+        int64_t b = to->worst < 0 ? -to->worst : to->worst;
+        to->count += from->count;
+        to->fails += from->fails;
+        to->readback += from->readback;
+        for (int i = 0; i < BINS + 2; i++)
+        {
+                to->hist[i] += from->hist[i];
+        }
+        if (a > b || (a == b && from->worst_at < to->worst_at))
+        {
+                to->worst = from->worst;
+                to->worst_at = from->worst_at;
+        }
+}
+
+// per_hz is 1 for a pass over Hz, 1000 for one over mHz
+static void report(const candidate_t* cd, const stats_t* st,
+                   uint32_t per_hz)
+{
+        // An LSB is mclk / 2^28, about 0.093 Hz
+        printf("  %-9s %-7s %s  worst %+.4f Hz at %.*f Hz",
+               cd->name, cd->rounding == ROUND_FLOOR ? "floor" : "nearest",
+               st->fails ? "FAIL" : "pass",
+               -(double)st->worst / per_hz / (1UL << 28),
+               per_hz == 1 ? 0 : 3, (double)st->worst_at / per_hz);
+        if (st->fails)
+        {
+                printf(", %llu wrong", (unsigned long long)st->fails);
+        }
+        if (cd->hz)
+        {
+                printf(", reads back %.1f %%",
+                       100.0 * st->readback / st->count);
+        }
+        printf("\n            -1 [");
+        for (int i = 1; i <= BINS; i++)
+        {
+                printf("%5.1f", 100.0 * st->hist[i] / st->count);
+        }
+        printf(" ] +1 LSB, %% of words");
+        if (st->hist[0] || st->hist[BINS + 1])
+        {
+                printf(", %llu below, %llu above",
+                       (unsigned long long)st->hist[0],
+                       (unsigned long long)st->hist[BINS + 1]);
+        }
+        printf("\n");
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//  Options
+//////////////////////////////////////////////////////////////////////////////
+
+// Parses "a,b,lo:hi,..." into ppm[], returns the count or -1
+static int parse_clocks(const char* s, int16_t* ppm)
+{
+        int n = 0;
+        while (*s)
+        {
+                char* end;
+                long lo = strtol(s, &end, 10);
+                long hi = lo;
+                if (end == s)
+                {
+                        return -1;
+                }
+                if (*end == ':')
+                {
+                        s = end + 1;
+                        hi = strtol(s, &end, 10);
+                        if (end == s)
+                        {
+                                return -1;
+                        }
+                }
+                if (lo < -1000 || hi > 1000 || hi < lo)
+                {
+                        return -1;
+                }
+                for (long p = lo; p <= hi; p++)
+                {
+                        if (n == MAX_CLOCKS)
+                        {
+                                return -1;
+                        }
+                        ppm[n++] = (int16_t)p;
+                }
+                s = *end == ',' ? end + 1 : end;
+                if (*end && *end != ',')
+                {
+                        return -1;
+                }
+        }
+        return n;
+}
+
+static void usage(const char* prog)
+{
+        fprintf(stderr, "usage: %s [-f max_hz] [-c ppm,lo:hi,...] "
+                "[-j threads] [-s step_mhz]\n", prog);
+        exit(2);
+}
+
+int main(int argc, char** argv)
+{
+        static int16_t ppm[MAX_CLOCKS];
+        static worker_t workers[MAX_THREADS];
+        uint32_t max_hz = MAX_HZ;
+        uint32_t step = FREQ_STEP;
+        int clocks = parse_clocks("-100,-10,-1,0,1,10,100", ppm);
+        long threads = sysconf(_SC_NPROCESSORS_ONLN);
+        int opt;
+
+        while ((opt = getopt(argc, argv, "f:c:j:s:")) != -1)
+        {
+                switch (opt)
+                {
+                case 'f':
+                        max_hz = (uint32_t)strtoul(optarg, NULL, 0);
+                        break;
+                case 'c':
+                        clocks = parse_clocks(optarg, ppm);
+                        break;
+                case 'j':
+                        threads = strtol(optarg, NULL, 0);
+                        break;
+                case 's':
+                        step = (uint32_t)strtoul(optarg, NULL, 0);
+                        break;
+                default:
+                        usage(argv[0]);
+                }
+        }
+        if (max_hz < 2 || max_hz > 0x10000000UL || clocks <= 0 || step < 1)
+        {
+                usage(argv[0]);
+        }
+        if (threads < 1)
+        {
+                threads = 1;
+        }
+        if (threads > MAX_THREADS)
+        {
+                threads = MAX_THREADS;
+        }
+
+        struct timespec t0;
+        struct timespec t1;
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        printf("tuncheck: 1 to %u Hz, every %u mHz, %d clocks, "
+               "%ld threads\n", max_hz - 1, step, clocks, threads);
+
+        TUNING_init(NOMINAL_HZ);
+        int firmware_ok = 1;
+        for (int k = 0; k < clocks; k++)
+        {
+                // The firmware's clock for this calibration is the truth;
+                // workers only read tuning.c's state
+                TUNING_set_ppm(ppm[k]);
+                job_t job =
+                {
+                        TUNING_get_clock(), max_hz,
+                        (max_hz - 1 + BLOCK - 1) / BLOCK, 0
+                };
+                for (long t = 0; t < threads; t++)
+                {
+                        memset(workers[t].st, 0, sizeof(workers[t].st));
+                        workers[t].job = &job;
+                        pthread_create(&workers[t].thread, NULL, work,
+                                       &workers[t]);
+                }
+                stats_t total[CANDIDATES];
+                memset(total, 0, sizeof(total));
+                for (long t = 0; t < threads; t++)
+                {
+                        pthread_join(workers[t].thread, NULL);
+                        for (int c = 0; c < CANDIDATES; c++)
+                        {
+                                merge(&total[c], &workers[t].st[c]);
+                        }
+                }
+                printf("mclk %u Hz (%+d ppm)\n", job.mclk, ppm[k]);
+                for (int c = 0; c < CANDIDATES; c++)
+                {
+                        report(&candidates[c], &total[c], 1);
+                }
+                stats_t freq;
+                memset(&freq, 0, sizeof(freq));
+                check_freq((uint64_t)max_hz * 1000, step, job.mclk, &freq);
+                report(&freq_candidate, &freq, 1000);
+                firmware_ok &= total[0].fails == 0 && freq.fails == 0;
+        }
+
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        printf("firmware conversions %s at every clock, %.2f s\n",
+               firmware_ok ? "exact" : "NOT exact",
+               (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9);
+        return firmware_ok ? 0 : 1;
+}
@@ -0,0 +1,39 @@
+//////////////////////////////////////////////////////////////////////////////
+///
+///  \file util/atomic.h
+///
+///  \copy copyright (c) 2023 William R Cooke
+///
+///  @brief Host stand-in for avr-libc ATOMIC_BLOCK.
+///
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef HOST_UTIL_ATOMIC_H
+#define HOST_UTIL_ATOMIC_H
+
+#include <avr/interrupt.h>
+
+#define ATOMIC_RESTORESTATE   host_sreg_i
+#define ATOMIC_FORCEON        1
+
+static inline uint8_t host_atomic_enter(void)
+{
+        cli();
+        return 1;
+}
+
+static inline void host_atomic_exit(const uint8_t* restore)
+{
+        if (*restore)
+        {
+                sei();
+        }
+}
+
+#define ATOMIC_BLOCK(type)                                              \
+        for (uint8_t host_restore                                      \
+                     __attribute__((cleanup(host_atomic_exit))) = (type), \
+                     host_once = host_atomic_enter();                  \
+             host_once; host_once = 0)
+
+#endif  // #ifndef HOST_UTIL_ATOMIC_H
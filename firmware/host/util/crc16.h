@@ -0,0 +1,25 @@
+//////////////////////////////////////////////////////////////////////////////
+///
+///  \file util/crc16.h
+///
+///  \copy copyright (c) 2023 William R Cooke
+///
+///  @brief Host stand-in for the avr-libc CRC helpers the firmware uses.
+///
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef HOST_UTIL_CRC16_H
+#define HOST_UTIL_CRC16_H
+
+#include <stdint.h>
+
+// CRC-CCITT, polynomial 0x8408 reflected, as avr-libc's C equivalent
+static inline uint16_t _crc_ccitt_update(uint16_t crc, uint8_t data)
+{
+        data ^= (uint8_t)crc;
+        data ^= (uint8_t)(data << 4);
+        return (uint16_t)((((uint16_t)data << 8) | (crc >> 8))
+                          ^ (uint8_t)(data >> 4) ^ ((uint16_t)data << 3));
+}
+
+#endif  // #ifndef HOST_UTIL_CRC16_H
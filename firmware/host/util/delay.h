@@ -0,0 +1,19 @@
+//////////////////////////////////////////////////////////////////////////////
+///
+///  \file util/delay.h
+///
+///  \copy copyright (c) 2023 William R Cooke
+///
+///  @brief Host stand-in for avr-libc busy-wait delays.
+///
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef HOST_UTIL_DELAY_H
+#define HOST_UTIL_DELAY_H
+
+#include "host.h"
+
+#define _delay_ms(ms)   host_charge((uint32_t)((ms) * (F_CPU / 1000.0)))
+#define _delay_us(us)   host_charge((uint32_t)((us) * (F_CPU / 1000000.0)))
+
+#endif  // #ifndef HOST_UTIL_DELAY_H
@@ -0,0 +1,90 @@
+//////////////////////////////////////////////////////////////////////////////
+///
+///  \file input.c
+///
+///  \copy copyright (c) 2023 William R Cooke
+///
+///  @brief Timestamped queue of keypad and button events.
+///
+//////////////////////////////////////////////////////////////////////////////
+
+#include <stdint.h>
+#include "button.h"
+#include "keypad.h"
+#include "input.h"
+#include "ring.h"
+
+RING_CHECK(INPUT_SIZE);
+
+static input_event_t    queue[INPUT_SIZE];
+static volatile uint8_t head;       // next free slot, moved by the producer
+static volatile uint8_t tail;       // oldest event, moved by the consumer
+static uint8_t          peak;
+
+void INPUT_init(void)
+{
+        head = tail = 0;
+        peak = 0;
+}
+
+static uint8_t room(void)
+{
+        return RING_ROOM(head, tail, INPUT_SIZE);
+}
+
+static void put(uint32_t now_ms, uint8_t type, int code)
+{
+        input_event_t* ev = &queue[head];
+        ev->ms = now_ms;
+        ev->type = type;
+        ev->code = (uint8_t)code;
+        head = RING_NEXT(head, INPUT_SIZE);
+}
+
+uint8_t INPUT_collect(uint32_t now_ms)
+{
+        uint8_t n = 0;
+        // Button first, as the old loop read it
+        while (room() && BUTTON_waiting())
+        {
+                int b = BUTTON_get_button();
+                if (b < 0)
+                {
+                        break;
+                }
+                put(now_ms, INPUT_BUTTON, b);
+                n++;
+        }
+        while (room() && KEYPAD_waiting())
+        {
+                int k = KEYPAD_get_key();
+                if (k < 0)
+                {
+                        break;
+                }
+                put(now_ms, INPUT_KEY, k);
+                n++;
+        }
+        uint8_t waiting = RING_USED(head, tail, INPUT_SIZE);
+        if (waiting > peak)
+        {
+                peak = waiting;
+        }
+        return n;
+}
+
+uint8_t INPUT_get(input_event_t* ev)
+{
+        if (tail == head)
+        {
+                return 0;
+        }
+        *ev = queue[tail];
+        tail = RING_NEXT(tail, INPUT_SIZE);
+        return 1;
+}
+
+uint8_t INPUT_peak(void)
+{
+        return peak;
+}
@@ -0,0 +1,79 @@
+//////////////////////////////////////////////////////////////////////////////
+///
+///  \file input.h
+///
+///  \copy copyright (c) 2023 William R Cooke
+///
+///  @brief Timestamped queue of keypad and button events.
+///
+///  The avrlib keypad and button drivers scan from the systick interrupt
+///  into FIFOs only 8 and 4 deep.  INPUT_collect(), called from the
+///  highest priority task, empties them on every tick into this queue
+///  with the SYSTICK time of the pass, and the state machine takes
+///  events from it when it gets to them.  A pass that runs long or is
+///  cut short no longer costs presses: they wait here, in order.
+///
+///  One producer and one consumer, each owning its own index, so neither
+///  side needs interrupts off.
+///
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef INPUT_H
+#define INPUT_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+
+// Events waiting, a power of 2
+#define INPUT_SIZE         16
+
+        typedef enum INPUT_TYPE
+        {
+                INPUT_KEY,              // code is the KEYPAD_get_key() code
+                INPUT_BUTTON            // code is the button number
+        } InputType_t;
+
+        typedef struct INPUT_EVENT
+        {
+                uint32_t ms;            // SYSTICK time it was collected
+                uint8_t  type;          // InputType_t
+                uint8_t  code;
+        } input_event_t;
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn INPUT_init
+/// @brief Empties the queue.  BUTTON_init() and KEYPAD_init() are still
+///        called by the application.
+//////////////////////////////////////////////////////////////////////////////
+        void INPUT_init(void);
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn INPUT_collect
+/// @brief Moves every waiting button press and key into the queue.  If
+///        the queue fills, the rest stay in the drivers until next time.
+/// @param[in] now_ms  Stamp for the events.
+/// @return Events added.
+//////////////////////////////////////////////////////////////////////////////
+        uint8_t INPUT_collect(uint32_t now_ms);
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn INPUT_get
+/// @param[out] ev  The oldest event, valid when 1 is returned.
+/// @return 1 if an event was taken, 0 if the queue is empty.
+//////////////////////////////////////////////////////////////////////////////
+        uint8_t INPUT_get(input_event_t* ev);
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn INPUT_peak
+/// @return Most events that have been waiting at once.
+//////////////////////////////////////////////////////////////////////////////
+        uint8_t INPUT_peak(void);
+
+#ifdef __cplusplus
+}
+#endif  // __cplusplus
+#endif  // #ifndef INPUT_H
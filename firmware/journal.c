@@ -0,0 +1,178 @@
+//////////////////////////////////////////////////////////////////////////////
+///
+///  \file journal.c
+///
+///  \copy copyright (c) 2023 William R Cooke
+///
+///  @brief Wear-levelled settings journal in EEPROM.
+///
+//////////////////////////////////////////////////////////////////////////////
+
+#include <stdint.h>
+#include <avr/eeprom.h>
+#include <util/crc16.h>
+#include "eewrite.h"
+#include "journal.h"
+
+// Record: 4 byte tag (sequence << 4 | slot), data, 2 byte CRC
+#define TAG_BYTES       4
+#define CRC_BYTES       2
+#define RECORD_MAX      (TAG_BYTES + JOURNAL_DATA_MAX + CRC_BYTES)
+#define NONE            0xff
+
+static uint8_t journal[JOURNAL_BYTES] EEMEM;
+
+static uint8_t  size;               // data bytes, 0 if the journal is off
+static uint8_t  record_size;
+static uint8_t  records;
+static uint8_t  where[JOURNAL_SLOTS];   // record holding each slot's newest
+static uint8_t  next_record;        // where the next write starts looking
+static uint32_t next_seq;
+static uint16_t seed;               // CRC start, from the layout
+
+static uint16_t crc(const uint8_t* p, uint8_t n)
+{
+        uint16_t c = seed;
+        while (n--)
+        {
+                c = _crc_ccitt_update(c, *p++);
+        }
+        return c;
+}
+
+// Reads record r into rec, returns its tag, or 0xffffffff if it is bad
+static uint32_t load(uint8_t r, uint8_t* rec)
+{
+        eeprom_read_block(rec, &journal[r * record_size], record_size);
+        uint32_t tag = (uint32_t)rec[0] | (uint32_t)rec[1] << 8
+                | (uint32_t)rec[2] << 16 | (uint32_t)rec[3] << 24;
+        uint8_t n = record_size - CRC_BYTES;
+        uint16_t stored = rec[n] | (uint16_t)rec[n + 1] << 8;
+        // Erased EEPROM has slot 15, which is out of range
+        if ((tag & 0x0f) >= JOURNAL_SLOTS || crc(rec, n) != stored)
+        {
+                return 0xffffffff;
+        }
+        return tag;
+}
+
+uint8_t JOURNAL_init(uint8_t n, uint8_t key)
+{
+        uint8_t rec[RECORD_MAX];
+        uint32_t newest[JOURNAL_SLOTS];
+        uint32_t last = 0;
+        uint8_t found = 0;
+        size = 0;
+        for (uint8_t s = 0; s < JOURNAL_SLOTS; s++)
+        {
+                where[s] = NONE;
+        }
+        next_record = 0;
+        next_seq = 1;
+        if (n == 0 || n > JOURNAL_DATA_MAX)
+        {
+                return 0;
+        }
+        size = n;
+        seed = 0xffff ^ ((uint16_t)key << 8 | n);
+        record_size = n + TAG_BYTES + CRC_BYTES;
+        records = JOURNAL_BYTES / record_size;
+        for (uint8_t r = 0; r < records; r++)
+        {
+                uint32_t tag = load(r, rec);
+                if (tag == 0xffffffff)
+                {
+                        continue;
+                }
+                uint8_t s = tag & 0x0f;
+                uint32_t seq = tag >> 4;
+                if (where[s] == NONE)
+                {
+                        found++;
+                }
+                else if (seq < newest[s])
+                {
+                        continue;
+                }
+                where[s] = r;
+                newest[s] = seq;
+                if (seq >= last)
+                {
+                        last = seq;
+                        next_record = r + 1 == records ? 0 : r + 1;
+                        next_seq = seq + 1;
+                }
+        }
+        return found;
+}
+
+uint8_t JOURNAL_read(uint8_t slot, void* dst)
+{
+        uint8_t rec[RECORD_MAX];
+        if (slot >= JOURNAL_SLOTS || where[slot] == NONE
+            || (load(where[slot], rec) & 0x0f) != slot)
+        {
+                return 0;
+        }
+        uint8_t* d = dst;
+        for (uint8_t i = 0; i < size; i++)
+        {
+                d[i] = rec[TAG_BYTES + i];
+        }
+        return 1;
+}
+
+uint8_t JOURNAL_has(uint8_t slot)
+{
+        return slot < JOURNAL_SLOTS && where[slot] != NONE;
+}
+
+// Whether record r is some slot's newest copy
+static uint8_t live(uint8_t r)
+{
+        for (uint8_t s = 0; s < JOURNAL_SLOTS; s++)
+        {
+                if (where[s] == r)
+                {
+                        return 1;
+                }
+        }
+        return 0;
+}
+
+uint8_t JOURNAL_write(uint8_t slot, const void* src)
+{
+        uint8_t rec[RECORD_MAX];
+        if (slot >= JOURNAL_SLOTS || size == 0)
+        {
+                return 0;
+        }
+        // There are more records than slots, so one is always free
+        uint8_t r = next_record;
+        while (live(r))
+        {
+                r = r + 1 == records ? 0 : r + 1;
+        }
+        uint32_t tag = next_seq << 4 | slot;
+        rec[0] = (uint8_t)tag;
+        rec[1] = (uint8_t)(tag >> 8);
+        rec[2] = (uint8_t)(tag >> 16);
+        rec[3] = (uint8_t)(tag >> 24);
+        const uint8_t* s = src;
+        for (uint8_t i = 0; i < size; i++)
+        {
+                rec[TAG_BYTES + i] = s[i];
+        }
+        uint8_t n = record_size - CRC_BYTES;
+        uint16_t c = crc(rec, n);
+        rec[n] = (uint8_t)c;
+        rec[n + 1] = (uint8_t)(c >> 8);
+        if (!EEWRITE_queue(&journal[r * record_size], rec, record_size))
+        {
+                return 0;
+        }
+        where[slot] = r;
+        next_record = r + 1 == records ? 0 : r + 1;
+        next_seq++;
+        return 1;
+}
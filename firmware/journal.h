@@ -0,0 +1,77 @@
+//////////////////////////////////////////////////////////////////////////////
+///
+///  \file journal.h
+///
+///  \copy copyright (c) 2023 William R Cooke
+///
+///  @brief Wear-levelled settings journal in EEPROM.
+///
+///  Each write appends a record to a ring of fixed-size records: a 28 bit
+///  sequence number and 4 bit slot, the data, and a CRC-CCITT over both.
+///  The newest record with a good CRC is the slot's value.  A write goes
+///  to the next record in the ring that is not some slot's newest copy,
+///  so the live copy of a slot is never overwritten, a write cut short by
+///  power loss only costs that write, and the writes spread over every
+///  record not pinned by a rarely changed slot.
+///
+///  Writes go through eewrite, so JOURNAL_read() must not run while
+///  EEWRITE_busy().
+///
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+
+// Slots 0-9 for sto/rcl, 10 for the last state
+#define JOURNAL_SLOTS      11
+#define JOURNAL_CURRENT    10
+
+// EEPROM given to the journal, and the largest record data, which
+// still leaves a free record with every slot written
+#define JOURNAL_BYTES      400
+#define JOURNAL_DATA_MAX   26
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn JOURNAL_init
+/// @brief Scans the journal for the newest good record of each slot.
+/// @param[in] size  Bytes of data per record, at most JOURNAL_DATA_MAX.
+/// @param[in] key   Layout version of the data.  Both go into the CRC, so
+///                  records written with another size or layout fail it.
+/// @return Slots holding a value.
+//////////////////////////////////////////////////////////////////////////////
+        uint8_t JOURNAL_init(uint8_t size, uint8_t key);
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn JOURNAL_read
+/// @brief Reads a slot's newest record.
+/// @param[out] dst  size bytes, untouched unless 1 is returned.
+/// @return 1 if read, 0 if the slot was never written or its CRC failed.
+//////////////////////////////////////////////////////////////////////////////
+        uint8_t JOURNAL_read(uint8_t slot, void* dst);
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn JOURNAL_has
+/// @return 1 if the slot has been written, without reading EEPROM.
+//////////////////////////////////////////////////////////////////////////////
+        uint8_t JOURNAL_has(uint8_t slot);
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn JOURNAL_write
+/// @brief Queues a new record for a slot.
+/// @param[in] src  size bytes, copied before returning.
+/// @return 1 if queued, 0 if the slot is out of range or the EEPROM write
+///         queue is full.
+//////////////////////////////////////////////////////////////////////////////
+        uint8_t JOURNAL_write(uint8_t slot, const void* src);
+
+#ifdef __cplusplus
+}
+#endif  // __cplusplus
+#endif  // #ifndef JOURNAL_H
@@ -0,0 +1,233 @@
+//////////////////////////////////////////////////////////////////////////////
+///
+///  \file keyer.c
+///
+///  \copy copyright (c) 2023 William R Cooke
+///
+///  @brief FSK and BPSK keying from the Timer1 compare B interrupt.
+///
+//////////////////////////////////////////////////////////////////////////////
+
+#include <stdint.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <util/atomic.h>
+#include "AD9833.h"
+#include "ddsbus.h"
+#include "timer1.h"
+#include "keyer.h"
+#include "ring.h"
+
+RING_CHECK(KEYER_SIZE);
+
+// As in ddsq: a symbol due within this many cycles is sent at once
+#define LEAD_CYCLES     64
+
+// 180 degrees in a 12 bit phase word
+#define PHASE_180       2048
+
+static uint8_t           ring[KEYER_SIZE];
+static volatile uint8_t  head;          // next free byte, moved by run()
+static volatile uint8_t  tail;          // next byte to key, moved by the ISR
+static volatile uint8_t  running;
+static volatile uint16_t symbols;
+static volatile uint16_t late;
+
+static uint8_t  chips;
+static uint8_t  framed;
+static uint16_t control[2];             // control word keying a 0 and a 1
+static uint32_t period;                 // whole cycles per symbol
+static uint8_t  period_frac;            // and 256ths of a cycle
+static uint8_t  frac;
+static uint32_t next_at;                // TIMER1_now() of the next symbol
+static uint16_t shift;                  // bits of the byte being keyed
+static uint8_t  bits_left;
+static uint8_t  symbol;                 // the next symbol
+static uint8_t  sent;                   // the symbol the chips have
+
+// Next bit to key, 1 when there is nothing to send
+static uint8_t next_bit(void)
+{
+        if (bits_left == 0)
+        {
+                if (tail == head)
+                {
+                        return 1;
+                }
+                uint8_t b = ring[tail];
+                tail = RING_NEXT(tail, KEYER_SIZE);
+                if (framed)
+                {
+                        // start 0, data LSB first, stop 1
+                        shift = (uint16_t)b << 1 | 0x200;
+                        bits_left = 10;
+                }
+                else
+                {
+                        shift = b;
+                        bits_left = 8;
+                }
+        }
+        uint8_t bit = shift & 1;
+        shift >>= 1;
+        bits_left--;
+        return bit;
+}
+
+// Sends every symbol that is due and sets compare B for the next one.
+// Interrupts must be off.
+static void key_due(void)
+{
+        while (1)
+        {
+                int32_t d = (int32_t)(next_at - TIMER1_now());
+                if (d > LEAD_CYCLES)
+                {
+                        OCR1B = (uint16_t)next_at;
+                        if ((int32_t)(next_at - TIMER1_now()) > LEAD_CYCLES)
+                        {
+                                return;
+                        }
+                        continue;
+                }
+                while (d > 0)
+                {
+                        d = (int32_t)(next_at - TIMER1_now());
+                }
+                // A repeated symbol needs no write
+                if (symbol != sent)
+                {
+                        DDSBUS_write(chips, &control[symbol], 1);
+                        sent = symbol;
+                }
+                uint32_t behind = (uint32_t)-d;
+                if (behind > late)
+                {
+                        late = behind > 0xffff ? 0xffff : (uint16_t)behind;
+                }
+                symbols++;
+                uint16_t f = (uint16_t)frac + period_frac;
+                next_at += period + (f >> 8);
+                frac = (uint8_t)f;
+                symbol = next_bit();
+        }
+}
+
+uint8_t KEYER_start(uint8_t ch, uint8_t mode, uint16_t baud,
+                    uint32_t word0, uint32_t word1)
+{
+        if (mode > KEYER_PSK_FRAMED || baud == 0 || baud > KEYER_MAX_BAUD)
+        {
+                return 0;
+        }
+        KEYER_stop();
+        uint8_t psk = mode & KEYER_PSK;
+        uint8_t lead = (uint8_t)__builtin_ctz(ch);
+        AD9833_set_frequency(ch, 0, word0);
+        if (psk)
+        {
+                AD9833_set_phase(ch, 0, 0);
+                AD9833_set_phase(ch, 1, PHASE_180);
+                AD9833_select_freq(ch, 0);
+        }
+        else
+        {
+                AD9833_set_frequency(ch, 1, word1);
+        }
+        AD9833_select_phase(ch, 0);
+        AD9833_update(ch);
+        for (uint8_t b = 0; b < 2; b++)
+        {
+                control[b] = psk ? AD9833_select_word(lead, 0, b)
+                        : AD9833_select_word(lead, b, 0);
+        }
+        // 16 MHz << 8 still fits 32 bits
+        uint32_t q8 = (TIMER1_CYCLES_PER_MS * 1000UL << 8) / baud;
+        period = q8 >> 8;
+        period_frac = (uint8_t)q8;
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+        {
+                chips = ch;
+                framed = mode & KEYER_FRAMED;
+                head = tail = 0;
+                bits_left = 0;
+                frac = 0;
+                symbols = 0;
+                late = 0;
+                sent = 0xff;
+                symbol = next_bit();
+                next_at = TIMER1_now();
+                running = 1;
+                TIMSK |= _BV(OCIE1B);
+                key_due();
+        }
+        return 1;
+}
+
+void KEYER_stop(void)
+{
+        if (!running)
+        {
+                return;
+        }
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+        {
+                TIMSK &= ~_BV(OCIE1B);
+                running = 0;
+                head = tail = 0;
+        }
+        // FSEL or PSEL is wherever the last symbol left it
+        AD9833_invalidate(chips);
+}
+
+uint8_t KEYER_room(void)
+{
+        // tail only moves toward head, so a stale read under-counts room
+        return RING_ROOM(head, tail, KEYER_SIZE);
+}
+
+uint8_t KEYER_send(const uint8_t* p, uint8_t n)
+{
+        if (!running || n > KEYER_room())
+        {
+                return 0;
+        }
+        uint8_t h = head;
+        for (uint8_t i = 0; i < n; i++)
+        {
+                ring[h] = p[i];
+                h = RING_NEXT(h, KEYER_SIZE);
+        }
+        head = h;
+        return 1;
+}
+
+uint8_t KEYER_running(void)
+{
+        return running;
+}
+
+uint16_t KEYER_symbols(void)
+{
+        uint16_t n;
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+        {
+                n = symbols;
+        }
+        return n;
+}
+
+uint16_t KEYER_late(void)
+{
+        uint16_t n;
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+        {
+                n = late;
+        }
+        return n;
+}
+
+ISR(TIMER1_COMPB_vect)
+{
+        key_due();
+}
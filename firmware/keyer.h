@@ -0,0 +1,104 @@
+//////////////////////////////////////////////////////////////////////////////
+///
+///  \file keyer.h
+///
+///  \copy copyright (c) 2023 William R Cooke
+///
+///  @brief FSK and BPSK keying from the Timer1 compare B interrupt.
+///
+///  Both symbol states are loaded into the AD9833 before keying starts:
+///  FSK puts the space frequency in FREQ0 and the mark in FREQ1, BPSK
+///  puts 0 degrees in PHASE0 and 180 in PHASE1.  Each symbol is then one
+///  control word with FSEL or PSEL set to the bit, worked out in advance,
+///  so the compare B interrupt only hands a single word to ddsbus on the
+///  symbol's Timer1 cycle.  Symbols come from a byte ring filled by
+///  KEYER_send(), least significant bit first, optionally framed with a
+///  start and a stop bit like the UART.  With nothing to send the keyer
+///  idles on 1, mark.
+///
+///  While keying, the keyer owns the chips' control word: ddsq must be
+///  idle and run() must not write the DDS until KEYER_stop().
+///
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef KEYER_H
+#define KEYER_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+
+// Bytes waiting to be keyed, a power of 2
+#define KEYER_SIZE         64
+
+// Fastest symbol rate.  Each symbol costs the interrupt and a one word
+// ddsbus write, about 150 cycles, so this keeps the load under 20 %.
+#define KEYER_MAX_BAUD     20000
+
+        typedef enum KEYER_MODE
+        {
+                KEYER_FSK          = 0,
+                KEYER_PSK          = 1,
+                KEYER_FSK_FRAMED   = 2,  // start bit, 8 data, stop bit
+                KEYER_PSK_FRAMED   = 3
+        } KeyerMode_t;
+
+#define KEYER_FRAMED       2             // mode bit for framing
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn KEYER_start
+/// @brief Loads the symbol registers and starts keying on the next cycle.
+///        TIMER1_init() must have been called.
+/// @param[in] chips  AD9833_CH() mask to key.
+/// @param[in] mode   KeyerMode_t.
+/// @param[in] baud   Symbols per second, 1 to KEYER_MAX_BAUD.
+/// @param[in] word0  FSK: space tuning word.  BPSK: the carrier.
+/// @param[in] word1  FSK: mark tuning word.  Ignored for BPSK.
+/// @return 1 if keying, 0 if mode or baud is out of range.
+//////////////////////////////////////////////////////////////////////////////
+        uint8_t KEYER_start(uint8_t chips, uint8_t mode, uint16_t baud,
+                            uint32_t word0, uint32_t word1);
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn KEYER_stop
+/// @brief Stops keying, drops what is unsent and tells the driver the
+///        chips' control word is no longer known.  Nothing if not keying.
+//////////////////////////////////////////////////////////////////////////////
+        void KEYER_stop(void);
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn KEYER_send
+/// @brief Queues bytes to key.
+/// @param[in] p  Bytes, copied before returning.
+/// @return 1 if all n were queued, 0 if not keying or there is no room
+///         for all of them, when none are queued.
+//////////////////////////////////////////////////////////////////////////////
+        uint8_t KEYER_send(const uint8_t* p, uint8_t n);
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn KEYER_room
+/// @return Bytes KEYER_send() can take.
+//////////////////////////////////////////////////////////////////////////////
+        uint8_t KEYER_room(void);
+
+        uint8_t KEYER_running(void);
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn KEYER_symbols
+/// @return Symbols keyed since KEYER_start(), modulo 2^16.
+//////////////////////////////////////////////////////////////////////////////
+        uint16_t KEYER_symbols(void);
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn KEYER_late
+/// @return Largest lateness seen, in cycles after a symbol's time.
+//////////////////////////////////////////////////////////////////////////////
+        uint16_t KEYER_late(void);
+
+#ifdef __cplusplus
+}
+#endif  // __cplusplus
+#endif  // #ifndef KEYER_H
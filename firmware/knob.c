@@ -0,0 +1,136 @@
+//////////////////////////////////////////////////////////////////////////////
+///
+///  \file knob.c
+///
+///  \copy copyright (c) 2023 William R Cooke
+///
+///  @brief Interrupt driven quadrature decoding of the tuning knob.
+///
+//////////////////////////////////////////////////////////////////////////////
+
+#include <stdint.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/pgmspace.h>
+#include <util/atomic.h>
+#include "knob.h"
+
+#define KNOB_PINS       (_BV(PD2) | _BV(PD3))
+
+// Indexed by (previous AB << 2) | current AB, A in bit 0.  Forward is
+// 00 -> 01 -> 11 -> 10; invalid double steps count as nothing.
+static const int8_t quad_table[16] =
+{
+        0, 1, -1, 0,
+        -1, 0, 0, 1,
+        1, 0, 0, -1,
+        0, -1, 1, 0
+};
+
+// Multiplier once the speed reaches at least this many detents per window
+typedef struct KNOB_ACCEL
+{
+        uint8_t  rate;
+        uint32_t multiplier;
+} knob_accel_t;
+
+static const knob_accel_t accel_table[] PROGMEM =
+{
+        { 24, 100000 },
+        { 16, 10000 },
+        { 10, 1000 },
+        { 6,  100 },
+        { 3,  10 }
+};
+
+#define ACCEL_STEPS     (sizeof(accel_table) / sizeof(accel_table[0]))
+
+static volatile uint8_t ab;           // last AB state seen by the ISR
+static volatile int8_t  edges;        // transitions toward the next detent
+static volatile int16_t detents;      // whole detents not yet collected
+
+static uint32_t window_start;
+static uint8_t  window_count;         // detents in the current window
+static uint8_t  last_rate;            // detents in the previous window
+
+static void decode(void)
+{
+        uint8_t now = (PIND >> PD2) & 3;
+        int8_t e = edges + quad_table[(ab << 2) | now];
+        ab = now;
+        if (e >= KNOB_EDGES_PER_DETENT)
+        {
+                e = 0;
+                detents++;
+        }
+        else if (e <= -KNOB_EDGES_PER_DETENT)
+        {
+                e = 0;
+                detents--;
+        }
+        edges = e;
+}
+
+ISR(INT0_vect)
+{
+        decode();
+}
+
+ISR(INT1_vect)
+{
+        decode();
+}
+
+void KNOB_init(void)
+{
+        DDRD &= ~KNOB_PINS;
+        PORTD |= KNOB_PINS;
+        ab = (PIND >> PD2) & 3;
+        edges = 0;
+        detents = 0;
+        window_count = 0;
+        last_rate = 0;
+        // Any logical change on INT0 and INT1
+        MCUCR = (MCUCR & ~(_BV(ISC01) | _BV(ISC11))) | _BV(ISC00) | _BV(ISC10);
+        GIFR = _BV(INTF0) | _BV(INTF1);
+        GICR |= _BV(INT0) | _BV(INT1);
+}
+
+int32_t KNOB_get_delta(uint32_t now_ms, uint8_t accelerate)
+{
+        int16_t d;
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+        {
+                d = detents;
+                detents = 0;
+        }
+
+        uint32_t age = now_ms - window_start;
+        if (age >= KNOB_WINDOW_MS)
+        {
+                last_rate = age < 2 * KNOB_WINDOW_MS ? window_count : 0;
+                window_count = 0;
+                window_start = now_ms;
+        }
+        if (d == 0)
+        {
+                return 0;
+        }
+        uint16_t n = d < 0 ? -d : d;
+        window_count = window_count + n > 255 ? 255 : window_count + n;
+
+        if (!accelerate)
+        {
+                return d;
+        }
+        uint8_t rate = window_count > last_rate ? window_count : last_rate;
+        for (uint8_t i = 0; i < ACCEL_STEPS; i++)
+        {
+                if (rate >= pgm_read_byte(&accel_table[i].rate))
+                {
+                        return (int32_t)d * (int32_t)
+                                pgm_read_dword(&accel_table[i].multiplier);
+                }
+        }
+        return d;
+}
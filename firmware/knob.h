@@ -0,0 +1,52 @@
+//////////////////////////////////////////////////////////////////////////////
+///
+///  \file knob.h
+///
+///  \copy copyright (c) 2023 William R Cooke
+///
+///  @brief Interrupt driven quadrature decoding of the tuning knob.
+///
+///  Phase A is on PD2 (INT0) and phase B on PD3 (INT1), both interrupting
+///  on any edge, so every transition is counted in the ISR however busy
+///  the main loop is.  The loop collects whole detents once per tick and
+///  gets them scaled by how fast the knob is turning.
+///
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef KNOB_H
+#define KNOB_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+
+// Quadrature transitions per mechanical detent
+#define KNOB_EDGES_PER_DETENT   4
+
+// Turning speed is measured as detents per window of this many ms
+#define KNOB_WINDOW_MS          64
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn KNOB_init
+/// @brief Sets PD2/PD3 as inputs with pull-ups and enables INT0/INT1 on
+///        any logical change.
+//////////////////////////////////////////////////////////////////////////////
+        void KNOB_init(void);
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn KNOB_get_delta
+/// @brief Takes the detents counted since the last call.
+/// @param[in] now_ms      Current SYSTICK time, for the speed estimate.
+/// @param[in] accelerate  Non zero scales the detents by 1 to 100000
+///                        depending on turning speed.
+/// @return Signed detents, scaled if accelerate is set.
+//////////////////////////////////////////////////////////////////////////////
+        int32_t KNOB_get_delta(uint32_t now_ms, uint8_t accelerate);
+
+#ifdef __cplusplus
+}
+#endif  // __cplusplus
+#endif  // #ifndef KNOB_H
@@ -0,0 +1,120 @@
+//////////////////////////////////////////////////////////////////////////////
+///
+///  \file lcd.c
+///
+///  \copy copyright (c) 2023 William R Cooke
+///
+///  @brief HD44780 driver, 4 bit interface, write only.
+///
+//////////////////////////////////////////////////////////////////////////////
+
+#include <stdint.h>
+
+#ifndef F_CPU
+#define F_CPU 16000000UL
+#endif
+
+#include <avr/io.h>
+#include <util/atomic.h>
+#include <util/delay.h>
+#include "lcd.h"
+
+#define LCD_E           _BV(PB2)
+#define LCD_RS          _BV(PB1)
+#define LCD_DATA        0xf0            // D4-D7 on PD4-PD7
+
+// Instructions the set-up sends
+#define LCD_FUNCTION_8  0x03            // function set, 8 bit, as a nibble
+#define LCD_FUNCTION_4  0x02            // the same, switching to 4 bit
+#define LCD_TWO_LINES   0x28            // 4 bit, 2 lines, 5x8 dots
+#define LCD_ON          0x0c            // display on, cursor and blink off
+#define LCD_ENTRY       0x06            // address moves up, no shift
+#define LCD_SET_DDRAM   0x80
+
+#define LCD_LINE_1      0x40            // DDRAM address of line 1
+
+// Controller timings, with some margin
+#define LCD_POWER_MS    50              // Vcc reaching 4.5 V to first write
+#define LCD_RESET_US    4500            // after the first 8 bit function set
+#define LCD_NIBBLE_US   120             // after the later set-up nibbles
+#define LCD_BYTE_US     40              // after any other byte
+
+// Latches the high nibble of b on E's falling edge
+static void nibble(uint8_t b)
+{
+        PORTD = (PORTD & ~LCD_DATA) | (b & LCD_DATA);
+        PORTB |= LCD_E;
+        _delay_us(1);
+        PORTB &= ~LCD_E;
+}
+
+static void byte(uint8_t b, uint8_t rs)
+{
+        if (rs)
+        {
+                PORTB |= LCD_RS;
+        }
+        else
+        {
+                PORTB &= ~LCD_RS;
+        }
+        nibble(b);
+        nibble((uint8_t)(b << 4));
+        _delay_us(LCD_BYTE_US);
+}
+
+// One set-up nibble with interrupts off, then its wait with them on
+static void reset_nibble(uint8_t n, uint16_t wait_us)
+{
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+        {
+                PORTB &= ~LCD_RS;
+                nibble((uint8_t)(n << 4));
+        }
+        // _delay_us() wants a constant
+        while (wait_us >= LCD_NIBBLE_US)
+        {
+                _delay_us(LCD_NIBBLE_US);
+                wait_us -= LCD_NIBBLE_US;
+        }
+}
+
+static void setup_command(uint8_t cmd)
+{
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+        {
+                byte(cmd, 0);
+        }
+}
+
+void LCD_init(void)
+{
+        PORTB &= ~(LCD_E | LCD_RS);
+        DDRB |= LCD_E | LCD_RS;
+        DDRD |= LCD_DATA;
+        _delay_ms(LCD_POWER_MS);
+        // Three 8 bit function sets bring it to a known state from either
+        // width, then one switches to 4 bit
+        reset_nibble(LCD_FUNCTION_8, LCD_RESET_US);
+        reset_nibble(LCD_FUNCTION_8, LCD_NIBBLE_US);
+        reset_nibble(LCD_FUNCTION_8, LCD_NIBBLE_US);
+        reset_nibble(LCD_FUNCTION_4, LCD_NIBBLE_US);
+        setup_command(LCD_TWO_LINES);
+        setup_command(LCD_ON);
+        setup_command(LCD_ENTRY);
+}
+
+void LCD_write_command(uint8_t cmd)
+{
+        byte(cmd, 0);
+}
+
+void LCD_write_data(uint8_t data)
+{
+        byte(data, 1);
+}
+
+void LCD_goto(uint8_t x, uint8_t y)
+{
+        byte((uint8_t)(LCD_SET_DDRAM | (y ? LCD_LINE_1 : 0) | x), 0);
+}
@@ -0,0 +1,67 @@
+//////////////////////////////////////////////////////////////////////////////
+///
+///  \file lcd.h
+///
+///  \copy copyright (c) 2023 William R Cooke
+///
+///  @brief HD44780 driver, 4 bit interface, write only.
+///
+///  E is on PB2, RS on PB1 and D4-D7 on PD4-PD7, with R/W tied low.
+///  The avrlib driver this replaces had E on PB0, which is the Timer1
+///  input capture pin the trigger input needs (trig.h), so boards from
+///  before the trigger have the LCD's E line moved from PB0 to PB2.  PB2
+///  is the SPI SS pin; it has to be an output for the SPI to stay master
+///  and was not connected to anything.
+///
+///  The keypad shares PD4-PD7 and scans them from the SYSTICK interrupt,
+///  so every call but LCD_init() must run with interrupts off.  Busy is
+///  never read: each byte waits out the controller's 37 us before
+///  returning, so a byte costs about 40 us.
+///
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef LCD_H
+#define LCD_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn LCD_init
+/// @brief Waits out the LCD's power-up, puts it in 4 bit mode with two
+///        lines, display on, cursor off, and leaves it to be cleared.
+///        Masks interrupts only around each write.
+//////////////////////////////////////////////////////////////////////////////
+        void LCD_init(void);
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn LCD_write_command
+/// @brief Sends an instruction byte.  A clear (0x01) or home (0x02) keeps
+///        the controller busy 1.52 ms more, which the caller waits out.
+/// @param[in] cmd  HD44780 instruction.
+//////////////////////////////////////////////////////////////////////////////
+        void LCD_write_command(uint8_t cmd);
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn LCD_write_data
+/// @brief Writes a character at the address counter, which moves on one.
+/// @param[in] data  Character code.
+//////////////////////////////////////////////////////////////////////////////
+        void LCD_write_data(uint8_t data);
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn LCD_goto
+/// @brief Moves the address counter to column x of line y.
+/// @param[in] x  Column, 0 to 39.
+/// @param[in] y  Line, 0 or 1.
+//////////////////////////////////////////////////////////////////////////////
+        void LCD_goto(uint8_t x, uint8_t y);
+
+#ifdef __cplusplus
+}
+#endif  // __cplusplus
+#endif  // #ifndef LCD_H
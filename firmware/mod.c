@@ -0,0 +1,230 @@
+//////////////////////////////////////////////////////////////////////////////
+///
+///  \file mod.c
+///
+///  \copy copyright (c) 2023 William R Cooke
+///
+///  @brief FM, AM and pulse modulation from the Timer2 compare interrupt.
+///
+//////////////////////////////////////////////////////////////////////////////
+
+#include <stdint.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/pgmspace.h>
+#include <util/atomic.h>
+#include "AD9833.h"
+#include "ddsbus.h"
+#include "timer1.h"
+#include "mod.h"
+
+#define HALF_MASK       0x3fff
+#define WORD_MAX        0x0fffffffUL
+
+// First quarter of a sine, 127 * sin((i + 0.5) * 90 / 64 degrees), so
+// the other three are the same values mirrored without a repeat
+static const int8_t quarter[64] PROGMEM =
+{
+          2,   5,   8,  11,  14,  17,  20,  23,
+         26,  29,  32,  35,  38,  41,  44,  47,
+         50,  53,  56,  58,  61,  64,  67,  69,
+         72,  74,  77,  79,  82,  84,  86,  89,
+         91,  93,  95,  97,  99, 101, 103, 105,
+        106, 108, 110, 111, 113, 114, 115, 117,
+        118, 119, 120, 121, 122, 123, 124, 124,
+        125, 125, 126, 126, 127, 127, 127, 127
+};
+
+// Timer2 clock selects tried in turn, and their dividers
+static const uint8_t  clock_select[] = { 2, 3, 4 };
+static const uint8_t  divider[] = { 8, 32, 64 };
+
+static volatile uint8_t  running;
+static volatile uint32_t updates;
+static volatile uint16_t worst;
+
+static uint8_t  chips;
+static uint8_t  mode;
+static uint16_t rate;
+static uint16_t phase;                  // tone phase, 65536 = 360 degrees
+static uint16_t step;                   // added every update
+static uint32_t carrier;
+static int32_t  deviation;              // FM peak, in tuning word units
+static uint16_t addr;                   // FREQ0 address bits
+static uint8_t  halves;                 // words per FM update, 1 or 2
+static uint8_t  depth;                  // AM, 0 to 127
+static uint16_t duty;                   // pulse, phase >> 8 below this is on
+static uint8_t  level;                  // AM sigma-delta remainder
+static uint8_t  lit;                    // output on as the chip has it
+static uint16_t gate[2];                // control words for off and on
+
+// -127 to 127 for an 8 bit phase
+static int8_t sine(uint8_t ph)
+{
+        uint8_t i = ph & 0x3f;
+        if (ph & 0x40)
+        {
+                i = 0x3f - i;
+        }
+        int8_t v = (int8_t)pgm_read_byte(&quarter[i]);
+        return (ph & 0x80) ? -v : v;
+}
+
+uint8_t MOD_start(uint8_t ch, uint8_t md, uint16_t r, uint32_t word,
+                  uint16_t tone, uint32_t amount)
+{
+        uint8_t i;
+        uint16_t top = 0;
+        if (md > MOD_PULSE || r < MOD_MIN_RATE || r > MOD_MAX_RATE
+            || tone == 0 || tone > r / 2
+            || (md != MOD_FM && amount > 100))
+        {
+                return 0;
+        }
+        // The fastest clock that still reaches the rate in 8 bits
+        for (i = 0; i < sizeof(divider); i++)
+        {
+                uint32_t f = TIMER1_CYCLES_PER_MS * 1000UL / divider[i];
+                top = (uint16_t)((f + r / 2) / r);
+                if (top <= 256)
+                {
+                        break;
+                }
+        }
+        MOD_stop();
+        word &= WORD_MAX;
+        uint8_t lead = (uint8_t)__builtin_ctz(ch);
+        AD9833_set_frequency(ch, 0, word);
+        AD9833_select_freq(ch, 0);
+        if (md == MOD_FM)
+        {
+                if (amount > word)
+                {
+                        amount = word;
+                }
+                if (amount > WORD_MAX - word)
+                {
+                        amount = WORD_MAX - word;
+                }
+                halves = AD9833_stream_freq(ch, 0, word - amount,
+                                            word + amount, &addr);
+        }
+        AD9833_update(ch);
+        gate[1] = AD9833_gate_word(lead, 0, 0);
+        gate[0] = md == MOD_PULSE ? AD9833_gate_word(lead, 1, 0)
+                : AD9833_gate_word(lead, 0, AD9833_SLEEP_BIT_DAC);
+
+        uint32_t f = TIMER1_CYCLES_PER_MS * 1000UL / divider[i];
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+        {
+                chips = ch;
+                mode = md;
+                carrier = word;
+                deviation = (int32_t)amount;
+                depth = (uint8_t)(amount * 127 / 100);
+                duty = (uint16_t)(amount * 256 / 100);
+                rate = (uint16_t)((f + top / 2) / top);
+                step = (uint16_t)(((uint32_t)tone << 16) / rate);
+                phase = 0;
+                level = 0;
+                lit = 1;
+                updates = 0;
+                worst = 0;
+                running = 1;
+                OCR2 = (uint8_t)(top - 1);
+                TCNT2 = 0;
+                TIMSK |= _BV(OCIE2);
+                TCCR2 = _BV(WGM21) | clock_select[i];
+        }
+        return 1;
+}
+
+void MOD_stop(void)
+{
+        if (!running)
+        {
+                return;
+        }
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+        {
+                TCCR2 = 0;
+                TIMSK &= ~_BV(OCIE2);
+                running = 0;
+                rate = 0;
+        }
+        // FREQ0 holds the last update, the gate bits the last level
+        AD9833_invalidate(chips);
+}
+
+uint8_t MOD_running(void)
+{
+        return running;
+}
+
+uint16_t MOD_rate(void)
+{
+        return rate;
+}
+
+uint32_t MOD_updates(void)
+{
+        uint32_t n;
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+        {
+                n = updates;
+        }
+        return n;
+}
+
+uint16_t MOD_worst(void)
+{
+        uint16_t n;
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+        {
+                n = worst;
+        }
+        return n;
+}
+
+ISR(TIMER2_COMP_vect)
+{
+        uint16_t t0 = TCNT1;
+        phase += step;
+        int8_t s = sine((uint8_t)(phase >> 8));
+        uint16_t wds[2];
+        if (mode == MOD_FM)
+        {
+                uint32_t w = carrier + (deviation * s >> 7);
+                wds[0] = addr | (uint16_t)(w & HALF_MASK);
+                wds[1] = addr | (uint16_t)(w >> 14);
+                DDSBUS_write(chips, wds, halves);
+        }
+        else
+        {
+                uint8_t on;
+                if (mode == MOD_AM)
+                {
+                        // First order sigma-delta: on for 128 + depth * sine
+                        // out of every 256 updates
+                        uint16_t sum = level + (uint8_t)(128
+                                + ((int16_t)depth * s >> 7));
+                        on = sum >> 8;
+                        level = (uint8_t)sum;
+                }
+                else
+                {
+                        on = (phase >> 8) < duty;
+                }
+                if (on != lit)
+                {
+                        DDSBUS_write(chips, &gate[on], 1);
+                        lit = on;
+                }
+        }
+        updates++;
+        uint16_t took = TCNT1 - t0;
+        if (took > worst)
+        {
+                worst = took;
+        }
+}
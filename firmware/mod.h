@@ -0,0 +1,108 @@
+//////////////////////////////////////////////////////////////////////////////
+///
+///  \file mod.h
+///
+///  \copy copyright (c) 2023 William R Cooke
+///
+///  @brief FM, AM and pulse modulation from the Timer2 compare interrupt.
+///
+///  Timer1's compare units belong to ddsq and the keyer, so Timer2 runs
+///  in CTC mode at the update rate.  Each compare interrupt steps a 16 bit
+///  phase accumulator through a quarter-wave sine table in flash and
+///  sends at most one small batch to ddsbus:
+///
+///  FM writes carrier + deviation * sine straight into FREQ0.  When the
+///  whole swing keeps the upper 14 bits of the tuning word, the chip is
+///  left in LSB load mode and an update is one SPI word; otherwise it is
+///  in 28 bit mode and an update is the two halves, which the chip only
+///  takes together.
+///
+///  AM and pulse switch the output on and off with one control word, and
+///  only when it changes.  The AD9833 has no amplitude control: AM gates
+///  the DAC with SLEEP12, on for a share of updates that follows the
+///  sine, so it is AM once filtered well below the update rate.  Pulse
+///  gates with RESET for the first part of each tone cycle, which
+///  restarts the carrier at zero phase on every pulse.
+///
+///  The interrupt polls its words out itself, about 90 cycles for the
+///  two halves, so every update reaches the chip before the next.
+///
+///  While modulating, the module owns the chips' control word and FREQ0:
+///  ddsq must be idle and run() must not write the DDS until MOD_stop().
+///
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef MOD_H
+#define MOD_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+
+// Slowest update rate Timer2 makes from F_CPU / 64 in 8 bits
+#define MOD_MIN_RATE       1000
+
+// Fastest update rate.  A two word FM update costs the interrupt, the
+// sums and a two word ddsbus write, about 300 cycles, so this takes over
+// a third of the CPU.
+#define MOD_MAX_RATE       20000
+
+        typedef enum MOD_MODE
+        {
+                MOD_FM             = 0,  // amount: peak deviation word
+                MOD_AM             = 1,  // amount: depth, percent
+                MOD_PULSE          = 2   // amount: duty cycle, percent
+        } ModMode_t;
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn MOD_start
+/// @brief Sets up the chips and starts modulating on the next update.
+/// @param[in] chips    AD9833_CH() mask.
+/// @param[in] mode     ModMode_t.
+/// @param[in] rate     Updates per second, MOD_MIN_RATE to MOD_MAX_RATE.
+///                     Timer2 makes the nearest it can; see MOD_rate().
+/// @param[in] carrier  28 bit tuning word.
+/// @param[in] tone     Modulating frequency in Hz, up to rate / 2.
+/// @param[in] amount   As ModMode_t says.  FM deviation is cut to what
+///                     keeps the word between 0 and full scale.
+/// @return 1 if modulating, 0 if an argument is out of range.
+//////////////////////////////////////////////////////////////////////////////
+        uint8_t MOD_start(uint8_t chips, uint8_t mode, uint16_t rate,
+                          uint32_t carrier, uint16_t tone, uint32_t amount);
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn MOD_stop
+/// @brief Stops Timer2 and tells the driver the chips' control word and
+///        FREQ0 are no longer known.  Nothing if not modulating.
+//////////////////////////////////////////////////////////////////////////////
+        void MOD_stop(void);
+
+        uint8_t MOD_running(void);
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn MOD_rate
+/// @return Updates per second Timer2 is making, 0 if not modulating.
+//////////////////////////////////////////////////////////////////////////////
+        uint16_t MOD_rate(void);
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn MOD_updates
+/// @return Updates that reached ddsbus since MOD_start(), modulo 2^32.
+///         An AM or pulse update that needed no write counts too.
+//////////////////////////////////////////////////////////////////////////////
+        uint32_t MOD_updates(void);
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn MOD_worst
+/// @return Most cycles one compare interrupt has taken, entry and exit
+///         not included.
+//////////////////////////////////////////////////////////////////////////////
+        uint16_t MOD_worst(void);
+
+#ifdef __cplusplus
+}
+#endif  // __cplusplus
+#endif  // #ifndef MOD_H
@@ -0,0 +1,89 @@
+//////////////////////////////////////////////////////////////////////////////
+///
+///  \file prof.c
+///
+///  \copy copyright (c) 2023 William R Cooke
+///
+///  @brief Cycle counts for hot paths, timed with Timer1.
+///
+//////////////////////////////////////////////////////////////////////////////
+
+#include <stdint.h>
+#include <avr/pgmspace.h>
+#include "timer1.h"
+#include "prof.h"
+
+#if PROF_ENABLE
+
+typedef struct PROF_ACC
+{
+        uint32_t min;
+        uint32_t max;
+        uint32_t sum;            // halved with n to stay in range
+        uint16_t n;              // passes in sum
+        uint16_t count;
+} prof_acc_t;
+
+static prof_acc_t acc[PROF_COUNT];
+static uint32_t   overhead;     // an empty BEGIN/END pair
+
+static const char names[PROF_COUNT][8] PROGMEM =
+{
+        "DDSwr  ", "ShowInt", "Key    ", "LCD    ", "EEPROM "
+};
+
+void PROF_init(void)
+{
+        overhead = 0;
+        for (uint8_t i = 0; i < PROF_COUNT; i++)
+        {
+                acc[i].min = 0xffffffffUL;
+                acc[i].max = 0;
+                acc[i].sum = 0;
+                acc[i].n = 0;
+                acc[i].count = 0;
+        }
+        uint32_t start = TIMER1_now();
+        overhead = TIMER1_now() - start;
+}
+
+void PROF_record(ProfId_t id, uint32_t cycles)
+{
+        prof_acc_t* a = &acc[id];
+        cycles = cycles > overhead ? cycles - overhead : 0;
+        if (cycles < a->min)
+        {
+                a->min = cycles;
+        }
+        if (cycles > a->max)
+        {
+                a->max = cycles;
+        }
+        if (a->sum + cycles < a->sum || a->n == 0xffff)
+        {
+                a->sum >>= 1;
+                a->n >>= 1;
+        }
+        a->sum += cycles;
+        a->n++;
+        if (a->count != 0xffff)
+        {
+                a->count++;
+        }
+}
+
+void PROF_get(ProfId_t id, prof_stat_t* stat)
+{
+        const prof_acc_t* a = &acc[id];
+        stat->min = a->n ? a->min : 0;
+        stat->max = a->max;
+        stat->avg = a->n ? a->sum / a->n : 0;
+        stat->count = a->count;
+}
+
+const char* PROF_name(ProfId_t id)
+{
+        return names[id];
+}
+
+#endif  // PROF_ENABLE
@@ -0,0 +1,82 @@
+//////////////////////////////////////////////////////////////////////////////
+///
+///  \file prof.h
+///
+///  \copy copyright (c) 2023 William R Cooke
+///
+///  @brief Cycle counts for hot paths, timed with Timer1.
+///
+///  Wrap a block in PROF_BEGIN(id) and PROF_END(id) in the same scope and
+///  each pass through it records its length in CPU cycles, less the cost
+///  of the two timer reads.  Build with DEFS=-DPROF_ENABLE=1 to turn the
+///  probes on; otherwise the macros are empty and prof.c compiles to
+///  nothing.
+///
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef PROF_H
+#define PROF_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include "timer1.h"
+
+#ifndef PROF_ENABLE
+#define PROF_ENABLE        0
+#endif
+
+        typedef enum PROF_ID
+        {
+                PROF_DDS_WRITE,          // DDS_write_frequency()
+                PROF_SHOW_INT,           // show_int_at()
+                PROF_KEY,                // process_key()
+                PROF_LCD,                // DISPLAY_flush()
+                PROF_EEPROM,             // settings block read or write
+                PROF_COUNT
+        } ProfId_t;
+
+        typedef struct PROF_STAT
+        {
+                uint32_t min;
+                uint32_t max;
+                uint32_t avg;
+                uint16_t count;          // sticks at 0xffff
+        } prof_stat_t;
+
+#if PROF_ENABLE
+#define PROF_BEGIN(id)   uint32_t prof_start_##id = TIMER1_now()
+#define PROF_END(id)     PROF_record((id), TIMER1_now() - prof_start_##id)
+#else
+#define PROF_BEGIN(id)
+#define PROF_END(id)
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn PROF_init
+/// @brief Clears the counts and measures the probe overhead.
+///        TIMER1_init() must have been called.
+//////////////////////////////////////////////////////////////////////////////
+        void PROF_init(void);
+
+        void PROF_record(ProfId_t id, uint32_t cycles);
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn PROF_get
+/// @param[out] stat  Counts for probe id; min is 0 if it never ran.
+//////////////////////////////////////////////////////////////////////////////
+        void PROF_get(ProfId_t id, prof_stat_t* stat);
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn PROF_name
+/// @return 7 character name of probe id, space padded, in flash.
+//////////////////////////////////////////////////////////////////////////////
+        const char* PROF_name(ProfId_t id);
+
+#ifdef __cplusplus
+}
+#endif  // __cplusplus
+#endif  // #ifndef PROF_H
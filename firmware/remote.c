@@ -0,0 +1,294 @@
+//////////////////////////////////////////////////////////////////////////////
+///
+///  \file remote.c
+///
+///  \copy copyright (c) 2023 William R Cooke
+///
+///  @brief Serial remote control protocol.
+///
+//////////////////////////////////////////////////////////////////////////////
+
+#include <stdint.h>
+#include <avr/pgmspace.h>
+#include "uart.h"
+#include "fmt.h"
+#include "remote.h"
+
+#define WORD_BYTES      4
+
+static uint8_t  line[REMOTE_LINE_LENGTH + 1];
+static uint8_t  line_len;
+static uint8_t  line_overflow;
+static uint32_t word;
+static uint8_t  word_bytes;        // bytes of a binary word still to come
+
+void REMOTE_init(void)
+{
+        UART_init();
+        line_len = 0;
+        line_overflow = 0;
+        word_bytes = 0;
+}
+
+static const uint8_t* skip_spaces(const uint8_t* p)
+{
+        while (*p == ' ' || *p == '\t')
+        {
+                p++;
+        }
+        return p;
+}
+
+// Reads a decimal number, returns NULL if there is none
+static const uint8_t* parse_uint(const uint8_t* p, uint32_t* value)
+{
+        uint32_t v = 0;
+        p = skip_spaces(p);
+        if (*p < '0' || *p > '9')
+        {
+                return 0;
+        }
+        while (*p >= '0' && *p <= '9')
+        {
+                v = v * 10 + (*p - '0');
+                p++;
+        }
+        *value = v;
+        return p;
+}
+
+// Reads Hz with up to three decimals, returns NULL if there is none or
+// it is out of range
+static const uint8_t* parse_freq(const uint8_t* p, freq_t* f)
+{
+        p = skip_spaces(p);
+        if ((*p < '0' || *p > '9')
+            && (*p != '.' || p[1] < '0' || p[1] > '9'))
+        {
+                return 0;
+        }
+        *f = FMT_parse_freq(p, &p);
+        return *f < FREQ_LIMIT ? p : 0;
+}
+
+// Fills cmd from line[], returns 0 if the line is not a valid command
+static uint8_t parse_line(remote_cmd_t* cmd)
+{
+        const uint8_t* p = skip_spaces(line);
+        uint8_t nargs = 0;
+        uint8_t nfreqs = 0;
+        uint8_t min = 0;
+        uint8_t max = 0;
+        uint8_t freqs = 0;          // bit n: argument n is a frequency
+
+        switch (*p | 0x20)
+        {
+        case 'f':
+                cmd->op = REMOTE_FREQUENCY;
+                min = max = 1;
+                freqs = 1;
+                break;
+        case 'p':
+                cmd->op = REMOTE_PHASE;
+                min = max = 1;
+                break;
+        case 'w':
+                cmd->op = REMOTE_WAVE;
+                min = max = 1;
+                break;
+        case 's':
+                cmd->op = REMOTE_SWEEP;
+                min = 3;
+                max = 4;
+                freqs = 3;
+                break;
+        case 'x':
+                cmd->op = REMOTE_STOP;
+                break;
+        case 'm':
+                cmd->op = REMOTE_STORE;
+                min = max = 1;
+                break;
+        case 'r':
+                cmd->op = REMOTE_RECALL;
+                min = max = 1;
+                break;
+        case 'h':
+                cmd->op = REMOTE_HOP_SET;
+                min = max = 3;
+                break;
+        case 'g':
+                cmd->op = REMOTE_HOP_GO;
+                break;
+        case 'e':
+                cmd->op = REMOTE_TRIGGER;
+                min = 1;
+                max = 2;
+                break;
+        case 'c':
+                cmd->op = REMOTE_CHANNEL;
+                min = 2;
+                max = 3;
+                freqs = 2;
+                break;
+        case 'k':
+                cmd->op = REMOTE_KEY;
+                min = 3;
+                max = 4;
+                break;
+        case 'a':
+                cmd->op = REMOTE_MODULATE;
+                min = max = 5;
+                break;
+        case 'b':
+                cmd->op = REMOTE_BURST;
+                min = 4;
+                max = 5;
+                break;
+        case 'z':
+                cmd->op = REMOTE_STANDBY;
+                min = max = 1;
+                break;
+        case 'd':
+                // The rest of the line is data, spaces and all
+                cmd->op = REMOTE_DATA;
+                if (p[1] != ' ' || p[2] == '\0')
+                {
+                        return 0;
+                }
+                cmd->text = p + 2;
+                cmd->arg[0] = 0;
+                while (cmd->text[cmd->arg[0]])
+                {
+                        cmd->arg[0]++;
+                }
+                return 1;
+        case 't':
+                cmd->op = REMOTE_PROFILE;
+                break;
+        case '?':
+                cmd->op = REMOTE_STATUS;
+                break;
+        default:
+                return 0;
+        }
+        p++;
+
+        for (uint8_t i = 0; i < REMOTE_MAX_ARGS; i++)
+        {
+                cmd->arg[i] = 0;    // optional args default to 0
+        }
+        cmd->freq[0] = cmd->freq[1] = 0;
+        while (nargs < max)
+        {
+                const uint8_t* q;
+                if (freqs & (1 << nargs))
+                {
+                        q = parse_freq(p, &cmd->freq[nfreqs++]);
+                }
+                else
+                {
+                        q = parse_uint(p, &cmd->arg[nargs]);
+                }
+                if (!q)
+                {
+                        break;
+                }
+                p = q;
+                nargs++;
+        }
+        return nargs >= min && *skip_spaces(p) == '\0';
+}
+
+uint8_t REMOTE_poll(remote_cmd_t* cmd)
+{
+        uint8_t ch;
+        while (UART_read(&ch))
+        {
+                if (ch & 0x80)
+                {
+                        word = ch & 0x7f;
+                        word_bytes = WORD_BYTES - 1;
+                        continue;
+                }
+                if (word_bytes)
+                {
+                        word = (word << 7) | ch;
+                        if (--word_bytes == 0)
+                        {
+                                cmd->op = REMOTE_WORD;
+                                cmd->arg[0] = word;
+                                return 1;
+                        }
+                        continue;
+                }
+                if (ch != '\r' && ch != '\n')
+                {
+                        if (line_len < REMOTE_LINE_LENGTH)
+                        {
+                                line[line_len++] = ch;
+                        }
+                        else
+                        {
+                                line_overflow = 1;
+                        }
+                        continue;
+                }
+                if (line_len == 0 && !line_overflow)
+                {
+                        continue;        // CR LF, or an empty line
+                }
+                line[line_len] = '\0';
+                line_len = 0;
+                if (!line_overflow && parse_line(cmd))
+                {
+                        return 1;
+                }
+                line_overflow = 0;
+                REMOTE_reply(0);
+        }
+        return 0;
+}
+
+void REMOTE_reply(uint8_t ok)
+{
+        UART_write_string_P(ok ? PSTR("OK\r\n") : PSTR("ERR\r\n"));
+}
+
+static void write_uint(uint32_t v)
+{
+        uint8_t digits[11];
+        uint8_t i = 0;
+        FMT_uint(digits, v, 10);
+        while (digits[i] == ' ')
+        {
+                i++;
+        }
+        UART_write_string(&digits[i]);
+}
+
+void REMOTE_reply_status(freq_t f, const uint8_t* label)
+{
+        uint8_t digits[5];
+        uint16_t mhz;
+        UART_write_string_P(PSTR("F "));
+        write_uint(FMT_split_freq(f, &mhz));
+        // 1000 up, so the zeros after the point are not blanked
+        FMT_uint(digits, mhz + 1000U, 4);
+        digits[0] = '.';
+        UART_write_string(digits);
+        UART_write(' ');
+        UART_write_string(label);
+        UART_write_string_P(PSTR("\r\n"));
+}
+
+void REMOTE_reply_values(const char* label, const uint32_t* v, uint8_t n)
+{
+        UART_write_string_P(label);
+        for (uint8_t i = 0; i < n; i++)
+        {
+                UART_write(' ');
+                write_uint(v[i]);
+        }
+        UART_write_string_P(PSTR("\r\n"));
+}
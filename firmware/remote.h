@@ -0,0 +1,172 @@
+//////////////////////////////////////////////////////////////////////////////
+///
+///  \file remote.h
+///
+///  \copy copyright (c) 2023 William R Cooke
+///
+///  @brief Serial remote control protocol.
+///
+///  Text commands are one line each, ended by CR or LF, letters in either
+///  case.  Each is answered with "OK" or "ERR":
+///
+///      F <hz>                    set frequency, stops a sweep
+///      P <degrees>               set phase; ERR while hops play
+///      W <0-3>                   sine, ramp, square, square/2; ERR
+///                                while hops play
+///      S <f1> <f2> <ms> [<0|1>]  sweep, linear (0) or log (1)
+///      X                         stop sweep or hops, back to the knob
+///      M <slot>                  store settings, slot 0-9; ERR while
+///                                the EEPROM write queue is full
+///      R <slot>                  recall settings, after queued writes;
+///                                ERR if the slot was never stored
+///      H <i> <hz> <ms>           set hop list entry i 0-15, ms 0 ends
+///                                it; ERR while the write queue is full
+///      G                         play the hop list in a loop
+///      E <edge> [<n>]            trigger sweeps, hops and bursts: free
+///                                running (0), or one run per rising (1)
+///                                or falling (2) edge on PB0; sync pulse
+///                                on PC4 at each sweep start and every
+///                                10^n Hz, n 1-7, 0 for no markers
+///      C <ch> <hz> [<deg>]       set channel 1 up to hz, 0 to follow
+///                                channel 0, and its phase; ERR unless
+///                                built with AD9833_CHANNELS > 1, or
+///                                while hops play
+///      K <mode> <baud> <hz0> [<hz1>]
+///                                key FSK (mode 0) between space hz0 and
+///                                mark hz1, or BPSK (mode 1) on carrier
+///                                hz0; add 2 to frame each byte with a
+///                                start and stop bit.  Idles on mark.
+///      A <mode> <rate> <hz> <tone> <n>
+///                                modulate carrier hz with a tone Hz
+///                                sine, updated rate times a second:
+///                                FM (mode 0) n Hz peak deviation, AM
+///                                (1) n % depth, pulse (2) n % duty
+///      B <mode> <hz> <n> <ms> [<count>]
+///                                gate carrier hz on for n cycles (mode
+///                                0) or n ms (1), every ms, 0 for once,
+///                                count times, 0 for no end; add 2 to
+///                                gate with SLEEP1 instead of RESET.
+///                                With E set, each edge starts it.
+///      Z <0-2>                   standby: DAC off (1), or clock and DAC
+///                                off (2), LCD off, everything stopped;
+///                                0, any other command but ? and T, a
+///                                key or the knob wakes it, tracking
+///      D <text>                  key the bytes of text, after the one
+///                                space; ERR unless keying or if there
+///                                is not room for all of it
+///      T                         report hot-path cycle counts, a line
+///                                "<probe> <calls> <min> <avg> <max>" each
+///                                and "Overrun <n>", then OK; ERR unless
+///                                built with PROF_ENABLE
+///      ?                         report "F <hz> <state>"
+///
+///  The <hz> of F, S and C, and <f1> and <f2>, may have up to three
+///  decimals, "F 1000.125"; "?" answers with three.
+///
+///  Binary tuning words can be mixed in at any point.  A word is sent as
+///  four bytes of seven bits each, most significant first; the first byte
+///  has bit 7 set and the other three have it clear, so a frame is always
+///  found again after a lost byte.  Binary words get no reply.
+///
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef REMOTE_H
+#define REMOTE_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include "freq.h"
+
+// Longest text command, without the line end
+#define REMOTE_LINE_LENGTH   40
+
+// Most numbers a command takes
+#define REMOTE_MAX_ARGS      5
+#define REMOTE_MAX_FREQS     2
+
+        typedef enum REMOTE_OP
+        {
+                REMOTE_NONE,
+                REMOTE_FREQUENCY,       // freq[0]
+                REMOTE_PHASE,           // arg[0] degrees
+                REMOTE_WAVE,            // arg[0] AD9833_WaveMode_t
+                REMOTE_SWEEP,           // freq[0..1] F1, F2, arg[2..3]
+                                        // ms, mode
+                REMOTE_STOP,
+                REMOTE_STORE,           // arg[0] slot
+                REMOTE_RECALL,          // arg[0] slot
+                REMOTE_STATUS,
+                REMOTE_WORD,            // arg[0] 28 bit tuning word
+                REMOTE_HOP_SET,         // arg[0..2] entry, Hz, dwell ms
+                REMOTE_HOP_GO,
+                REMOTE_PROFILE,
+                REMOTE_CHANNEL,         // arg[0] channel, freq[0],
+                                        // arg[2] degrees
+                REMOTE_KEY,             // arg[0..3] mode, baud, Hz 0, Hz 1
+                REMOTE_DATA,            // text, arg[0] bytes
+                REMOTE_TRIGGER,         // arg[0..1] TrigEdge_t, marker decade
+                REMOTE_MODULATE,        // arg[0..4] mode, rate, Hz, tone,
+                                        // amount
+                REMOTE_BURST,           // arg[0..4] mode, Hz, length,
+                                        // period ms, count
+                REMOTE_STANDBY          // arg[0] 0 wake, 1 DAC off, 2 all
+        } RemoteOp_t;
+
+// REMOTE_BURST mode bits
+#define REMOTE_BURST_MS      1          // length in ms, not carrier cycles
+#define REMOTE_BURST_SLEEP   2          // gate with SLEEP1, not RESET
+
+        typedef struct REMOTE_CMD
+        {
+                RemoteOp_t op;
+                uint32_t   arg[REMOTE_MAX_ARGS];
+                // Frequency arguments, in order; their arg[] is 0
+                freq_t     freq[REMOTE_MAX_FREQS];
+                // REMOTE_DATA: in the line buffer, good until the next poll
+                const uint8_t* text;
+        } remote_cmd_t;
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn REMOTE_init
+/// @brief Starts the UART and clears the parser.
+//////////////////////////////////////////////////////////////////////////////
+        void REMOTE_init(void);
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn REMOTE_poll
+/// @brief Parses received bytes until a command is complete or none are
+///        left.  Malformed text lines are answered with "ERR" here.
+/// @param[out] cmd  The command, valid when 1 is returned.
+/// @return 1 if cmd holds a command, else 0.
+//////////////////////////////////////////////////////////////////////////////
+        uint8_t REMOTE_poll(remote_cmd_t* cmd);
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn REMOTE_reply
+/// @brief Answers a text command.
+/// @param[in] ok  Non zero sends "OK", zero sends "ERR".
+//////////////////////////////////////////////////////////////////////////////
+        void REMOTE_reply(uint8_t ok);
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn REMOTE_reply_status
+/// @brief Answers '?' with "F <hz> <label>", hz to three decimals.
+//////////////////////////////////////////////////////////////////////////////
+        void REMOTE_reply_status(freq_t f, const uint8_t* label);
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn REMOTE_reply_values
+/// @brief Sends "<label> <v0> <v1> ..." as one line.
+/// @param[in] label  String in flash, such as PSTR() or PROF_name().
+//////////////////////////////////////////////////////////////////////////////
+        void REMOTE_reply_values(const char* label, const uint32_t* v,
+                                 uint8_t n);
+
+#ifdef __cplusplus
+}
+#endif  // __cplusplus
+#endif  // #ifndef REMOTE_H
@@ -0,0 +1,49 @@
+//////////////////////////////////////////////////////////////////////////////
+///
+///  \file ring.h
+///
+///  \copy copyright (c) 2023 William R Cooke
+///
+///  @brief Index arithmetic for power-of-two rings.
+///
+///  A ring is an array of a power-of-two size up to 256 and two uint8_t
+///  indexes: head, the next free slot, moved only by the producer, and
+///  tail, the next to take, moved only by the consumer.  The ring is
+///  empty when they are equal, and one slot is always left free so that
+///  full and empty differ.  A byte index is read and written in one
+///  instruction, so when the two ends run in different contexts each
+///  side can read the other's index without masking interrupts.
+///
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef RING_H
+#define RING_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+
+// Fails the build unless size is a power of two from 2 to 256
+#define RING_CHECK(size)                                                \
+        _Static_assert((size) >= 2 && (size) <= 256                     \
+                       && ((size) & ((size) - 1)) == 0,                 \
+                       #size " is not a power of two up to 256")
+
+// The index after i
+#define RING_NEXT(i, size)        ((uint8_t)(((i) + 1) & ((size) - 1)))
+
+// Entries waiting between tail and head
+#define RING_USED(head, tail, size)                                     \
+        ((uint8_t)((uint8_t)((head) - (tail)) & ((size) - 1)))
+
+// Slots free for the producer
+#define RING_ROOM(head, tail, size)                                     \
+        ((uint8_t)((uint8_t)((tail) - (head) - 1) & ((size) - 1)))
+
+#ifdef __cplusplus
+}
+#endif  // __cplusplus
+#endif  // #ifndef RING_H
@@ -0,0 +1,142 @@
+//////////////////////////////////////////////////////////////////////////////
+///
+///  \file sched.c
+///
+///  \copy copyright (c) 2023 William R Cooke
+///
+///  @brief Cooperative millisecond scheduler with task priorities.
+///
+//////////////////////////////////////////////////////////////////////////////
+
+#include <stdint.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/sleep.h>
+#include <util/atomic.h>
+#include "systick.h"
+#include "sched.h"
+
+typedef struct SCHED_TASK
+{
+        sched_fn_t fn;
+        uint16_t   period_ms;
+        uint32_t   next_ms;         // due when SYSTICK reaches this
+        uint16_t   overruns;
+} sched_task_t;
+
+static sched_task_t     tasks[SCHED_MAX_TASKS];
+static uint8_t          n_tasks;
+static volatile uint8_t posted;     // bit per task
+static uint16_t         tick_overruns;
+
+uint8_t SCHED_add(sched_fn_t fn, uint16_t period_ms)
+{
+        if (n_tasks == SCHED_MAX_TASKS)
+        {
+                return 0xff;
+        }
+        sched_task_t* t = &tasks[n_tasks];
+        t->fn = fn;
+        t->period_ms = period_ms;
+        t->next_ms = SYSTICK_get_milliseconds();
+        t->overruns = 0;
+        return n_tasks++;
+}
+
+void SCHED_post(uint8_t id)
+{
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+        {
+                posted |= (uint8_t)(1 << id);
+        }
+}
+
+// Takes task id's posted bit, returns whether it was set
+static uint8_t take_posted(uint8_t id)
+{
+        uint8_t bit = (uint8_t)(1 << id);
+        uint8_t was;
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+        {
+                was = posted & bit;
+                posted &= (uint8_t)~bit;
+        }
+        return was;
+}
+
+static uint8_t due(sched_task_t* t, uint32_t now)
+{
+        if (t->period_ms == 0 || (int32_t)(now - t->next_ms) < 0)
+        {
+                return 0;
+        }
+        if (now - t->next_ms >= t->period_ms)
+        {
+                // A whole slot went by; skip it rather than run twice
+                t->overruns++;
+                t->next_ms = now + t->period_ms;
+        }
+        else
+        {
+                t->next_ms += t->period_ms;
+        }
+        return 1;
+}
+
+// Sleeps until the next interrupt unless a task was posted meanwhile
+static void idle(void)
+{
+#if SCHED_IDLE_SLEEP
+        cli();
+        if (!posted)
+        {
+                sleep_enable();
+                sei();              // the instruction after sei always runs
+                sleep_cpu();
+                sleep_disable();
+        }
+        sei();
+#endif
+}
+
+void SCHED_run(void)
+{
+        uint32_t prev_ms = SYSTICK_get_milliseconds();
+        set_sleep_mode(SLEEP_MODE_IDLE);
+        while (1)
+        {
+                uint32_t now = SYSTICK_get_milliseconds();
+                if (now == prev_ms && !posted)
+                {
+                        idle();
+                        continue;
+                }
+                prev_ms = now;
+                for (uint8_t i = 0; i < n_tasks; i++)
+                {
+                        sched_task_t* t = &tasks[i];
+                        // Both are checked so a posted periodic task
+                        // keeps its slot
+                        uint8_t run = due(t, now);
+                        if (take_posted(i) || run)
+                        {
+                                t->fn(now);
+                                if (SYSTICK_get_milliseconds() != now)
+                                {
+                                        tick_overruns++;
+                                        break;
+                                }
+                        }
+                }
+        }
+}
+
+uint16_t SCHED_overruns(uint8_t id)
+{
+        return id < n_tasks ? tasks[id].overruns : 0;
+}
+
+uint16_t SCHED_tick_overruns(void)
+{
+        return tick_overruns;
+}
@@ -0,0 +1,75 @@
+//////////////////////////////////////////////////////////////////////////////
+///
+///  \file sched.h
+///
+///  \copy copyright (c) 2023 William R Cooke
+///
+///  @brief Cooperative millisecond scheduler with task priorities.
+///
+///  Tasks run to completion, in the order they were added, which is
+///  their priority.  A task is due when its period has elapsed or when it
+///  has been posted.  If a new tick arrives while tasks are still running
+///  the pass stops and starts again from the first task, so the tasks
+///  added first (the DDS work) always run on every tick and the rest
+///  catch up when there is time.  Between ticks the CPU idle-sleeps until
+///  the next interrupt.
+///
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef SCHED_H
+#define SCHED_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+
+#define SCHED_MAX_TASKS    6
+
+// 1: sleep in SLEEP_MODE_IDLE between ticks, 0: poll SYSTICK
+#ifndef SCHED_IDLE_SLEEP
+#define SCHED_IDLE_SLEEP   1
+#endif
+
+        typedef void (*sched_fn_t)(uint32_t now_ms);
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn SCHED_add
+/// @brief Adds a task below those already added.
+/// @param[in] fn         Called with the current SYSTICK time.
+/// @param[in] period_ms  Runs every period_ms, 0 only when posted.
+/// @return Task id for SCHED_post(), or 0xff if the table is full.
+//////////////////////////////////////////////////////////////////////////////
+        uint8_t SCHED_add(sched_fn_t fn, uint16_t period_ms);
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn SCHED_post
+/// @brief Makes task id due on the next pass.  Safe from an ISR.
+//////////////////////////////////////////////////////////////////////////////
+        void SCHED_post(uint8_t id);
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn SCHED_run
+/// @brief Runs the tasks forever.
+//////////////////////////////////////////////////////////////////////////////
+        void SCHED_run(void);
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn SCHED_overruns
+/// @param[in] id  A task id.
+/// @return Times that periodic task missed a whole period.
+//////////////////////////////////////////////////////////////////////////////
+        uint16_t SCHED_overruns(uint8_t id);
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn SCHED_tick_overruns
+/// @return Passes cut short because the next tick arrived.
+//////////////////////////////////////////////////////////////////////////////
+        uint16_t SCHED_tick_overruns(void);
+
+#ifdef __cplusplus
+}
+#endif  // __cplusplus
+#endif  // #ifndef SCHED_H
@@ -5,36 +5,69 @@
 //////////////////////////////////////////////////////////////////////////////
 
 #include <stdint.h>
-#include <ctype.h>
 
 
 #define F_CPU 16000000
-#include <util/delay.h>
 
 #include <avr/interrupt.h>
-#include <avr/eeprom.h>
-#include "avrlib/systick.h"
-#include "avrlib/gpio.h"
-#include "avrlib/button.h"
-#include "avrlib/softspi.h"
-#include "avrlib/lcd_44780.h"
-#include "avrlib/encoder.h"
-#include "avrlib/keypad.h"
+#include <avr/pgmspace.h>
+#include <string.h>
+#include "systick.h"
+#include "gpio.h"
+#include "button.h"
+#include "softspi.h"
+#include "lcd.h"
+#include "keypad.h"
+#include "sweep.h"
+#include "tuning.h"
+#include "AD9833.h"
+#include "display.h"
+#include "knob.h"
+#include "remote.h"
+#include "timer1.h"
+#include "ddsq.h"
+#include "hop.h"
+#include "sched.h"
+#include "prof.h"
+#include "uart.h"
+#include "freq.h"
+#include "fmt.h"
+#include "eewrite.h"
+#include "journal.h"
+#include "keyer.h"
+#include "input.h"
+#include "trig.h"
+#include "mod.h"
+#include "burst.h"
 
 // DDS input clock frequency
 #define MASTER_CLOCK     25000000L
-// DDS max output frequency + 1
+// DDS max output frequency + 1, Hz, and as a freq_t
 #define MAX_OUTPUT_FREQ  11000000L
+#define MAX_OUTPUT_MHZ   FREQ_HZ(MAX_OUTPUT_FREQ)
+
+// Engines outputs_stop() can be told to leave running
+#define OUT_SWEEP        0x01
+#define OUT_HOP          0x02
+#define OUT_KEYER        0x04
+#define OUT_MOD          0x08
+#define OUT_BURST        0x10
+#define OUT_TRIG         0x20
 #define COUNTER_LENGTH
 
 static void DDS_init(void);
-static void DDS_write_word(uint16_t wd);
-static void DDS_write_frequency(uint32_t hz);
+static void DDS_write_tuning_word(uint32_t n);
+static void DDS_write_frequency(freq_t f);
 static void DDS_write_phase( uint16_t deg );
+static void apply_settings(void);
+static void input_event(const input_event_t* ev);
+#if AD9833_CHANNELS > 1
+static void apply_channels(uint8_t resync);
+#endif
 
 
-// Storage for int_to_str function
-static uint8_t intstr[9];   // 8 digits plus null
+// Storage for show_int_at and show_freq_at
+static uint8_t intstr[FMT_FREQ_WIDTH + 1];
 
 // Table to convert from keypad scan code to char
 // Translate keypad scan codes to characters
@@ -42,14 +75,16 @@ static uint8_t intstr[9];   // 8 digits plus null
 //    4  5  6  <
 //    1  2  3  -
 //    *  0  #  +
-static const uint8_t keytable[] =
+static const uint8_t keytable[] PROGMEM =
 {
         '*', '1','4','7','0','2','5','8','#','3','6','9','r','s','?','B'
 };
 
 // Place to put incoming keypad string
-// For up to 99mhz we need 8 chars plus a null
-#define KP_STRING_LENGTH    (8+1)
+// For up to 99mhz to the mHz we need 8 chars, a point and 3 more, plus
+// a null.  The display shows the last KP_SHOWN.
+#define KP_STRING_LENGTH    (8+1+3+1)
+#define KP_SHOWN            8
 static uint8_t keypad_string[KP_STRING_LENGTH];
 static uint8_t kp_string_index = 0;
 
@@ -71,6 +106,15 @@ typedef enum INPUT_STATE
         INPUT_STATE_SWEEP,
         INPUT_STATE_STORE,
         INPUT_STATE_RECALL,
+        INPUT_STATE_REMOTE,
+        INPUT_STATE_HOP,
+        INPUT_STATE_KEYING,
+        INPUT_STATE_PROFILE,
+        INPUT_STATE_CH_HZ,
+        INPUT_STATE_CH_DEG,
+        INPUT_STATE_MODULATE,
+        INPUT_STATE_BURST,
+        INPUT_STATE_STANDBY,
         INPUT_STATE_UNDEFINED
 } InputState_t;
 
@@ -88,27 +132,219 @@ typedef enum INPUT_STATE
 //     //static float hz_per_ms;
 //static int32_t millihz_per_ms;
 
-typedef struct SETTINGS
+// Packed, so there is no padding for the memcmp()s to trip over
+typedef struct __attribute__((packed)) SETTINGS
+{
+        freq_t   frequency;
+        freq_t   sweep_F1;
+        freq_t   sweep_F2;
+        uint32_t sweep_ms;
+#if AD9833_CHANNELS > 1
+        // Channels 1 up: frequency, 0 to follow channel 0, and phase in
+        // degrees
+        freq_t   channel_hz[AD9833_CHANNELS - 1];
+        uint16_t channel_deg[AD9833_CHANNELS - 1];
+#endif
+        uint8_t  state;             // InputState_t
+        uint8_t  sweep_mode;        // SweepMode_t
+        uint8_t  sweep_trigger;     // TRIG_ edge and marker decade, for
+                                    // sweeps and the hop list
+} settings_t;
+
+// settings_t as the journal keeps it.  Each frequency is FREQ_BITS
+// wide: the low 32 bits go in its own field and the top two in
+// freq_top, frequency first, so a 2 channel record still fits.  Bytes
+// last, and packed, so the record is the same size on the AVR and the
+// host.
+typedef struct __attribute__((packed)) SETTINGS_RECORD
 {
-        InputState_t state;
         uint32_t frequency;
         uint32_t sweep_F1;
         uint32_t sweep_F2;
         uint32_t sweep_ms;
-        uint32_t millhz_per_ms;
-} settings_t;
+#if AD9833_CHANNELS > 1
+        uint32_t channel_hz[AD9833_CHANNELS - 1];
+        uint16_t channel_deg[AD9833_CHANNELS - 1];
+#endif
+        uint8_t  freq_top;
+        uint8_t  state;
+        uint8_t  sweep_mode;
+        uint8_t  sweep_trigger;
+} settings_record_t;
+
+// Bits 33-32 of a frequency, placed for freq_top, and back
+#define FREQ_TOP(f, i)       ((uint8_t)(((f) >> 32) & 3) << (2 * (i)))
+#define FREQ_JOIN(lo, top, i) \
+        ((freq_t)(((top) >> (2 * (i))) & 3) << 32 | (lo))
+
+// Bump when settings_record_t changes, so older records are ignored
+#define SETTINGS_VERSION   4
+
+_Static_assert(sizeof(settings_record_t) <= JOURNAL_DATA_MAX,
+               "settings_record_t does not fit a journal record");
+_Static_assert(FREQ_BITS == 34 && AD9833_CHANNELS + 2 <= 4,
+               "freq_top has no room for every frequency's top bits");
 
 
 settings_t current;
-// EEPROM storage for settings
-// 0-9 for sto/rcl -- 10 for "current"
-settings_t saved_settings[11] __attribute__((section(".eeprom")));
+// Settings live in the journal: 0-9 for sto/rcl, JOURNAL_CURRENT for the
+// state at the last power down
+
+// The last state as last journaled, and as eeprom_task last saw it
+static settings_t autosaved;
+static settings_t settling;
+static uint32_t settling_ms;
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn settings_write
+/// @brief Packs s into a settings_record_t and queues it for the journal.
+/// @return 1 if queued, 0 if the write queue is full.
+//////////////////////////////////////////////////////////////////////////////
+static uint8_t settings_write(uint8_t slot, const settings_t* s)
+{
+        settings_record_t r;
+        r.frequency = (uint32_t)s->frequency;
+        r.sweep_F1 = (uint32_t)s->sweep_F1;
+        r.sweep_F2 = (uint32_t)s->sweep_F2;
+        r.sweep_ms = s->sweep_ms;
+        r.freq_top = FREQ_TOP(s->frequency, 0) | FREQ_TOP(s->sweep_F1, 1)
+                | FREQ_TOP(s->sweep_F2, 2);
+#if AD9833_CHANNELS > 1
+        for (uint8_t c = 0; c < AD9833_CHANNELS - 1; c++)
+        {
+                r.channel_hz[c] = (uint32_t)s->channel_hz[c];
+                r.channel_deg[c] = s->channel_deg[c];
+                r.freq_top |= FREQ_TOP(s->channel_hz[c], 3 + c);
+        }
+#endif
+        r.state = s->state;
+        r.sweep_mode = s->sweep_mode;
+        r.sweep_trigger = s->sweep_trigger;
+        return JOURNAL_write(slot, &r);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn settings_read
+/// @brief Reads a slot's settings_record_t and unpacks it into s.
+/// @return 1 if read, 0 if the slot is empty or bad; s is then untouched.
+//////////////////////////////////////////////////////////////////////////////
+static uint8_t settings_read(uint8_t slot, settings_t* s)
+{
+        settings_record_t r;
+        if (!JOURNAL_read(slot, &r))
+        {
+                return 0;
+        }
+        s->frequency = FREQ_JOIN(r.frequency, r.freq_top, 0);
+        s->sweep_F1 = FREQ_JOIN(r.sweep_F1, r.freq_top, 1);
+        s->sweep_F2 = FREQ_JOIN(r.sweep_F2, r.freq_top, 2);
+        s->sweep_ms = r.sweep_ms;
+#if AD9833_CHANNELS > 1
+        for (uint8_t c = 0; c < AD9833_CHANNELS - 1; c++)
+        {
+                s->channel_hz[c] = FREQ_JOIN(r.channel_hz[c], r.freq_top,
+                                             3 + c);
+                s->channel_deg[c] = r.channel_deg[c];
+        }
+#endif
+        s->state = r.state;
+        s->sweep_mode = r.sweep_mode;
+        s->sweep_trigger = r.sweep_trigger;
+        return 1;
+}
 
 // For use when STORING settings
 InputState_t saved_state;
 
+// Frequency the knob is tuning
+static freq_t tune_freq;
+
+// Knob step in TRACK, mHz, moved with the '?' key.  TUNE_DIGIT_AUTO
+// starts at 1 Hz and speeds up with the knob; the others step one digit.
+#define TUNE_DIGIT_AUTO  0
+#define TUNE_DIGITS      11
+static uint8_t tune_digit = TUNE_DIGIT_AUTO;
+static const uint32_t tune_step[TUNE_DIGITS] PROGMEM =
+{
+        1000, 1, 10, 100, 1000, 10000, 100000, 1000000, 10000000,
+        100000000, 1000000000
+};
+
+// State names on the LCD and in '?' answers: 7 characters and the end
+#define STATE_LABEL_SIZE 8
+static const char tune_label[TUNE_DIGITS][STATE_LABEL_SIZE] PROGMEM =
+{
+        "Trk Acc", "Trk.001", "Trk .01", "Trk .1 ", "Trk 1  ", "Trk 10 ",
+        "Trk 100", "Trk 1k ", "Trk 10k", "Trk100k", "Trk 1M "
+};
+
+// Last tuning word streamed in over the serial port
+static uint32_t remote_word;
+
+// Serial commands handled per loop pass, so a binary stream can't
+// starve the keypad and display
+#define REMOTE_PER_PASS  4
+
+// Keypad and button events handled per loop pass; the rest wait in order
+#define INPUT_PER_PASS   4
+
+// Task periods.  Tasks run in the order run() adds them.
+#define DDS_PERIOD_MS      1
+#define INPUT_PERIOD_MS    1
+#define DISPLAY_PERIOD_MS  2
+#define EEPROM_PERIOD_MS   4    // about one EEPROM byte write
+
+// The last state is journaled once it has been left alone this long
+#define AUTOSAVE_MS        2000
+
+// The title stays up this long while the output already runs
+#define SPLASH_MS          1000
+
+// Output frequency as of the last dds_task, for display and status
+static freq_t   out_freq;
+static uint32_t sweep_word;
+
+// Output while waiting for a trigger, and what the edge starts:
+// INPUT_STATE_SWEEP, INPUT_STATE_HOP or INPUT_STATE_BURST
+static freq_t   park_freq;
+static uint8_t  trig_run;
+
+// KeyerMode_t and space or carrier Hz while keying
+static uint8_t  key_mode;
+static uint32_t key_hz;
+
+// Modulation: ModMode_t, updates per second, carrier, tone Hz, and
+// FM deviation in Hz or AM depth or pulse duty in percent.  The keypad
+// changes the mode and amount, the rest stay as the last 'A' left them.
+static uint8_t  mod_mode = MOD_FM;
+static uint16_t mod_rate = 8000;
+static freq_t   mod_freq;
+static uint16_t mod_tone = 1000;
+static uint32_t mod_amount = 3000;
+
+// Carrier the bursts gate; the rest is as BURST_set() was last given it
+static uint32_t burst_hz;
+
+// AD9833_SleepMode_t the chips are in during INPUT_STATE_STANDBY
+static uint8_t standby_mode;
+
+// Slot waiting for the EEPROM task to recall it
+#define NO_RECALL          0xff
+static uint8_t recall_entry = NO_RECALL;
+static uint8_t eeprom_task_id;
+
+#if PROF_ENABLE
+// Hidden page: '?' in Pause shows one probe per page, row 0 name and max
+// cycles, row 1 min and average.  The last page is passes cut short, then
+// DDS task slots missed and serial bytes lost.
+static uint8_t prof_page;
+// Next line of a serial 'T' report, PROF_COUNT + 1 when none is going
+static uint8_t prof_line = PROF_COUNT + 1;
+// Room a report line needs in the transmit ring
+#define PROF_LINE_BYTES  48
+#endif
+
 //static uint8_t read_encoder(void);
-static void int_to_string(int32_t);
 
 static void run(void);
 
@@ -129,10 +365,25 @@ static void run(void);
 // D2   Reserved
 // D1   Mode    1: bypass SIN ROM, triangle out (OPBITEN 0) 0: use ROM
 // D0   Reserved
+// 1: load the idle FREQ register, then switch to it with one control
+// word so the output never runs on half old, half new tuning word.
+// 0: write the changed halves straight into the active register.
+#define DDS_PINGPONG     1
+
+static uint8_t  dds_pingpong = DDS_PINGPONG;
+
+// Chip 0 and the channels following it; the knob, sweeps and hops write
+// them all in one transaction
+static uint8_t  lead_chips = AD9833_CH(0);
+
+#if AD9833_CHANNELS > 1
+// Channel being edited in INPUT_STATE_CH_HZ and INPUT_STATE_CH_DEG
+static uint8_t  edit_channel;
+#endif
 
 static void keypad_clear(void)
 {
-        for(int i = 0; i < (8); i++) // KP_STRING_LENGTH - 1); i++)
+        for(int i = 0; i < KP_STRING_LENGTH - 1; i++)
         {
                 keypad_string[i] = ' ';
         }
@@ -162,26 +413,227 @@ static void keypad_remove(void)
 
 static void show_int_at( int x, int y, int32_t val)
 {
-        int_to_string(val);
-        cli();
-        LCD_44780_goto(x,y);
-        LCD_44780_write_string(intstr);
-        sei();
+        PROF_BEGIN(PROF_SHOW_INT);
+        FMT_uint(intstr, (uint32_t)val, 8);
+        DISPLAY_goto(x,y);
+        DISPLAY_write_string(intstr);
+        PROF_END(PROF_SHOW_INT);
+}
+
+static void show_freq_at(int x, int y, freq_t f)
+{
+        FMT_freq(intstr, f);
+        DISPLAY_goto(x,y);
+        DISPLAY_write_string(intstr);
 }
 
 
- 
-// wont work as is, not enough resolution for all circumstances
-int32_t calc_millihz_per_millisec( int32_t f1, int32_t f2, int32_t time)
+//////////////////////////////////////////////////////////////////////////////
+/// @fn outputs_stop
+/// @brief Stops every engine that drives the output, and disarms the
+///        trigger, except those in keep.
+/// @param[in] keep  OUT_ flags of engines to leave alone.
+//////////////////////////////////////////////////////////////////////////////
+static void outputs_stop(uint8_t keep)
 {
-  int32_t ms = time * 1000;
-  int32_t millihz = (f2 - f1) * 1000;
-  int32_t millihz_per_ms = millihz / ms;
-  if ( millihz_per_ms == 0)
-  {
-    millihz_per_ms = 1;
-  }
-  return millihz_per_ms;
+        if (!(keep & OUT_SWEEP))
+        {
+                SWEEP_stop();
+        }
+        if (!(keep & OUT_HOP))
+        {
+                HOP_stop();
+        }
+        if (!(keep & OUT_KEYER))
+        {
+                KEYER_stop();
+        }
+        if (!(keep & OUT_MOD))
+        {
+                MOD_stop();
+        }
+        if (!(keep & OUT_BURST))
+        {
+                BURST_stop();
+        }
+        if (!(keep & OUT_TRIG))
+        {
+                TRIG_disarm();
+        }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn trigger_wait
+/// @brief Parks the output at park and arms the trigger input to switch
+///        it to first, which starts run.
+//////////////////////////////////////////////////////////////////////////////
+static void trigger_wait(freq_t park, freq_t first, uint8_t run)
+{
+        DDS_write_frequency(park);
+        park_freq = park;
+        trig_run = run;
+        TRIG_arm(lead_chips, TRIG_EDGE(current.sweep_trigger),
+                 TUNING_freq_to_word(first));
+}
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn sweep_begin
+/// @brief Starts sweeping with the F1, F2, time and mode in current, or
+///        with a trigger set, waits at F2 for an edge to sweep once.
+//////////////////////////////////////////////////////////////////////////////
+static void sweep_begin(void)
+{
+        outputs_stop(OUT_SWEEP);
+        TRIG_markers(TRIG_MARKER(current.sweep_trigger),
+                     FMT_split_freq(current.sweep_F1, NULL));
+        if (TRIG_EDGE(current.sweep_trigger) != TRIG_FREE)
+        {
+                // Where each triggered sweep ends
+                SWEEP_stop();
+                trigger_wait(current.sweep_F2, current.sweep_F1,
+                             INPUT_STATE_SWEEP);
+                return;
+        }
+        SWEEP_start(TUNING_freq_to_word(current.sweep_F1),
+                    TUNING_freq_to_word(current.sweep_F2),
+                    current.sweep_ms, current.sweep_mode,
+                    SYSTICK_get_milliseconds());
+        TRIG_pulse();
+}
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn hops_begin
+/// @brief Plays the hop list in a loop, or with a trigger set, waits on
+///        the last hop for an edge to play it once.
+/// @return Entries, 0 if the list is empty and nothing started.
+//////////////////////////////////////////////////////////////////////////////
+static uint8_t hops_begin(void)
+{
+        hop_t first;
+        hop_t last;
+        outputs_stop(OUT_HOP);
+        uint8_t n = HOP_count();
+        if (TRIG_EDGE(current.sweep_trigger) == TRIG_FREE || n == 0)
+        {
+                return HOP_start();
+        }
+        HOP_stop();
+        HOP_get(0, &first);
+        HOP_get(n - 1, &last);
+        trigger_wait(FREQ_HZ(last.hz), FREQ_HZ(first.hz), INPUT_STATE_HOP);
+        return n;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn burst_begin
+/// @brief Gates a carrier at burst_hz as BURST_set() was last told, at
+///        once, or with a trigger set, from the next edge.
+//////////////////////////////////////////////////////////////////////////////
+static void burst_begin(void)
+{
+        outputs_stop(OUT_BURST | OUT_TRIG);
+        // Between triggered runs nothing is queued and the output is
+        // already off, so retune without letting it on
+        if (BURST_playing() || TRIG_armed())
+        {
+                BURST_stop();
+        }
+        TRIG_disarm();
+        DDS_write_frequency(FREQ_HZ(burst_hz));
+        park_freq = FREQ_HZ(burst_hz);
+        trig_run = INPUT_STATE_BURST;
+        if (TRIG_EDGE(current.sweep_trigger) == TRIG_FREE)
+        {
+                BURST_start();
+        }
+        else
+        {
+                BURST_arm(TRIG_EDGE(current.sweep_trigger));
+        }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn trigger_rearm
+/// @brief Waits for the next edge to start the sweep or hop list again.
+//////////////////////////////////////////////////////////////////////////////
+static void trigger_rearm(void)
+{
+        if (trig_run == INPUT_STATE_SWEEP)
+        {
+                sweep_begin();
+        }
+        else if (trig_run == INPUT_STATE_BURST)
+        {
+                burst_begin();
+        }
+        else
+        {
+                hops_begin();
+        }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn modulate
+/// @brief Stops whatever else drives the output and modulates a carrier
+///        at f with the mod_ settings.
+/// @return 1 if modulating, 0 if f or the deviation is too high.
+//////////////////////////////////////////////////////////////////////////////
+static uint8_t modulate(freq_t f)
+{
+        uint32_t amount = mod_amount;
+        if (f >= MAX_OUTPUT_MHZ
+            || (mod_mode == MOD_FM && mod_amount >= MAX_OUTPUT_FREQ))
+        {
+                return 0;
+        }
+        if (mod_mode == MOD_FM)
+        {
+                amount = TUNING_hz_to_word(mod_amount);
+        }
+        outputs_stop(OUT_MOD);
+        if (!MOD_start(lead_chips, mod_mode, mod_rate, TUNING_freq_to_word(f),
+                       mod_tone, amount))
+        {
+                return 0;
+        }
+        mod_freq = f;
+        current.state = INPUT_STATE_MODULATE;
+        return 1;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn standby_enter
+/// @brief Stops whatever drives the output, puts every chip to sleep and
+///        turns the LCD off.  The ticks carry on, short, so keys and the
+///        knob are still read.
+/// @param[in] md  AD9833_SLEEP_DAC_OFF or AD9833_SLEEP_STOP_DAC_OFF.
+//////////////////////////////////////////////////////////////////////////////
+static void standby_enter(uint8_t md)
+{
+        outputs_stop(0);
+        AD9833_run_mode(AD9833_ALL, (AD9833_SleepMode_t)md);
+        AD9833_update(AD9833_ALL);
+        keypad_clear();
+        DISPLAY_enable(0);
+        standby_mode = md;
+        current.state = INPUT_STATE_STANDBY;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn standby_leave
+/// @brief Wakes the chips on the knob frequency, in the same update as
+///        the tuning word, and turns the LCD back on.
+//////////////////////////////////////////////////////////////////////////////
+static void standby_leave(void)
+{
+        AD9833_run_mode(AD9833_ALL, AD9833_SLEEP_NONE);
+        current.state = INPUT_STATE_TRACK;
+        current.frequency = tune_freq;
+        DDS_write_frequency(tune_freq);
+        // An unchanged word sends nothing, and channels 1 up are not in it
+        AD9833_update(AD9833_ALL);
+        keypad_clear();
+        DISPLAY_enable(1);
 }
 
 
@@ -190,20 +642,20 @@ int main(int argc, char** argv)
         GPIO_pin_mode(GPIO_PIN_D2, GPIO_PIN_MODE_INPUT);
         
         //      for(int i = 1; i < 1000; i++);
-        LCD_44780_init2();
-        LCD_44780_clear();
-        LCD_44780_write_string("SoftRock 33");
         SYSTICK_init(CLK_DIV_64);
-        BUTTON_init();
+        TIMER1_init();
+        TRIG_init();
+#if PROF_ENABLE
+        PROF_init();
+#endif
         SOFTSPI_init2();
-        
-        DDS_init();
-        current.state = INPUT_STATE_TRACK;
 
-        // eeprom test src dst n
-        //eeprom_write_block(&current, 0, sizeof(settings_t));
+        // The output comes first, the LCD and its power-up waits after
+        DDS_init();
+        LCD_init();
+        BUTTON_init();
+        REMOTE_init();
 
-        _delay_ms(2000);
         run();
         
         return 0;
@@ -212,45 +664,139 @@ int main(int argc, char** argv)
 
 void DDS_init(void)
 {
-        // ss on pb2
-        SOFTSPI_set_interface(0, GPIO_PIN_C5, 16, SPI_MODE_2_MSB_FIRST, 0);
-        DDRB |= 0x08;  // b3 output
-        ENCODER_init();
-        ENCODER_set_count(0,0);
+        KNOB_init();
+        tune_freq = 0;
         keypad_clear();
         
         KEYPAD_init();
+        INPUT_init();
+        TUNING_init(MASTER_CLOCK);
+        HOP_init();
+
+        // Last state from the journal, or 60 KHz
+        JOURNAL_init(sizeof(settings_record_t), SETTINGS_VERSION);
+        if (!settings_read(JOURNAL_CURRENT, &current))
+        {
+                current.state = INPUT_STATE_TRACK;
+                current.frequency = FREQ_HZ(60000L);
+        }
+        autosaved = current;
+        settling = current;
         
-        DDS_write_word(0x2100);  // B28 and RESET
-        DDS_write_frequency(60000L);  // 60 KHz
+        AD9833_init();                // In RESET, registers zeroed
+        DDS_write_frequency(current.frequency);
         DDS_write_phase(0);
-        DDS_write_word(0x2000);  // Keep B2B set, take out of reset
+#if AD9833_CHANNELS > 1
+        apply_channels(0);
+#endif
+        AD9833_reset(AD9833_ALL, 0);
+        AD9833_update(AD9833_ALL);    // All out of reset together
+        DDSQ_init();
+        apply_settings();             // sweep or hops
  
         //current_mode = MODE_NORMAL;
         //is_sweeping = 0;
 }
 
-void DDS_write_word(uint16_t wd)
+//////////////////////////////////////////////////////////////////////////////
+/// @fn DDS_write_tuning_word
+/// @brief Sets the output frequency.  In ping-pong mode the word goes into
+///        the idle FREQ register and one control word flips FSEL to it.
+///        The driver sends only the halves that differ from what the
+///        register already holds, and nothing if the output is unchanged.
+/// @param[in] n  28 bit tuning word.
+//////////////////////////////////////////////////////////////////////////////
+void DDS_write_tuning_word(uint32_t n)
 {
-        SOFTSPI_write(0,wd);
+        int active = AD9833_get_selected_freq(0);
+        if (dds_pingpong)
+        {
+                if (AD9833_get_frequency(0, active) == n)
+                {
+                        return;
+                }
+                AD9833_set_frequency(lead_chips, !active, n);
+                AD9833_select_freq(lead_chips, !active);
+        }
+        else
+        {
+                AD9833_set_frequency(lead_chips, active, n);
+        }
+        AD9833_update(lead_chips);
 }
 
-void DDS_write_frequency(uint32_t hz)
+void DDS_write_frequency(freq_t f)
 {
-        uint32_t n = (uint32_t)((uint64_t) hz * (1L << 28) / MASTER_CLOCK);
-        DDS_write_word( (uint16_t)(n & 0x3fff) | 0x4000);
-        DDS_write_word( (uint16_t)((n >> 14) & 0x3fff) | 0x4000);
+        PROF_BEGIN(PROF_DDS_WRITE);
+        DDS_write_tuning_word(TUNING_freq_to_word(f));
+        PROF_END(PROF_DDS_WRITE);
+}
 
+// Degrees to a 12 bit phase word
+static uint16_t deg_to_phase(uint16_t deg)
+{
+        deg %= 360;
+        return (uint16_t)(4096L * deg / 360);
 }
 
 void DDS_write_phase(uint16_t deg)
 {
-        deg %= 360;
-        uint16_t ph = (uint16_t)(4096L * deg / 360);
-        // write it to phase 0 reg
-        ph |= 0xc000; // Set D15, D14 to select ph0
-        DDS_write_word(ph);
+        // write it to chip 0's phase 0 reg
+        AD9833_set_phase(AD9833_CH(0), 0, deg_to_phase(deg));
+        AD9833_update(AD9833_CH(0));
+}
+
+#if AD9833_CHANNELS > 1
+//////////////////////////////////////////////////////////////////////////////
+/// @fn apply_channels
+/// @brief Sets channels 1 up as current describes.  A channel at 0 Hz
+///        follows channel 0: it gets chip 0's frequency registers and FSEL
+///        and joins lead_chips, so every later write reaches it in the
+///        same transaction as chip 0.  Its phase register sets the offset.
+/// @param[in] resync  Non zero pulses RESET on the lead chips when one
+///                    joins, so their accumulators start together again.
+///                    Not wanted at power-up, when all are still in RESET.
+//////////////////////////////////////////////////////////////////////////////
+static void apply_channels(uint8_t resync)
+{
+        uint8_t lead = AD9833_CH(0);
+        for (uint8_t c = 1; c < AD9833_CHANNELS; c++)
+        {
+                freq_t f = current.channel_hz[c - 1];
+                if (f == 0)
+                {
+                        lead |= AD9833_CH(c);
+                }
+                else
+                {
+                        AD9833_set_frequency(AD9833_CH(c), 0,
+                                             TUNING_freq_to_word(f));
+                        AD9833_select_freq(AD9833_CH(c), 0);
+                }
+                AD9833_set_phase(AD9833_CH(c), 0,
+                                 deg_to_phase(current.channel_deg[c - 1]));
+                AD9833_select_phase(AD9833_CH(c), 0);
+        }
+        uint8_t joined = lead & ~lead_chips;
+        if (joined)
+        {
+                int active = AD9833_get_selected_freq(0);
+                AD9833_set_frequency(joined, 0, AD9833_get_frequency(0, 0));
+                AD9833_set_frequency(joined, 1, AD9833_get_frequency(0, 1));
+                AD9833_select_freq(joined, active);
+        }
+        AD9833_update(AD9833_ALL);
+        if (joined && resync)
+        {
+                AD9833_reset(lead, 1);
+                AD9833_update(lead);
+                AD9833_reset(lead, 0);
+                AD9833_update(lead);
+        }
+        lead_chips = lead;
+        DDSQ_chips(lead);
 }
+#endif
 
 
 
@@ -285,41 +831,14 @@ void DDS_write_phase(uint16_t deg)
 
 
 
-static void int_to_string(int32_t num)
+static int32_t string_to_int(uint8_t* str)
 {
-        int idx = 8;
-        intstr[idx] = '\0';
-        for(int i = 0; i < idx; i++)
-        {
-                intstr[i] = ' ';
-        }
-        while(idx > 0)
-        {
-                idx--;
-                intstr[idx] = (uint8_t) (num % 10) + 0x30;
-                num /= 10;
-                if(num == 0)
-                {
-                        break;
-                }
-        }
+        return (int32_t)FMT_parse_uint(str);
 }
 
-
-static int32_t string_to_int(uint8_t* str)
+static freq_t string_to_freq(uint8_t* str)
 {
-        int32_t rtn = 0;
-        while((*str != 0) && (!isdigit(*str)))
-        {
-                str++;
-        }
-        while(isdigit(*str))
-        {
-                rtn *= 10;
-                rtn += *str - '0';
-                str++;
-        }
-        return rtn;
+        return FMT_parse_freq(str, NULL);
 }
 
 typedef enum KEY_RESULT
@@ -331,6 +850,7 @@ typedef enum KEY_RESULT
         KEY_RESULT_STORE,
         KEY_RESULT_RECALL,
         KEY_RESULT_DELETE,
+        KEY_RESULT_OPTION,
         KEY_RESULT_MAX
 }KeyResult_t;
 
@@ -347,11 +867,20 @@ static KeyResult_t  process_key(int ky)
   KeyResult_t rtn = KEY_RESULT_NONE;
   if(ky >= 0)
   {
-    uint8_t ch = keytable[ky];
+    uint8_t ch = pgm_read_byte(&keytable[ky]);
     switch(ch)
     {
     case '*':
-            rtn = KEY_RESULT_MODE;
+            // The decimal point once digits are keyed, else Mode
+            if (keypad_string[KP_STRING_LENGTH - 2] == ' ')
+            {
+                    rtn = KEY_RESULT_MODE;
+            }
+            else if (!strchr((const char*)keypad_string, '.'))
+            {
+                    keypad_add('.');
+                    rtn = KEY_RESULT_DIGIT;
+            }
             break;
     case '#':
             rtn = KEY_RESULT_ENTER;
@@ -362,7 +891,7 @@ static KeyResult_t  process_key(int ky)
             rtn = KEY_RESULT_DELETE;
             break;
     case '?':
-            rtn = KEY_RESULT_NONE;
+            rtn = KEY_RESULT_OPTION;
             break;
     case 's':
             rtn = KEY_RESULT_STORE;
@@ -379,96 +908,716 @@ static KeyResult_t  process_key(int ky)
   return rtn;
 }
 
-static void show_message(uint8_t* msg)
+// msg is in flash
+static void show_message(const char* msg)
 {
-        cli();
-        LCD_44780_goto(9,0);
-        LCD_44780_write_string("       ");
-        LCD_44780_goto(9,0);
-        LCD_44780_write_string(msg);
-        sei();
+        DISPLAY_goto(9,0);
+        DISPLAY_write_string_P(PSTR("       "));
+        DISPLAY_goto(9,0);
+        DISPLAY_write_string_P(msg);
 }
 
-// input state:
-//     tracking
-//     tracking pause
-//     sweep f1
-//     sweep f2
-//     sweep time
-//     sweeping
-//     storing    [st][digit]
-//     recalling  [rcl][digit]
-
 //////////////////////////////////////////////////////////////////////////////
-/// @fn run
-/// @brief Main loop: gets all inputs, processes, sets frequencies, etc.
+/// @fn state_name
+/// @return The name of the current input state, in flash.  A channel's
+///         number is left blank for state_label() to fill in.
 //////////////////////////////////////////////////////////////////////////////
-static void run(void)
+static const char* state_name(void)
 {
-  cli();
-  LCD_44780_clear();
-  sei();
-  uint32_t prev_ms = SYSTICK_get_milliseconds();
-        
-  while(1)
-  {
-          // Wait for clock tick (1 ms)
-          uint32_t new_ms;
-          while ( (new_ms = SYSTICK_get_milliseconds()) == prev_ms);
-          prev_ms = new_ms;
-          
-    int32_t enc = ENCODER_get_count(0);
-    if (enc < 0)
-    {
-      enc = MAX_OUTPUT_FREQ + enc; //0;
-      ENCODER_set_count(0,enc);
-    }
-    if (enc >= MAX_OUTPUT_FREQ)
-    {
-      enc -= MAX_OUTPUT_FREQ;
-      ENCODER_set_count(0,enc);
-    }
-    if ( /*!is_sweeping && */ current.state == INPUT_STATE_TRACK)
-    {
-      DDS_write_frequency(enc);
-      // update display
-    }
-    show_int_at(0,0,enc);
-        
-    int b = BUTTON_get_button();
-    int ky = KEYPAD_get_key();
-    
-    KeyResult_t key_result = process_key(ky);
-
-    // TODO:  For now, we separate keypad and encoder
-    // inputs.  Keypad entry must use ENTER key and
-    // encoder entry must use button.  If keypad entry
-    // is used, set freq to it and also set encoder count
-    // to keypad number.  Later, we will integrate the two.
-    // maybe ...
-    switch(current.state)
-    {
-    case INPUT_STATE_TRACK:
-    {
-      if (b == 0)
-      {
-        current.state = INPUT_STATE_TRACK_PAUSE;
-      }
-      else if (key_result == KEY_RESULT_ENTER)
-      {
-        int32_t f = string_to_int(keypad_string);
-        if (f < MAX_OUTPUT_FREQ)
+        switch(current.state)
         {
-                current.frequency = f;
-          DDS_write_frequency(f);
-          ENCODER_set_count(0,f);
-          keypad_clear();
-          //show_message("valid");
+        case INPUT_STATE_TRACK:
+                return tune_label[tune_digit];
+        case INPUT_STATE_TRACK_PAUSE:
+                return PSTR("Pause  ");
+        case INPUT_STATE_F1:
+                return PSTR("F1     ");
+        case INPUT_STATE_F2:
+                return PSTR("F2     ");
+        case INPUT_STATE_TIME:
+                return PSTR("TIME   ");
+        case INPUT_STATE_SWEEP:
+                if (TRIG_armed())
+                {
+                        return PSTR("SWP TRG");
+                }
+                if (current.sweep_mode == SWEEP_LOG)
+                {
+                        return PSTR("SWP LOG");
+                }
+                return PSTR("SWP LIN");
+        case INPUT_STATE_STORE:
+                return PSTR("STORE  ");
+        case INPUT_STATE_RECALL:
+                return PSTR("RECALL ");
+        case INPUT_STATE_REMOTE:
+                return PSTR("Remote ");
+        case INPUT_STATE_HOP:
+                if (TRIG_armed())
+                {
+                        return PSTR("Hop TRG");
+                }
+                return PSTR("Hop    ");
+        case INPUT_STATE_KEYING:
+                if (key_mode & KEYER_PSK)
+                {
+                        return PSTR("PSK    ");
+                }
+                return PSTR("FSK    ");
+        case INPUT_STATE_PROFILE:
+                return PSTR("Profile");
+        case INPUT_STATE_MODULATE:
+                if (mod_mode == MOD_AM)
+                {
+                        return PSTR("AM     ");
+                }
+                if (mod_mode == MOD_PULSE)
+                {
+                        return PSTR("Pulse  ");
+                }
+                return PSTR("FM     ");
+        case INPUT_STATE_BURST:
+                if (TRIG_armed())
+                {
+                        return PSTR("Bst TRG");
+                }
+                return PSTR("Burst  ");
+        case INPUT_STATE_STANDBY:
+                return standby_mode == AD9833_SLEEP_DAC_OFF
+                        ? PSTR("Stby DA") : PSTR("Standby");
+#if AD9833_CHANNELS > 1
+        case INPUT_STATE_CH_HZ:
+                return PSTR("Ch  Hz ");
+        case INPUT_STATE_CH_DEG:
+                return PSTR("Ch  Deg");
+#endif
+        default:
+                return PSTR("ERROR  ");
         }
-        else
+}
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn state_label
+/// @param[out] label  The 7 character name of the current input state.
+//////////////////////////////////////////////////////////////////////////////
+static void state_label(uint8_t* label)
+{
+        strcpy_P((char*)label, state_name());
+#if AD9833_CHANNELS > 1
+        if (current.state == INPUT_STATE_CH_HZ
+            || current.state == INPUT_STATE_CH_DEG)
+        {
+                label[2] = '0' + edit_channel;
+        }
+#endif
+}
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn store_slot
+/// @brief Queues current for the journal, written in the background.
+/// @return 1 if queued, 0 if entry is not 0-9 or the write queue is full.
+//////////////////////////////////////////////////////////////////////////////
+static uint8_t store_slot(uint32_t entry)
+{
+        if (entry >= JOURNAL_CURRENT)
+        {
+                return 0;
+        }
+        return settings_write((uint8_t)entry, &current);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn recall_slot
+/// @brief Hands the slot to the EEPROM task, which reads it once any
+///        queued writes, possibly to the same slot, have finished.
+/// @return 1 if the slot has been stored, 0 if it is empty or not 0-9.
+//////////////////////////////////////////////////////////////////////////////
+static uint8_t recall_slot(uint32_t entry)
+{
+        if (entry >= JOURNAL_CURRENT || !JOURNAL_has((uint8_t)entry))
+        {
+                return 0;
+        }
+        recall_entry = (uint8_t)entry;
+        SCHED_post(eeprom_task_id);
+        return 1;
+}
+
+static void apply_recall(uint8_t entry)
+{
+        PROF_BEGIN(PROF_EEPROM);
+        uint8_t ok = settings_read(entry, &current);
+        PROF_END(PROF_EEPROM);
+        if (ok)
+        {
+                apply_settings();
+        }
+        else if (current.state == INPUT_STATE_RECALL)
+        {
+                current.state = INPUT_STATE_TRACK;   // bad CRC
+        }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn apply_settings
+/// @brief Starts the output current describes: a sweep, the hop list or
+///        a fixed frequency.
+//////////////////////////////////////////////////////////////////////////////
+static void apply_settings(void)
+{
+        // Hops may hold the driver's shadows, keying, modulation, bursts
+        // or the trigger the control word
+        outputs_stop(OUT_SWEEP);
+#if AD9833_CHANNELS > 1
+        apply_channels(1);
+#endif
+        if (current.state == INPUT_STATE_SWEEP)
+        {
+                sweep_begin();
+        }
+        else if (current.state != INPUT_STATE_HOP || !hops_begin())
+        {
+                // The hop list emptied, or keying, modulation or bursts,
+                // which are not saved
+                if (current.state == INPUT_STATE_HOP
+                    || current.state == INPUT_STATE_KEYING
+                    || current.state == INPUT_STATE_MODULATE
+                    || current.state == INPUT_STATE_BURST)
+                {
+                        current.state = INPUT_STATE_TRACK;
+                }
+                outputs_stop(0);
+                DDS_write_frequency(current.frequency);
+        }
+        tune_freq = current.frequency; // TODO mode
+}
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn remote_command
+/// @brief Carries out a command from the serial port and answers it.
+/// @param[in] cmd     The parsed command.
+/// @param[in] out_freq  Output frequency at the start of this pass.
+//////////////////////////////////////////////////////////////////////////////
+static void remote_command(const remote_cmd_t* cmd, freq_t out_freq)
+{
+        uint8_t ok = 1;
+        uint8_t rearm;
+        uint32_t on;
+        uint8_t label[STATE_LABEL_SIZE];
+        if (current.state == INPUT_STATE_STANDBY && cmd->op != REMOTE_STATUS
+            && cmd->op != REMOTE_PROFILE && cmd->op != REMOTE_STANDBY)
+        {
+                // Anything that sets the output wakes it first
+                standby_leave();
+        }
+        switch (cmd->op)
+        {
+        case REMOTE_FREQUENCY:
+                if (cmd->freq[0] >= MAX_OUTPUT_MHZ)
+                {
+                        ok = 0;
+                        break;
+                }
+                outputs_stop(0);
+                current.state = INPUT_STATE_TRACK;
+                current.frequency = cmd->freq[0];
+                tune_freq = cmd->freq[0];
+                DDS_write_frequency(cmd->freq[0]);
+                break;
+        case REMOTE_PHASE:
+                if (KEYER_running() || HOP_playing()
+                    || current.state == INPUT_STATE_BURST)
+                {
+                        ok = 0;
+                        break;
+                }
+                rearm = TRIG_armed();
+                TRIG_disarm();
+                DDS_write_phase((uint16_t)(cmd->arg[0] % 360));
+                if (rearm)
+                {
+                        trigger_rearm();
+                }
+                break;
+        case REMOTE_WAVE:
+                if (cmd->arg[0] > AD9833_SQR_HALF || KEYER_running()
+                    || MOD_running() || HOP_playing()
+                    || current.state == INPUT_STATE_BURST)
+                {
+                        ok = 0;
+                        break;
+                }
+                rearm = TRIG_armed();
+                TRIG_disarm();
+                AD9833_set_wave_mode(AD9833_ALL,
+                                     (AD9833_WaveMode_t)cmd->arg[0]);
+                AD9833_update(AD9833_ALL);
+                if (rearm)
+                {
+                        trigger_rearm();
+                }
+                break;
+        case REMOTE_SWEEP:
+                if (cmd->freq[0] >= MAX_OUTPUT_MHZ
+                    || cmd->freq[1] >= MAX_OUTPUT_MHZ
+                    || cmd->arg[2] == 0 || cmd->arg[3] > SWEEP_LOG)
+                {
+                        ok = 0;
+                        break;
+                }
+                current.sweep_F1 = cmd->freq[0];
+                current.sweep_F2 = cmd->freq[1];
+                current.sweep_ms = cmd->arg[2];
+                current.sweep_mode = (SweepMode_t)cmd->arg[3];
+                current.state = INPUT_STATE_SWEEP;
+                sweep_begin();
+                break;
+        case REMOTE_STOP:
+                outputs_stop(0);
+                current.state = INPUT_STATE_TRACK;
+                tune_freq = current.frequency;
+                DDS_write_frequency(current.frequency);
+                break;
+        case REMOTE_STORE:
+        case REMOTE_RECALL:
+                if (cmd->arg[0] > 9)
+                {
+                        ok = 0;
+                }
+                else if (cmd->op == REMOTE_STORE)
+                {
+                        ok = store_slot(cmd->arg[0]);
+                }
+                else
+                {
+                        ok = recall_slot(cmd->arg[0]);
+                }
+                break;
+        case REMOTE_STATUS:
+                if (current.state == INPUT_STATE_TRACK)
+                {
+                        out_freq = tune_freq;   // may have changed this pass
+                }
+                state_label(label);
+                REMOTE_reply_status(out_freq, label);
+                return;
+        case REMOTE_HOP_SET:
+                ok = cmd->arg[1] < MAX_OUTPUT_FREQ && cmd->arg[2] <= 0xffff
+                        && HOP_set((uint8_t)cmd->arg[0], cmd->arg[1],
+                                   (uint16_t)cmd->arg[2]);
+                break;
+        case REMOTE_CHANNEL:
+#if AD9833_CHANNELS > 1
+                if (cmd->arg[0] == 0 || cmd->arg[0] >= AD9833_CHANNELS
+                    || cmd->freq[0] >= MAX_OUTPUT_MHZ || HOP_playing()
+                    || KEYER_running() || MOD_running() || TRIG_armed()
+                    || current.state == INPUT_STATE_BURST)
+                {
+                        ok = 0;
+                        break;
+                }
+                current.channel_hz[cmd->arg[0] - 1] = cmd->freq[0];
+                current.channel_deg[cmd->arg[0] - 1] =
+                        (uint16_t)(cmd->arg[2] % 360);
+                apply_channels(1);
+#else
+                ok = 0;
+#endif
+                break;
+        case REMOTE_PROFILE:
+#if PROF_ENABLE
+                prof_line = 0;      // input_task sends it, then OK
+                return;
+#else
+                ok = 0;
+                break;
+#endif
+        case REMOTE_KEY:
+                if (cmd->arg[0] > KEYER_PSK_FRAMED || cmd->arg[1] == 0
+                    || cmd->arg[1] > KEYER_MAX_BAUD
+                    || cmd->arg[2] >= MAX_OUTPUT_FREQ
+                    || cmd->arg[3] >= MAX_OUTPUT_FREQ)
+                {
+                        ok = 0;
+                        break;
+                }
+                outputs_stop(OUT_KEYER);
+                KEYER_start(lead_chips, (uint8_t)cmd->arg[0],
+                            (uint16_t)cmd->arg[1],
+                            TUNING_hz_to_word(cmd->arg[2]),
+                            TUNING_hz_to_word(cmd->arg[3]));
+                key_mode = (uint8_t)cmd->arg[0];
+                key_hz = cmd->arg[2];
+                current.state = INPUT_STATE_KEYING;
+                break;
+        case REMOTE_DATA:
+                ok = KEYER_send(cmd->text, (uint8_t)cmd->arg[0]);
+                break;
+        case REMOTE_MODULATE:
+                if (cmd->arg[0] > MOD_PULSE || cmd->arg[1] < MOD_MIN_RATE
+                    || cmd->arg[1] > MOD_MAX_RATE
+                    || cmd->arg[2] >= MAX_OUTPUT_FREQ || cmd->arg[3] == 0
+                    || cmd->arg[3] > cmd->arg[1] / 2
+                    || cmd->arg[4] >= (cmd->arg[0] == MOD_FM
+                                       ? MAX_OUTPUT_FREQ : 101))
+                {
+                        ok = 0;
+                        break;
+                }
+                mod_mode = (uint8_t)cmd->arg[0];
+                mod_rate = (uint16_t)cmd->arg[1];
+                mod_tone = (uint16_t)cmd->arg[3];
+                mod_amount = cmd->arg[4];
+                ok = modulate(FREQ_HZ(cmd->arg[2]));
+                break;
+        case REMOTE_BURST:
+                if (cmd->arg[0] > (REMOTE_BURST_MS | REMOTE_BURST_SLEEP)
+                    || cmd->arg[1] == 0 || cmd->arg[1] >= MAX_OUTPUT_FREQ
+                    || cmd->arg[2] > 0xffff || cmd->arg[3] > 0xffff
+                    || cmd->arg[4] > 0xffff)
+                {
+                        ok = 0;
+                        break;
+                }
+                on = cmd->arg[0] & REMOTE_BURST_MS
+                        ? cmd->arg[2] * TIMER1_CYCLES_PER_MS
+                        : BURST_cycles((uint16_t)cmd->arg[2], cmd->arg[1]);
+                if (!BURST_set(lead_chips,
+                               cmd->arg[0] & REMOTE_BURST_SLEEP
+                               ? BURST_SLEEP : BURST_RESET, on,
+                               cmd->arg[3] * TIMER1_CYCLES_PER_MS,
+                               (uint16_t)cmd->arg[4]))
+                {
+                        ok = 0;
+                        break;
+                }
+                burst_hz = cmd->arg[1];
+                current.state = INPUT_STATE_BURST;
+                burst_begin();
+                break;
+        case REMOTE_STANDBY:
+                if (cmd->arg[0] > 2)
+                {
+                        ok = 0;
+                }
+                else if (cmd->arg[0] == 0)
+                {
+                        if (current.state == INPUT_STATE_STANDBY)
+                        {
+                                standby_leave();
+                        }
+                }
+                else
+                {
+                        standby_enter(cmd->arg[0] == 1
+                                      ? AD9833_SLEEP_DAC_OFF
+                                      : AD9833_SLEEP_STOP_DAC_OFF);
+                }
+                break;
+        case REMOTE_HOP_GO:
+                ok = hops_begin() != 0;
+                if (ok)
+                {
+                        current.state = INPUT_STATE_HOP;
+                }
+                break;
+        case REMOTE_TRIGGER:
+                if (cmd->arg[0] > TRIG_FALLING || cmd->arg[1] > TRIG_MARKER_MAX)
+                {
+                        ok = 0;
+                        break;
+                }
+                current.sweep_trigger = (uint8_t)(cmd->arg[0]
+                        | cmd->arg[1] << TRIG_MARKER_SHIFT);
+                // Takes effect now on a sweep, hop list or bursts
+                if (current.state == INPUT_STATE_SWEEP)
+                {
+                        sweep_begin();
+                }
+                else if (current.state == INPUT_STATE_HOP)
+                {
+                        hops_begin();
+                }
+                else if (current.state == INPUT_STATE_BURST)
+                {
+                        burst_begin();
+                }
+                break;
+        case REMOTE_WORD:
+                outputs_stop(0);
+                current.state = INPUT_STATE_REMOTE;
+                remote_word = cmd->arg[0] & 0x0fffffffUL;
+                DDS_write_tuning_word(remote_word);
+                return;          // binary words are not answered
+        default:
+                ok = 0;
+                break;
+        }
+        REMOTE_reply(ok);
+}
+
+// input state:
+//     tracking
+//     tracking pause
+//     sweep f1
+//     sweep f2
+//     sweep time
+//     sweeping
+//     storing    [st][digit]
+//     recalling  [rcl][digit]
+
+#if PROF_ENABLE
+//////////////////////////////////////////////////////////////////////////////
+/// @fn show_profile_page
+/// @brief Draws probe prof_page, or the overrun page after the last one.
+//////////////////////////////////////////////////////////////////////////////
+static void show_profile_page(void)
+{
+        prof_stat_t st;
+        DISPLAY_goto(0,0);
+        if (prof_page == PROF_COUNT)
+        {
+                DISPLAY_write_string_P(PSTR("Overrun "));
+                show_int_at(8,0,SCHED_tick_overruns());
+                show_int_at(0,1,SCHED_overruns(0));
+                show_int_at(8,1,UART_overruns());
+                return;
+        }
+        PROF_get((ProfId_t)prof_page, &st);
+        DISPLAY_write_string_P(PROF_name((ProfId_t)prof_page));
+        DISPLAY_write_char(' ');
+        show_int_at(8,0,st.max);
+        show_int_at(0,1,st.min);
+        show_int_at(8,1,st.avg);
+}
+
+// Line n of a 'T' report; the one after the last probe ends it
+static void send_profile_line(uint8_t n)
+{
+        prof_stat_t st;
+        uint32_t v[4];
+        if (n == PROF_COUNT)
+        {
+                v[0] = SCHED_tick_overruns();
+                REMOTE_reply_values(PSTR("Overrun"), v, 1);
+                REMOTE_reply(1);
+                return;
+        }
+        PROF_get((ProfId_t)n, &st);
+        v[0] = st.count;
+        v[1] = st.min;
+        v[2] = st.avg;
+        v[3] = st.max;
+        REMOTE_reply_values(PROF_name((ProfId_t)n), v, 4);
+}
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn dds_task
+/// @brief Highest priority, every tick: knob, sweep and hops to the DDS,
+///        and the keypad and button FIFOs into the input queue.
+//////////////////////////////////////////////////////////////////////////////
+static void dds_task(uint32_t new_ms)
+{
+    INPUT_collect(new_ms);
+    int32_t turn = KNOB_get_delta(new_ms, tune_digit == TUNE_DIGIT_AUTO);
+    if (current.state == INPUT_STATE_STANDBY)
+    {
+            // Nothing runs; a turn only wakes it, it does not tune
+            if (turn)
+            {
+                    standby_leave();
+            }
+            out_freq = tune_freq;
+            return;
+    }
+    if (turn)
+    {
+      int64_t f = (int64_t)tune_freq + (int64_t)turn
+              * (int64_t)pgm_read_dword(&tune_step[tune_digit]);
+      while (f < 0)
+      {
+        f += MAX_OUTPUT_MHZ;
+      }
+      while (f >= (int64_t)MAX_OUTPUT_MHZ)
+      {
+        f -= MAX_OUTPUT_MHZ;
+      }
+      tune_freq = (freq_t)f;
+    }
+    if ( /*!is_sweeping && */ current.state == INPUT_STATE_TRACK)
+    {
+      // The conversion is only worked out when the frequency changes
+      current.frequency = tune_freq;
+      DDS_write_frequency(tune_freq);
+      // update display
+    }
+    else if (turn && current.state == INPUT_STATE_MODULATE)
+    {
+            // The knob moves the carrier
+            modulate(tune_freq);
+    }
+
+    // The capture interrupt has already switched the output to the start
+    TRIG_service();
+    uint32_t edge_at;
+    if (TRIG_fired(&edge_at))
+    {
+            if (trig_run == INPUT_STATE_SWEEP)
+            {
+                    sweep_word = TUNING_freq_to_word(current.sweep_F1);
+                    SWEEP_start(sweep_word,
+                                TUNING_freq_to_word(current.sweep_F2),
+                                current.sweep_ms, current.sweep_mode,
+                                new_ms);
+                    SWEEP_once();
+                    TRIG_markers(TRIG_MARKER(current.sweep_trigger),
+                                 FMT_split_freq(current.sweep_F1, NULL));
+            }
+            else if (trig_run == INPUT_STATE_BURST)
+            {
+                    // The first bursts went from the interrupt; the
+                    // rest keep time with them, not with the edge
+                    BURST_trigger(TRIG_sent());
+            }
+            else
+            {
+                    HOP_trigger(edge_at);
+            }
+    }
+
+    uint8_t swept = SWEEP_update(new_ms, &sweep_word);
+    if (swept)
+    {
+            DDS_write_tuning_word(sweep_word);
+    }
+    // Keep the DDS queue topped up with hops or bursts
+    HOP_service();
+    BURST_service();
+
+    out_freq = tune_freq;
+    if (SWEEP_active() || swept)
+    {
+            // Markers fall on whole Hz
+            uint32_t hz = TUNING_word_to_hz(sweep_word);
+            out_freq = TUNING_word_to_freq(sweep_word);
+            if (swept == SWEEP_RESTART)
+            {
+                    TRIG_pulse();
+                    TRIG_markers(TRIG_MARKER(current.sweep_trigger), hz);
+            }
+            else
+            {
+                    TRIG_marker(hz);
+            }
+    }
+    else if (TRIG_armed())
+    {
+            out_freq = park_freq;
+    }
+    else if (current.state == INPUT_STATE_REMOTE)
+    {
+            out_freq = TUNING_word_to_freq(remote_word);
+    }
+    else if (current.state == INPUT_STATE_HOP)
+    {
+            out_freq = FREQ_HZ(HOP_current_hz());
+    }
+    else if (current.state == INPUT_STATE_KEYING)
+    {
+            out_freq = FREQ_HZ(key_hz);
+    }
+    else if (current.state == INPUT_STATE_MODULATE)
+    {
+            out_freq = mod_freq;
+    }
+    else if (current.state == INPUT_STATE_BURST)
+    {
+            out_freq = FREQ_HZ(burst_hz);
+    }
+
+    // A triggered sweep, hop pass or set of bursts has ended, wait for
+    // the next edge
+    if (TRIG_EDGE(current.sweep_trigger) != TRIG_FREE
+        && (current.state == INPUT_STATE_SWEEP
+            || current.state == INPUT_STATE_HOP
+            || current.state == INPUT_STATE_BURST)
+        && current.state == trig_run && !TRIG_armed() && !SWEEP_active()
+        && !HOP_playing() && !BURST_playing())
+    {
+            trigger_rearm();
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn input_task
+/// @brief Every tick: serial commands, then queued button and keypad
+///        events through the state machine.
+//////////////////////////////////////////////////////////////////////////////
+static void input_task(uint32_t new_ms)
+{
+#if PROF_ENABLE
+    // One line of a 'T' report per pass, when it fits
+    if (prof_line <= PROF_COUNT && UART_tx_room() >= PROF_LINE_BYTES)
+    {
+            send_profile_line(prof_line++);
+    }
+#endif
+    remote_cmd_t cmd;
+    for (uint8_t i = 0; i < REMOTE_PER_PASS && REMOTE_poll(&cmd); i++)
+    {
+            remote_command(&cmd, out_freq);
+    }
+
+    input_event_t ev;
+    for (uint8_t i = 0; i < INPUT_PER_PASS && INPUT_get(&ev); i++)
+    {
+            input_event(&ev);
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn input_event
+/// @brief The state machine, run once per button press or key.
+//////////////////////////////////////////////////////////////////////////////
+static void input_event(const input_event_t* ev)
+{
+    int b = ev->type == INPUT_BUTTON ? ev->code : -1;
+    int ky = ev->type == INPUT_KEY ? ev->code : -1;
+
+    PROF_BEGIN(PROF_KEY);
+    KeyResult_t key_result = process_key(ky);
+    PROF_END(PROF_KEY);
+
+    // TODO:  For now, we separate keypad and encoder
+    // inputs.  Keypad entry must use ENTER key and
+    // encoder entry must use button.  If keypad entry
+    // is used, set freq to it and also set encoder count
+    // to keypad number.  Later, we will integrate the two.
+    // maybe ...
+    switch(current.state)
+    {
+    case INPUT_STATE_TRACK:
+    {
+      if (b == 0)
+      {
+        current.state = INPUT_STATE_TRACK_PAUSE;
+      }
+      else if (key_result == KEY_RESULT_ENTER)
+      {
+        freq_t f = string_to_freq(keypad_string);
+        if (f < MAX_OUTPUT_MHZ)
+        {
+                current.frequency = f;
+          DDS_write_frequency(f);
+          tune_freq = f;
+          keypad_clear();
+          //show_message(PSTR("valid"));
+        }
+        else
         {
           // TODO warn!
-          show_message("high");
+          show_message(PSTR("high"));
           keypad_clear();
                 
         }
@@ -487,26 +1636,108 @@ static void run(void)
       {
               current.state = INPUT_STATE_RECALL;
       }
+      else if (key_result == KEY_RESULT_OPTION)
+      {
+              // Next knob step: Acc, 1, 10, ... 1M, Acc
+              tune_digit = (tune_digit + 1) % TUNE_DIGITS;
+      }
       break;
     } 
     case INPUT_STATE_TRACK_PAUSE:
       if (b == 0 || key_result == KEY_RESULT_ENTER)
       {
         // set freq
-        int32_t f = ENCODER_get_count(0);
-        DDS_write_frequency(f);
+        DDS_write_frequency(tune_freq);
         current.state = INPUT_STATE_TRACK;
       }
+#if PROF_ENABLE
+      else if (key_result == KEY_RESULT_OPTION)
+      {
+              prof_page = 0;
+              current.state = INPUT_STATE_PROFILE;
+      }
+#endif
+#if AD9833_CHANNELS > 1
+      else if (key_result == KEY_RESULT_MODE)
+      {
+              // Set up channels 1 up: Hz then degrees for each
+              edit_channel = 1;
+              keypad_clear();
+              current.state = INPUT_STATE_CH_HZ;
+      }
+#endif
+      else if (key_result == KEY_RESULT_RECALL)
+      {
+              // Modulate the paused frequency with the last settings
+              keypad_clear();
+              modulate(tune_freq);
+      }
+      else if (key_result == KEY_RESULT_DELETE)
+      {
+              standby_enter(AD9833_SLEEP_STOP_DAC_OFF);
+      }
       // check mode button
       // sto and rcl?
       break;
       
+#if AD9833_CHANNELS > 1
+    case INPUT_STATE_CH_HZ:
+            if (key_result == KEY_RESULT_ENTER)
+            {
+                    // Nothing keyed, 0, follows channel 0
+                    freq_t f = string_to_freq(keypad_string);
+                    keypad_clear();
+                    if (f >= MAX_OUTPUT_MHZ)
+                    {
+                            show_message(PSTR("high"));
+                            break;
+                    }
+                    current.channel_hz[edit_channel - 1] = f;
+                    current.state = INPUT_STATE_CH_DEG;
+            }
+            else if (key_result == KEY_RESULT_MODE)
+            {
+                    keypad_clear();
+                    DDS_write_frequency(tune_freq);
+                    current.state = INPUT_STATE_TRACK;
+            }
+            break;
+    case INPUT_STATE_CH_DEG:
+            if (key_result == KEY_RESULT_ENTER)
+            {
+                    current.channel_deg[edit_channel - 1] =
+                            (uint16_t)(string_to_int(keypad_string) % 360);
+                    keypad_clear();
+                    apply_channels(1);
+                    if (++edit_channel < AD9833_CHANNELS)
+                    {
+                            current.state = INPUT_STATE_CH_HZ;
+                            break;
+                    }
+                    DDS_write_frequency(tune_freq);
+                    current.state = INPUT_STATE_TRACK;
+            }
+            else if (key_result == KEY_RESULT_MODE)
+            {
+                    keypad_clear();
+                    DDS_write_frequency(tune_freq);
+                    current.state = INPUT_STATE_TRACK;
+            }
+            break;
+#endif
+
     case INPUT_STATE_F1:
       if (b == 0 || key_result == KEY_RESULT_ENTER)
       {
         // set f1
-              current.sweep_F1 = string_to_int(keypad_string);
+              freq_t f = string_to_freq(keypad_string);
               keypad_clear();
+              if (f >= MAX_OUTPUT_MHZ)
+              {
+                      show_message(PSTR("high"));
+                      break;
+              }
+              current.sweep_F1 = f;
         current.state = INPUT_STATE_F2;
       }
       break;
@@ -515,8 +1746,14 @@ static void run(void)
       if (b == 0 || key_result == KEY_RESULT_ENTER)
       {
         // set f2
-              current.sweep_F2 = string_to_int(keypad_string);
+              freq_t f = string_to_freq(keypad_string);
               keypad_clear();
+              if (f >= MAX_OUTPUT_MHZ)
+              {
+                      show_message(PSTR("high"));
+                      break;
+              }
+              current.sweep_F2 = f;
         current.state = INPUT_STATE_TIME;
       }
       break;
@@ -530,19 +1767,31 @@ static void run(void)
               current.sweep_ms = string_to_int(keypad_string) * 1000;
               keypad_clear();
         current.state = INPUT_STATE_SWEEP;
+        sweep_begin();
       }
       break;
     case INPUT_STATE_SWEEP:
             if (b == 0 || key_result == KEY_RESULT_ENTER)
             {
+                    SWEEP_stop();
+                    TRIG_disarm();
                     current.state = INPUT_STATE_F1;
                     keypad_clear();
             }
+            else if (key_result == KEY_RESULT_OPTION)
+            {
+                    // Toggle linear / log and restart
+                    current.sweep_mode = (current.sweep_mode == SWEEP_LOG)
+                            ? SWEEP_LINEAR : SWEEP_LOG;
+                    sweep_begin();
+            }
             else if (key_result == KEY_RESULT_MODE)
             {
+                    SWEEP_stop();
+                    TRIG_disarm();
                     current.state = INPUT_STATE_TRACK;
                     // set freq, display, whatever
-                    ENCODER_set_count(0, current.frequency);
+                    tune_freq = current.frequency;
                     DDS_write_frequency(current.frequency);
             }
             else if (key_result == KEY_RESULT_STORE)
@@ -566,8 +1815,7 @@ static void run(void)
                     keypad_clear();
                     // save it
                     current.state = saved_state;
-                    eeprom_write_block(&current, &saved_settings[entry],
-                                       sizeof(settings_t));
+                    store_slot(entry);
                     //current.state = saved_state;
             }
             break;
@@ -576,55 +1824,202 @@ static void run(void)
             {
                     uint32_t entry = string_to_int(keypad_string);
                     keypad_clear();
-                    eeprom_read_block(&current, &saved_settings[entry],
-                                      sizeof(settings_t));
-                                      //current.state = saved_state;
-                    DDS_write_frequency(current.frequency);  // TODO mode
-                    ENCODER_set_count(0, current.frequency); // TODO mode
+                    if (!recall_slot(entry))
+                    {
+                            current.state = INPUT_STATE_TRACK;
+                    }
             }
             break;
-            
-    default:
-      break;
-    }
-    cli();
-    LCD_44780_goto(9,1);
-    switch(current.state)
-    {
-    case INPUT_STATE_TRACK:
-            LCD_44780_write_string("Track  ");
-            break;
-    case INPUT_STATE_TRACK_PAUSE:
-            LCD_44780_write_string("Pause  ");
+    case INPUT_STATE_REMOTE:
+            if (key_result == KEY_RESULT_MODE)
+            {
+                    // Hand the output back to the knob
+                    current.state = INPUT_STATE_TRACK;
+                    DDS_write_frequency(tune_freq);
+            }
             break;
-    case INPUT_STATE_F1:
-            LCD_44780_write_string("F1     ");
+    case INPUT_STATE_HOP:
+            if (key_result == KEY_RESULT_MODE)
+            {
+                    // Drop the hops still queued, back to the knob
+                    HOP_stop();
+                    TRIG_disarm();
+                    current.state = INPUT_STATE_TRACK;
+                    DDS_write_frequency(tune_freq);
+            }
             break;
-    case INPUT_STATE_F2:
-            LCD_44780_write_string("F2     ");
+    case INPUT_STATE_KEYING:
+            if (key_result == KEY_RESULT_MODE)
+            {
+                    KEYER_stop();
+                    current.state = INPUT_STATE_TRACK;
+                    DDS_write_frequency(tune_freq);
+            }
             break;
-    case INPUT_STATE_TIME:
-            LCD_44780_write_string("TIME   ");
+    case INPUT_STATE_BURST:
+            if (key_result == KEY_RESULT_MODE)
+            {
+                    BURST_stop();
+                    current.state = INPUT_STATE_TRACK;
+                    DDS_write_frequency(tune_freq);
+            }
             break;
-    case INPUT_STATE_SWEEP:
-            LCD_44780_write_string("SWEEP  ");
+    case INPUT_STATE_STANDBY:
+            // Any key or the button wakes it and does nothing else
+            standby_leave();
             break;
-    case INPUT_STATE_STORE:
-            LCD_44780_write_string("STORE  ");
+    case INPUT_STATE_MODULATE:
+            if (key_result == KEY_RESULT_OPTION)
+            {
+                    // Next of FM, AM and pulse, from its default amount
+                    mod_mode = mod_mode == MOD_PULSE ? MOD_FM : mod_mode + 1;
+                    mod_amount = mod_mode == MOD_FM ? 3000 : 50;
+                    modulate(mod_freq);
+            }
+            else if (key_result == KEY_RESULT_ENTER)
+            {
+                    // FM deviation Hz, AM depth or pulse duty percent
+                    uint32_t n = string_to_int(keypad_string);
+                    keypad_clear();
+                    if (n >= (mod_mode == MOD_FM ? MAX_OUTPUT_FREQ : 101))
+                    {
+                            show_message(PSTR("high"));
+                            break;
+                    }
+                    mod_amount = n;
+                    modulate(mod_freq);
+            }
+            else if (key_result == KEY_RESULT_MODE)
+            {
+                    MOD_stop();
+                    keypad_clear();
+                    current.state = INPUT_STATE_TRACK;
+                    DDS_write_frequency(tune_freq);
+            }
             break;
-    case INPUT_STATE_RECALL:
-            LCD_44780_write_string("RECALL ");
+#if PROF_ENABLE
+    case INPUT_STATE_PROFILE:
+            if (key_result == KEY_RESULT_OPTION)
+            {
+                    prof_page = (prof_page + 1) % (PROF_COUNT + 1);
+            }
+            else if (b == 0 || key_result == KEY_RESULT_ENTER
+                     || key_result == KEY_RESULT_MODE)
+            {
+                    DISPLAY_clear();
+                    DDS_write_frequency(tune_freq);
+                    current.state = INPUT_STATE_TRACK;
+            }
             break;
+#endif
+            
     default:
-            LCD_44780_write_string("ERROR ");
-            break;
+      break;
     }
+}
 
-    // Show keypad string lower left
-    LCD_44780_goto(0,1);
-    LCD_44780_write_string(keypad_string);
-    sei();
-  }
+//////////////////////////////////////////////////////////////////////////////
+/// @fn display_task
+/// @brief Draws the frame and sends a few changed cells.
+//////////////////////////////////////////////////////////////////////////////
+static void display_task(uint32_t new_ms)
+{
+    if (current.state == INPUT_STATE_STANDBY)
+    {
+            // The LCD is off and keeps what it showed
+            return;
+    }
+    if (new_ms < SPLASH_MS)
+    {
+            DISPLAY_flush(DISPLAY_FLUSH_CELLS);
+            return;
+    }
+#if PROF_ENABLE
+    if (current.state == INPUT_STATE_PROFILE)
+    {
+            show_profile_page();
+            DISPLAY_flush(DISPLAY_FLUSH_CELLS);
+            return;
+    }
+#endif
+    show_freq_at(0,0,out_freq);
+
+    uint8_t label[STATE_LABEL_SIZE];
+    state_label(label);
+    DISPLAY_goto(9,1);
+    DISPLAY_write_string(label);
+
+    // Show keypad string lower left, or the step rate while sweeping
+    if (SWEEP_active() && current.state == INPUT_STATE_SWEEP)
+    {
+            show_int_at(0,1,SWEEP_rate());
+    }
+    else
+    {
+            DISPLAY_goto(0,1);
+            // The end of a long entry, as it is keyed
+            DISPLAY_write_string(keypad_string + KP_STRING_LENGTH - 1
+                                 - KP_SHOWN);
+    }
+
+    // Send only what changed, a few cells per pass
+    PROF_BEGIN(PROF_LCD);
+    DISPLAY_flush(DISPLAY_FLUSH_CELLS);
+    PROF_END(PROF_LCD);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn eeprom_task
+/// @brief Carries out a recall once the EEPROM writer is idle, and
+///        journals the last state once it has settled.  Posted by
+///        recall_slot(), and polled in case writes were still queued.
+//////////////////////////////////////////////////////////////////////////////
+static void eeprom_task(uint32_t new_ms)
+{
+        if (recall_entry != NO_RECALL)
+        {
+                if (!EEWRITE_busy())
+                {
+                        uint8_t entry = recall_entry;
+                        recall_entry = NO_RECALL;
+                        apply_recall(entry);
+                }
+                return;
+        }
+
+        // Power-up brings back the output, not a half-entered sweep
+        settings_t last = current;
+        if (last.state != INPUT_STATE_SWEEP && last.state != INPUT_STATE_HOP)
+        {
+                last.state = INPUT_STATE_TRACK;
+        }
+        if (memcmp(&last, &settling, sizeof(settings_t)))
+        {
+                settling = last;
+                settling_ms = new_ms;
+        }
+        else if (new_ms - settling_ms >= AUTOSAVE_MS
+                 && memcmp(&last, &autosaved, sizeof(settings_t))
+                 && settings_write(JOURNAL_CURRENT, &last))
+        {
+                autosaved = last;
+        }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn run
+/// @brief Main loop: hands the tasks to the scheduler, DDS work first.
+//////////////////////////////////////////////////////////////////////////////
+static void run(void)
+{
+        DISPLAY_init();
+        DISPLAY_goto(0,0);
+        DISPLAY_write_string_P(PSTR("SoftRock 33"));
+        SCHED_add(dds_task, DDS_PERIOD_MS);
+        SCHED_add(input_task, INPUT_PERIOD_MS);
+        SCHED_add(display_task, DISPLAY_PERIOD_MS);
+        eeprom_task_id = SCHED_add(eeprom_task, EEPROM_PERIOD_MS);
+        SCHED_run();
 }
 
                 
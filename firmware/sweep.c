@@ -0,0 +1,375 @@
+//////////////////////////////////////////////////////////////////////////////
+///
+///  \file sweep.c
+///
+///  \copy copyright (c) 2023 William R Cooke
+///
+///  @brief Linear and logarithmic frequency sweeps in tuning-word units.
+///
+//////////////////////////////////////////////////////////////////////////////
+
+#include <stdint.h>
+#include <avr/pgmspace.h>
+#include "sweep.h"
+
+// Logarithmic steps may at most double the word, so a sweep over the full
+// 28-bit range needs at least this many milliseconds.
+#define SWEEP_LOG_MIN_MS     32
+
+// Below 2^-6 per ms the log gain comes from a series, which keeps its
+// relative precision however small it gets
+#define SWEEP_SERIES_MAX     ((uint64_t)1 << 58)
+
+#define LOG2_STEPS           31
+#define LN2_Q32              2977044472UL       // ln 2, 0.32 fixed point
+
+// log2(1 + 2^-k) for k = 1 to LOG2_STEPS, 0.32 fixed point
+static const uint32_t log2_step[LOG2_STEPS] PROGMEM =
+{
+        0x95c01a3a, 0x5269e12f, 0x2b803474, 0x1663f6fb,
+        0x0b5d69bb, 0x05b9e5a1, 0x02dfca17, 0x01709c47,
+        0x00b87c20, 0x005c4995, 0x002e27ac, 0x0017148f,
+        0x000b8a76, 0x0005c546, 0x0002e2a6, 0x00017154,
+        0x0000b8aa, 0x00005c55, 0x00002e2b, 0x00001715,
+        0x00000b8b, 0x000005c5, 0x000002e3, 0x00000171,
+        0x000000b9, 0x0000005c, 0x0000002e, 0x00000017,
+        0x0000000c, 0x00000006, 0x00000003
+};
+
+static uint8_t     active;
+static uint8_t     once;          // end at end_word, don't start over
+static uint8_t     down;          // sweeping toward lower frequencies
+static SweepMode_t sweep_mode;
+static uint32_t    start_word;
+static uint32_t    end_word;
+static uint64_t    acc;           // current word, 28.32 fixed point
+static uint64_t    step;          // linear: increment per ms, 28.32
+static uint32_t    gain;          // log: growth per ms, gain * 2^-gain_shift
+static uint8_t     gain_shift;
+static uint32_t    length_ms;
+static uint32_t    elapsed_ms;
+static uint32_t    last_ms;
+static uint32_t    second_ms;
+static uint32_t    last_word;     // last *word returned, ~0 for none
+static uint16_t    steps;
+static uint16_t    rate;
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn frac_div
+/// @brief (num << 32) / den by shift and subtract, so the 64-bit library
+///        divide is never pulled in.
+/// @param[in] num  Numerator, less than den * 2^32.
+/// @param[in] den  Divisor, non zero.
+/// @return Quotient, num / den as 32.32 fixed point.
+//////////////////////////////////////////////////////////////////////////////
+static uint64_t frac_div(uint64_t num, uint32_t den)
+{
+        uint64_t rem = 0;
+        uint64_t q = 0;
+        for (int8_t bit = 95; bit >= 0; bit--)
+        {
+                rem <<= 1;
+                if (bit >= 32)
+                {
+                        rem |= (num >> (bit - 32)) & 1;
+                }
+                q <<= 1;
+                if (rem >= den)
+                {
+                        rem -= den;
+                        q |= 1;
+                }
+        }
+        return q;
+}
+
+// x * (1 + 2^-k), less x, rounded
+static uint32_t step_of(uint32_t x, uint8_t k)
+{
+        return (x >> k) + ((x >> (k - 1)) & 1);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn log2_fix
+/// @brief log2(w) by shift and add: factors 1 + 2^-k go into a product
+///        while it stays at or below w's mantissa, and their logs from
+///        log2_step are summed.  Good to about 2^-29.
+/// @param[in] w  Non zero.
+/// @return log2(w) as 32.32 fixed point.
+//////////////////////////////////////////////////////////////////////////////
+static uint64_t log2_fix(uint32_t w)
+{
+        uint8_t msb = 31;
+        while (!(w & 0x80000000UL))
+        {
+                w <<= 1;
+                msb--;
+        }
+        // w is the mantissa, 1.31, and x the product so far
+        uint32_t x = 0x80000000UL;
+        uint64_t l = (uint64_t)msb << 32;
+        for (uint8_t k = 1; k <= LOG2_STEPS; k++)
+        {
+                uint32_t d = step_of(x, k);
+                if (d <= w - x)
+                {
+                        x += d;
+                        l += pgm_read_dword(&log2_step[k - 1]);
+                }
+        }
+        return l;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn exp2m1_fix
+/// @brief 2^z - 1 by the same factors, taken while their logs fit in
+///        what is left of z.  Only the product less 1 is kept, so it keeps
+///        all 32 bits.
+/// @param[in] z  0 to 0.996, 0.32 fixed point.
+/// @return 2^z - 1, 0.32 fixed point.
+//////////////////////////////////////////////////////////////////////////////
+static uint32_t exp2m1_fix(uint32_t z)
+{
+        uint32_t e = 0;
+        for (uint8_t k = 1; k <= LOG2_STEPS; k++)
+        {
+                uint32_t t = pgm_read_dword(&log2_step[k - 1]);
+                if (z >= t)
+                {
+                        z -= t;
+                        // (1 + e) * (1 + 2^-k) - 1
+                        e += (1UL << (32 - k)) + step_of(e, k);
+                }
+        }
+        return e;
+}
+
+// Sets gain and gain_shift to v * 2^-exp, v non zero
+static void set_gain(uint64_t v, uint8_t exp)
+{
+        while (!(v >> 63))
+        {
+                v <<= 1;
+                exp++;
+        }
+        gain = (uint32_t)(v >> 32);
+        gain_shift = exp - 32;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn log_gain
+/// @brief Sets the per-ms growth for a log sweep from start_word to
+///        end_word in length_ms.
+///
+///  With y = |log2(end_word / start_word)| / length_ms, each ms does
+///  acc += acc * (2^y - 1) going up and acc -= acc * (1 - 2^-y) going
+///  down.  Fast sweeps take 2^y from exp2m1_fix(); going down,
+///  1 - 2^-y = (1 - (2^(1-y) - 1)) / 2 keeps z below 1.  Slow ones use
+///  z = y ln 2 and z (1 +- z/2 + z^2/6), which keeps the gain's relative
+///  precision.  Against the exact curve a fast sweep strays up to about
+///  2 ppm before its last step lands on end_word, a slow one 0.04 ppm.
+//////////////////////////////////////////////////////////////////////////////
+static void log_gain(void)
+{
+        uint64_t l1 = log2_fix(start_word);
+        uint64_t l2 = log2_fix(end_word);
+        // y, 0.64 fixed point
+        uint64_t y = frac_div(down ? l1 - l2 : l2 - l1, length_ms);
+        if (y == 0)
+        {
+                gain = 0;
+                gain_shift = 32;
+                return;
+        }
+        if (y < SWEEP_SERIES_MAX)
+        {
+                // y is m * 2^-(32 + s), z is y ln 2
+                uint8_t s = 0;
+                uint64_t v = y;
+                while (!(v >> 63))
+                {
+                        v <<= 1;
+                        s++;
+                }
+                uint32_t z = (uint32_t)(((v >> 32) * LN2_Q32) >> 32);
+                // z / 2 and z^2 / 6 are only needed to 2^-31
+                uint32_t zq = (uint32_t)(((y >> 32) * LN2_Q32) >> 32);
+                uint32_t sq6 = (uint32_t)(((((uint64_t)zq * zq) >> 32)
+                                           * 0x2aaaaaabUL) >> 33);
+                uint32_t f = down ? 0x80000000UL - (zq >> 2) + sq6
+                        : 0x80000000UL + (zq >> 2) + sq6;
+                set_gain((uint64_t)z * f, 63 + s);
+        }
+        else
+        {
+                uint32_t yq = (uint32_t)(y >> 32);
+                uint32_t e = exp2m1_fix(down ? (uint32_t)0 - yq : yq);
+                if (down)
+                {
+                        e = ((uint32_t)0 - e) >> 1;
+                }
+                set_gain(e, 32);
+        }
+        if (gain_shift > 95)
+        {
+                gain = 0;
+                gain_shift = 32;
+        }
+}
+
+// acc * gain * 2^-gain_shift, gain_shift >= 32
+static uint64_t log_increment(void)
+{
+        uint64_t hi = (acc >> 32) * gain;
+        uint64_t lo = (acc & 0xffffffffUL) * gain;
+        return (hi + (lo >> 32)) >> (gain_shift - 32);
+}
+
+void SWEEP_start(uint32_t word1, uint32_t word2, uint32_t ms,
+                 SweepMode_t mode, uint32_t now_ms)
+{
+        if (ms == 0)
+        {
+                ms = 1;
+        }
+        sweep_mode = mode;
+        down = word2 < word1;
+        start_word = word1;
+        end_word = word2;
+        length_ms = ms;
+        acc = (uint64_t)word1 << 32;
+
+        if (mode == SWEEP_LOG)
+        {
+                if (start_word == 0)
+                {
+                        start_word = 1;
+                }
+                if (end_word == 0)
+                {
+                        end_word = 1;
+                }
+                if (length_ms < SWEEP_LOG_MIN_MS)
+                {
+                        length_ms = SWEEP_LOG_MIN_MS;
+                }
+                acc = (uint64_t)start_word << 32;
+                log_gain();
+        }
+        else
+        {
+                step = frac_div(down ? word1 - word2 : word2 - word1,
+                                length_ms);
+        }
+
+        elapsed_ms = 0;
+        last_ms = now_ms;
+        second_ms = now_ms;
+        last_word = ~(uint32_t)0;
+        steps = 0;
+        rate = 0;
+        once = 0;
+        active = 1;
+}
+
+void SWEEP_stop(void)
+{
+        active = 0;
+        rate = 0;
+}
+
+void SWEEP_once(void)
+{
+        once = 1;
+}
+
+uint8_t SWEEP_active(void)
+{
+        return active;
+}
+
+uint8_t SWEEP_update(uint32_t now_ms, uint32_t* word)
+{
+        if (!active)
+        {
+                return 0;
+        }
+        uint32_t dt = now_ms - last_ms;
+        if (dt == 0)
+        {
+                return 0;
+        }
+        last_ms = now_ms;
+
+        if (now_ms - second_ms >= 1000)
+        {
+                rate = steps;
+                steps = 0;
+                second_ms = now_ms;
+        }
+
+        elapsed_ms += dt;
+        if (once && elapsed_ms >= length_ms)
+        {
+                // Land on end_word even if the last ms was skipped
+                active = 0;
+                acc = (uint64_t)end_word << 32;
+        }
+        else if (elapsed_ms > length_ms)
+        {
+                // Start the next sweep
+                elapsed_ms = 0;
+                acc = (uint64_t)start_word << 32;
+                *word = start_word;
+                if (start_word != last_word)
+                {
+                        last_word = start_word;
+                        steps++;
+                }
+                return SWEEP_RESTART;
+        }
+        else if (elapsed_ms == length_ms)
+        {
+                acc = (uint64_t)end_word << 32;
+        }
+        else if (sweep_mode == SWEEP_LOG)
+        {
+                while (dt--)
+                {
+                        if (down)
+                        {
+                                acc -= log_increment();
+                        }
+                        else
+                        {
+                                acc += log_increment();
+                        }
+                }
+        }
+        else
+        {
+                if (down)
+                {
+                        acc -= step * dt;
+                }
+                else
+                {
+                        acc += step * dt;
+                }
+        }
+
+        uint32_t w = (uint32_t)(acc >> 32);
+        if (w == last_word)
+        {
+                return 0;
+        }
+        last_word = w;
+        *word = w;
+        steps++;
+        return SWEEP_STEP;
+}
+
+uint16_t SWEEP_rate(void)
+{
+        return rate;
+}
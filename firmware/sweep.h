@@ -0,0 +1,84 @@
+//////////////////////////////////////////////////////////////////////////////
+///
+///  \file sweep.h
+///
+///  \copy copyright (c) 2023 William R Cooke
+///
+///  @brief Linear and logarithmic frequency sweeps in tuning-word units.
+///
+///  The current word is kept as a 28.32 fixed-point accumulator, so a
+///  sweep of a few Hz over minutes and a sweep of MHz over milliseconds
+///  both advance by exact sub-LSB amounts.  All setup math happens in
+///  SWEEP_start(); a step is one 64-bit add (linear) or one multiply
+///  and add (logarithmic), never a division.
+///
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef SWEEP_H
+#define SWEEP_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+
+        typedef enum SWEEP_MODE
+        {
+                SWEEP_LINEAR   = 0,
+                SWEEP_LOG      = 1
+        } SweepMode_t;
+
+// SWEEP_update() results
+#define SWEEP_STEP         1
+#define SWEEP_RESTART      2    // back at word1 for the next sweep
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn SWEEP_start
+/// @brief Starts a repeating sweep from word1 to word2.
+/// @param[in] word1   Start tuning word (28 bits).
+/// @param[in] word2   End tuning word (28 bits), may be below word1.
+/// @param[in] ms      Sweep length in milliseconds.
+/// @param[in] mode    SWEEP_LINEAR or SWEEP_LOG.
+/// @param[in] now_ms  Current SYSTICK time.
+//////////////////////////////////////////////////////////////////////////////
+        void SWEEP_start(uint32_t word1, uint32_t word2, uint32_t ms,
+                         SweepMode_t mode, uint32_t now_ms);
+
+        void SWEEP_stop(void);
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn SWEEP_once
+/// @brief Makes the running sweep end at word2 instead of starting over.
+///        SWEEP_active() is 0 from the update that writes word2.
+//////////////////////////////////////////////////////////////////////////////
+        void SWEEP_once(void);
+
+        uint8_t SWEEP_active(void);
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn SWEEP_update
+/// @brief Advances the sweep to now_ms.  Call once per SYSTICK tick;
+///        late calls catch up by the elapsed time instead of slowing down.
+/// @param[in]  now_ms  Current SYSTICK time.
+/// @param[out] word    Tuning word to write when non zero is returned.
+/// @return SWEEP_STEP if the output word changed, SWEEP_RESTART if it went
+///         back to word1, which it reports even if the word was already
+///         word1, else 0.
+//////////////////////////////////////////////////////////////////////////////
+        uint8_t SWEEP_update(uint32_t now_ms, uint32_t* word);
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn SWEEP_rate
+/// @brief Words SWEEP_update() returned during the last full second that
+///        differed from the word before, so a slow sweep shows fewer
+///        than one per tick.
+/// @return Achieved update rate in steps per second.
+//////////////////////////////////////////////////////////////////////////////
+        uint16_t SWEEP_rate(void);
+
+#ifdef __cplusplus
+}
+#endif  // __cplusplus
+#endif  // #ifndef SWEEP_H
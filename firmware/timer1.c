@@ -0,0 +1,47 @@
+//////////////////////////////////////////////////////////////////////////////
+///
+///  \file timer1.c
+///
+///  \copy copyright (c) 2023 William R Cooke
+///
+///  @brief Timer1 as a free-running CPU cycle timebase.
+///
+//////////////////////////////////////////////////////////////////////////////
+
+#include <stdint.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <util/atomic.h>
+#include "timer1.h"
+
+static volatile uint16_t high;     // overflows, the upper half of now
+
+void TIMER1_init(void)
+{
+        high = 0;
+        TCCR1A = 0;
+        TCCR1B = _BV(CS10);
+        TIMSK |= _BV(TOIE1);
+}
+
+uint32_t TIMER1_now(void)
+{
+        uint16_t lo;
+        uint16_t hi;
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+        {
+                lo = TCNT1;
+                hi = high;
+                // Wrapped, but the overflow interrupt has not run yet
+                if ((TIFR & _BV(TOV1)) && lo < 0x8000)
+                {
+                        hi++;
+                }
+        }
+        return ((uint32_t)hi << 16) | lo;
+}
+
+ISR(TIMER1_OVF_vect)
+{
+        high++;
+}
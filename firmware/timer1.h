@@ -0,0 +1,46 @@
+//////////////////////////////////////////////////////////////////////////////
+///
+///  \file timer1.h
+///
+///  \copy copyright (c) 2023 William R Cooke
+///
+///  @brief Timer1 as a free-running CPU cycle timebase.
+///
+///  Timer1 counts F_CPU directly and an overflow interrupt extends it to
+///  32 bits, so TIMER1_now() is a cycle count that wraps every 268 s.
+///  The counter is never written or reset; compare units A and B are free
+///  for modules that need an interrupt at an exact cycle.  Compare times
+///  against TIMER1_now() by signed difference so the wrap does not matter.
+///
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef TIMER1_H
+#define TIMER1_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+
+#define TIMER1_CYCLES_PER_US    16
+#define TIMER1_CYCLES_PER_MS    16000UL
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn TIMER1_init
+/// @brief Starts Timer1 in normal mode at clk/1 with the overflow interrupt.
+//////////////////////////////////////////////////////////////////////////////
+        void TIMER1_init(void);
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn TIMER1_now
+/// @brief Safe with interrupts on or off, including from an ISR.
+/// @return CPU cycles since TIMER1_init(), modulo 2^32.
+//////////////////////////////////////////////////////////////////////////////
+        uint32_t TIMER1_now(void);
+
+#ifdef __cplusplus
+}
+#endif  // __cplusplus
+#endif  // #ifndef TIMER1_H
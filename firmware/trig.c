@@ -0,0 +1,307 @@
+//////////////////////////////////////////////////////////////////////////////
+///
+///  \file trig.c
+///
+///  \copy copyright (c) 2023 William R Cooke
+///
+///  @brief Sweep sync output and external trigger input.
+///
+//////////////////////////////////////////////////////////////////////////////
+
+#include <stdint.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/pgmspace.h>
+#include <util/atomic.h>
+#include "AD9833.h"
+#include "ddsbus.h"
+#include "ddsq.h"
+#include "timer1.h"
+#include "trig.h"
+
+#define TRIG_IN         _BV(PB0)        // ICP1
+
+// With more chips PC4 is chip 1's FSYNC, and there is no sync output
+#if AD9833_CHANNELS == 1
+#define SYNC_OUT        _BV(PC4)
+#else
+#define SYNC_OUT        0
+#endif
+
+// Ticks TRIG_service() sees before ending a pulse
+#define PULSE_TICKS     2
+
+static const uint32_t decades[TRIG_MARKER_MAX + 1] PROGMEM =
+{
+        0, 10, 100, 1000, 10000, 100000, 1000000, 10000000
+};
+
+static volatile uint8_t  armed;
+static volatile uint8_t  fired;
+static volatile uint8_t  stale;         // a capture from before arming
+static volatile uint8_t  unsent;        // the edge has a word to send
+static volatile uint32_t edge_at;
+static volatile uint16_t edges;
+static volatile uint16_t latency;
+static volatile uint16_t pulses;
+static volatile uint8_t  pulse_age;     // ticks the pulse has been seen
+
+static volatile uint32_t sent_at;
+
+static uint8_t  arm_chips;
+static uint8_t  chips;                  // the ones word is for
+static uint8_t  was_sel;                // FREQ register before the edge
+static uint16_t word;                   // control word selecting the run
+static uint8_t  queued;                 // the run is held in ddsq instead
+
+static uint32_t spacing;                // Hz between markers, 0 for none
+static uint32_t band_lo;                // markers either side of the
+static uint32_t band_hi;                // last frequency
+
+void TRIG_init(void)
+{
+        DDRB &= ~TRIG_IN;
+        PORTB |= TRIG_IN;
+        PORTC &= ~SYNC_OUT;
+        DDRC |= SYNC_OUT;
+        armed = 0;
+        fired = 0;
+        spacing = 0;
+        // Noise canceller: the edge must hold for 4 cycles
+        TCCR1B |= _BV(ICNC1);
+}
+
+static void raise_sync(void)
+{
+        PORTC |= SYNC_OUT;
+        pulse_age = 0;
+        pulses++;
+}
+
+// Waits for the chosen edge of a capture not yet taken
+static void arm(uint8_t edge)
+{
+        if (edge == TRIG_FALLING)
+        {
+                TCCR1B &= ~_BV(ICES1);
+        }
+        else
+        {
+                TCCR1B |= _BV(ICES1);
+        }
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+        {
+                fired = 0;
+                // ICF1 only clears when the interrupt is taken, so an edge
+                // from before now is let through once and dropped
+                stale = (TIFR & _BV(ICF1)) != 0;
+                armed = 1;
+                TIMSK |= _BV(TICIE1);
+        }
+}
+
+void TRIG_arm(uint8_t ch, uint8_t edge, uint32_t w)
+{
+        uint8_t to = ch;
+        TRIG_disarm();
+        was_sel = (uint8_t)AD9833_get_selected_freq((uint8_t)__builtin_ctz(ch));
+        uint8_t idle = !was_sel;
+        AD9833_set_frequency(ch, idle, w);
+        AD9833_update(ch);
+        AD9833_select_freq(ch, idle);
+        // If the chips needed different words they have gone out already
+        // and the edge only starts the run
+        uint8_t n = AD9833_take(ch, &word, 1, &to);
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+        {
+                arm_chips = ch;
+                chips = to;
+                unsent = n;
+                queued = 0;
+        }
+        arm(edge);
+}
+
+void TRIG_arm_queue(uint8_t edge)
+{
+        TRIG_disarm();
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+        {
+                unsent = 0;
+                queued = 1;
+        }
+        arm(edge);
+}
+
+void TRIG_disarm(void)
+{
+        if (!armed && !fired)
+        {
+                return;
+        }
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+        {
+                TIMSK &= ~_BV(TICIE1);
+                armed = 0;
+                fired = 0;
+                unsent = 0;
+        }
+        if (queued)
+        {
+                // Nothing was taken from the driver; the run was held
+                DDSQ_flush();
+                return;
+        }
+        // Back to the register from before; the shadows think the switch
+        // went out, so the next update sends the control word again
+        AD9833_select_freq(arm_chips, was_sel);
+}
+
+uint32_t TRIG_sent(void)
+{
+        uint32_t at;
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+        {
+                at = sent_at;
+        }
+        return at;
+}
+
+uint8_t TRIG_armed(void)
+{
+        // The interrupt sets fired before it clears armed
+        return armed || fired;
+}
+
+uint8_t TRIG_fired(uint32_t* at)
+{
+        if (!fired)
+        {
+                return 0;
+        }
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+        {
+                unsent = 0;
+                fired = 0;
+                *at = edge_at;
+        }
+        return 1;
+}
+
+void TRIG_pulse(void)
+{
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+        {
+                raise_sync();
+        }
+}
+
+void TRIG_service(void)
+{
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+        {
+                if ((PORTC & SYNC_OUT) && ++pulse_age >= PULSE_TICKS)
+                {
+                        PORTC &= ~SYNC_OUT;
+                }
+        }
+}
+
+// Markers either side of hz
+static void band(uint32_t hz)
+{
+        band_lo = hz - hz % spacing;
+        band_hi = band_lo + spacing;
+}
+
+void TRIG_markers(uint8_t decade, uint32_t hz)
+{
+        spacing = decade <= TRIG_MARKER_MAX
+                ? pgm_read_dword(&decades[decade]) : 0;
+        if (spacing)
+        {
+                band(hz);
+        }
+}
+
+uint8_t TRIG_marker(uint32_t hz)
+{
+        // Still between the same two markers: no division
+        if (!spacing || (hz >= band_lo && hz < band_hi))
+        {
+                return 0;
+        }
+        band(hz);
+        TRIG_pulse();
+        return 1;
+}
+
+uint16_t TRIG_edges(void)
+{
+        uint16_t n;
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+        {
+                n = edges;
+        }
+        return n;
+}
+
+uint16_t TRIG_latency(void)
+{
+        uint16_t n;
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+        {
+                n = latency;
+        }
+        return n;
+}
+
+uint16_t TRIG_pulses(void)
+{
+        uint16_t n;
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+        {
+                n = pulses;
+        }
+        return n;
+}
+
+ISR(TIMER1_CAPT_vect)
+{
+        uint16_t icr = ICR1;
+        if (stale)
+        {
+                stale = 0;
+                return;
+        }
+        // The capture is under 4 ms old, so its upper half is now's
+        uint32_t now = TIMER1_now();
+        uint32_t at = now - (uint16_t)((uint16_t)now - icr);
+        TIMSK &= ~_BV(TICIE1);
+        if (queued)
+        {
+                // The held run counts from now, so its first operation
+                // goes out at once and the rest keep their spacing
+                sent_at = TIMER1_now();
+                DDSQ_release(sent_at);
+        }
+        else
+        {
+                if (unsent)
+                {
+                        DDSBUS_write(chips, &word, 1);
+                        unsent = 0;
+                }
+                sent_at = TIMER1_now();
+        }
+        uint32_t took = sent_at - at;
+        if (took > latency)
+        {
+                latency = took > 0xffff ? 0xffff : (uint16_t)took;
+        }
+        raise_sync();
+        edge_at = at;
+        edges++;
+        fired = 1;
+        armed = 0;
+}
@@ -0,0 +1,169 @@
+//////////////////////////////////////////////////////////////////////////////
+///
+///  \file trig.h
+///
+///  \copy copyright (c) 2023 William R Cooke
+///
+///  @brief Sweep sync output and external trigger input.
+///
+///  The trigger input is ICP1 (PB0), the Timer1 input capture pin: INT0
+///  and INT1 belong to the knob, which needs both phases, and there is
+///  no other free input.  PB0 was the LCD's E line, which has moved to
+///  PB2 (lcd.h).  Capture latches the edge's Timer1 count
+///  in hardware, so the edge time is exact to the cycle however late the
+///  interrupt runs.  TRIG_arm() loads the first frequency into the idle
+///  FREQ register beforehand and keeps the one control word that selects
+///  it, so all the capture interrupt does is hand that word to ddsbus.
+///  From edge to the word starting out on SPI is the interrupt latency
+///  plus about 100 cycles: the longest stretch with interrupts off, or
+///  the longest lower-numbered interrupt, whichever is worse.  Capture
+///  is vector 5, ahead of every other Timer1 interrupt, the SPI and the
+///  USART.  TRIG_latency() reports the worst seen.
+///
+///  The sync output is PC4, raised by TRIG_pulse() for a sweep start or
+///  a marker and lowered by TRIG_service() one to two ms later.  Markers
+///  fall on multiples of a power of ten Hz; TRIG_marker() pulses each
+///  time the frequency it is given moves past one.  Builds with more
+///  than one chip use PC4 for chip 1's FSYNC and have no sync output;
+///  the pulses are still counted.
+///
+///  While armed the driver's shadows assume the word has been sent, so
+///  run() must not write the DDS until TRIG_fired() or TRIG_disarm().
+///  A run is a single sweep, pass through the hop list or set of bursts;
+///  the caller arms again when it ends.
+///
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef TRIG_H
+#define TRIG_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+
+// Configuration byte: edge in the low bits, marker spacing above
+        typedef enum TRIG_EDGE
+        {
+                TRIG_FREE      = 0,     // run continuously, no trigger
+                TRIG_RISING    = 1,     // one run per rising edge
+                TRIG_FALLING   = 2      // one run per falling edge
+        } TrigEdge_t;
+
+#define TRIG_EDGE_MASK     0x03
+#define TRIG_MARKER_SHIFT  4            // markers every 10^n Hz, 0 for none
+#define TRIG_MARKER_MAX    7
+#define TRIG_EDGE(cfg)     ((cfg) & TRIG_EDGE_MASK)
+#define TRIG_MARKER(cfg)   ((cfg) >> TRIG_MARKER_SHIFT)
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn TRIG_init
+/// @brief PB0 as an input with pull-up, PC4 as the sync output, low.
+///        TIMER1_init() must have been called.
+//////////////////////////////////////////////////////////////////////////////
+        void TRIG_init(void);
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn TRIG_arm
+/// @brief Puts word in the chips' idle FREQ register now and waits for an
+///        edge to switch to it.  The output stays as it is until then.
+/// @param[in] chips  AD9833_CH() mask.
+/// @param[in] edge   TRIG_RISING or TRIG_FALLING.
+/// @param[in] word   28 bit tuning word to switch to.
+//////////////////////////////////////////////////////////////////////////////
+        void TRIG_arm(uint8_t chips, uint8_t edge, uint32_t word);
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn TRIG_arm_queue
+/// @brief Waits for an edge to release ddsq, which the caller has held
+///        with DDSQ_hold() and queued a run into, times counted from
+///        the release.  The first operation is due at 0 and goes out in
+///        the capture interrupt.
+/// @param[in] edge   TRIG_RISING or TRIG_FALLING.
+//////////////////////////////////////////////////////////////////////////////
+        void TRIG_arm_queue(uint8_t edge);
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn TRIG_disarm
+/// @brief Stops waiting, drops an edge TRIG_fired() has not reported and
+///        puts FSEL back in the driver as it was before TRIG_arm(), to go
+///        out with the next update, or after TRIG_arm_queue(), flushes
+///        ddsq.  Nothing if neither armed nor fired.
+//////////////////////////////////////////////////////////////////////////////
+        void TRIG_disarm(void);
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn TRIG_armed
+/// @return 1 from TRIG_arm() until TRIG_fired() reports the edge.
+//////////////////////////////////////////////////////////////////////////////
+        uint8_t TRIG_armed(void);
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn TRIG_fired
+/// @brief Once per edge, after the interrupt switched the output.
+/// @param[out] at  TIMER1_now() cycle of the edge.
+/// @return 1 if an edge came since the last call, and the trigger is no
+///         longer armed; else 0.
+//////////////////////////////////////////////////////////////////////////////
+        uint8_t TRIG_fired(uint32_t* at);
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn TRIG_sent
+/// @return TIMER1_now() cycle the last edge's word was handed to ddsbus,
+///         or ddsq released, once TRIG_fired() has reported it.
+//////////////////////////////////////////////////////////////////////////////
+        uint32_t TRIG_sent(void);
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn TRIG_pulse
+/// @brief Raises the sync output.
+//////////////////////////////////////////////////////////////////////////////
+        void TRIG_pulse(void);
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn TRIG_service
+/// @brief Ends a pulse once a whole tick has passed.  Call every tick,
+///        before anything that may pulse.
+//////////////////////////////////////////////////////////////////////////////
+        void TRIG_service(void);
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn TRIG_markers
+/// @brief Sets the marker spacing and where the frequency starts from.
+/// @param[in] decade  Markers every 10^decade Hz, 0 for none.
+/// @param[in] hz      Frequency now, which does not count as a crossing.
+//////////////////////////////////////////////////////////////////////////////
+        void TRIG_markers(uint8_t decade, uint32_t hz);
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn TRIG_marker
+/// @brief Pulses if hz is past a marker since the last call, upward on
+///        reaching it, downward on going below it.
+/// @return 1 if it pulsed.
+//////////////////////////////////////////////////////////////////////////////
+        uint8_t TRIG_marker(uint32_t hz);
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn TRIG_edges
+/// @return Edges taken since TRIG_init(), modulo 2^16.
+//////////////////////////////////////////////////////////////////////////////
+        uint16_t TRIG_edges(void);
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn TRIG_latency
+/// @return Most cycles from an edge to its word being handed to ddsbus.
+//////////////////////////////////////////////////////////////////////////////
+        uint16_t TRIG_latency(void);
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn TRIG_pulses
+/// @return Sync pulses since TRIG_init(), modulo 2^16.
+//////////////////////////////////////////////////////////////////////////////
+        uint16_t TRIG_pulses(void);
+
+#ifdef __cplusplus
+}
+#endif  // __cplusplus
+#endif  // #ifndef TRIG_H
@@ -0,0 +1,152 @@
+//////////////////////////////////////////////////////////////////////////////
+///
+///  \file tuning.c
+///
+///  \copy copyright (c) 2023 William R Cooke
+///
+///  @brief Division-free Hz to AD9833 tuning word conversion.
+///
+//////////////////////////////////////////////////////////////////////////////
+
+#include <stdint.h>
+#include <avr/eeprom.h>
+#include "eewrite.h"
+#include "tuning.h"
+
+// word = floor(hz * K / 2^56) with K = ceil(2^(28+56) / mclk).  K is a
+// little too big, by less than 1, so the product overshoots the exact
+// hz * 2^28 / mclk by less than hz / 2^56.  For any hz below 2^31 that is
+// under 1 / mclk, the smallest distance from a non-integer quotient to
+// the next integer, so the floor is exact.
+#define RECIP_SHIFT     56
+
+// The same for mHz: word = floor(f * M / 2^69), M = ceil(2^(28+69) /
+// (1000 * mclk)).  f is below 2^34 and 1000 * mclk below 2^35, so the
+// overshoot, under f / 2^69, is again under 1 / (1000 * mclk).  M fits
+// 64 bits while 1000 * mclk is at least 2^33.
+#define MRECIP_SHIFT    69
+
+static uint32_t nominal;
+static uint32_t mclk;
+static int16_t  ppm;
+static uint32_t recip_hi;         // K >> 32
+static uint32_t recip_lo;         // K & 0xffffffff
+static uint32_t mrecip_hi;        // M >> 32
+static uint32_t mrecip_lo;        // M & 0xffffffff
+
+// Last TUNING_freq_to_word() in and out; 0 Hz is word 0 to start with
+static freq_t   last_freq;
+static uint32_t last_word;
+
+// Calibration and its complement; an erased EEPROM fails the check.
+static int16_t saved_ppm[2] EEMEM;
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn reciprocal
+/// @return ceil(2^(28 + shift) / d) by shift and subtract, so the 64-bit
+///         library divide is never pulled in.
+//////////////////////////////////////////////////////////////////////////////
+static uint64_t reciprocal(uint64_t d, uint8_t shift)
+{
+        uint64_t rem = 0;
+        uint64_t q = 0;
+        for (int8_t bit = 28 + shift; bit >= 0; bit--)
+        {
+                rem = (rem << 1) | (bit == 28 + shift);
+                q <<= 1;
+                if (rem >= d)
+                {
+                        rem -= d;
+                        q |= 1;
+                }
+        }
+        if (rem)
+        {
+                q++;
+        }
+        return q;
+}
+
+static void build_reciprocal(void)
+{
+        uint64_t q = reciprocal(mclk, RECIP_SHIFT);
+        recip_hi = (uint32_t)(q >> 32);
+        recip_lo = (uint32_t)q;
+        q = reciprocal((uint64_t)mclk * FREQ_MHZ_PER_HZ, MRECIP_SHIFT);
+        mrecip_hi = (uint32_t)(q >> 32);
+        mrecip_lo = (uint32_t)q;
+        last_freq = 0;
+        last_word = 0;
+}
+
+void TUNING_set_ppm(int16_t p)
+{
+        ppm = p;
+        // nominal / 1000000 is exact for the 25 MHz part
+        mclk = nominal + (int32_t)(nominal / 1000000L) * p;
+        build_reciprocal();
+}
+
+void TUNING_init(uint32_t nominal_hz)
+{
+        int16_t cal[2];
+        nominal = nominal_hz;
+        eeprom_read_block(cal, saved_ppm, sizeof(cal));
+        TUNING_set_ppm((cal[0] ^ cal[1]) == -1 ? cal[0] : 0);
+}
+
+int16_t TUNING_get_ppm(void)
+{
+        return ppm;
+}
+
+uint8_t TUNING_save_ppm(int16_t p)
+{
+        int16_t cal[2] = { p, (int16_t)~p };
+        TUNING_set_ppm(p);
+        return EEWRITE_queue(saved_ppm, cal, sizeof(cal));
+}
+
+uint32_t TUNING_get_clock(void)
+{
+        return mclk;
+}
+
+uint32_t TUNING_hz_to_word(uint32_t hz)
+{
+        uint64_t lo = (uint64_t)hz * recip_lo;
+        uint64_t hi = (uint64_t)hz * recip_hi + (lo >> 32);
+        return (uint32_t)(hi >> (RECIP_SHIFT - 32)) & 0x0fffffffUL;
+}
+
+uint32_t TUNING_word_to_hz(uint32_t n)
+{
+        // Rounded, so a word from TUNING_hz_to_word(), which is at most
+        // one LSB (0.09 Hz) low, reads back as the Hz it came from
+        return (uint32_t)(((uint64_t)n * mclk + (1UL << 27)) >> 28);
+}
+
+uint32_t TUNING_freq_to_word(freq_t f)
+{
+        if (f == last_freq)
+        {
+                return last_word;
+        }
+        // f * M in 32 bit pieces; f's top word is only 2 bits
+        uint32_t f_lo = (uint32_t)f;
+        uint32_t f_hi = (uint32_t)(f >> 32);
+        uint64_t lo = (uint64_t)f_lo * mrecip_lo;
+        uint64_t mid = (uint64_t)f_lo * mrecip_hi + (lo >> 32);
+        uint64_t mid2 = (uint64_t)f_hi * mrecip_lo + (uint32_t)mid;
+        uint64_t hi = (uint64_t)f_hi * mrecip_hi + (mid >> 32)
+                + (mid2 >> 32);
+        last_freq = f;
+        last_word = (uint32_t)(hi >> (MRECIP_SHIFT - 64)) & 0x0fffffffUL;
+        return last_word;
+}
+
+freq_t TUNING_word_to_freq(uint32_t n)
+{
+        // Rounded, like TUNING_word_to_hz()
+        return ((uint64_t)n * mclk * FREQ_MHZ_PER_HZ + (1UL << 27)) >> 28;
+}
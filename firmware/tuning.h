@@ -0,0 +1,94 @@
+//////////////////////////////////////////////////////////////////////////////
+///
+///  \file tuning.h
+///
+///  \copy copyright (c) 2023 William R Cooke
+///
+///  @brief Division-free Hz to AD9833 tuning word conversion.
+///
+///  The word is floor(hz * 2^28 / mclk), exactly as docs/calc.c computes
+///  it, but done as a multiply by a precomputed reciprocal of the master
+///  clock.  The reciprocal is rebuilt only when the ppm calibration of the
+///  master clock changes.
+///
+///  A freq_t goes the same way through a second reciprocal, of 1000 times
+///  the master clock, wide enough for millihertz up to FREQ_LIMIT.
+///
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef TUNING_H
+#define TUNING_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include "freq.h"
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn TUNING_init
+/// @brief Loads the clock calibration from EEPROM and builds the reciprocal.
+/// @param[in] nominal_hz  Nominal master clock, e.g. 25000000.
+//////////////////////////////////////////////////////////////////////////////
+        void TUNING_init(uint32_t nominal_hz);
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn TUNING_set_ppm
+/// @brief Applies a master clock correction without storing it.
+/// @param[in] ppm  Clock error in parts per million, positive if fast.
+//////////////////////////////////////////////////////////////////////////////
+        void TUNING_set_ppm(int16_t ppm);
+
+        int16_t TUNING_get_ppm(void);
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn TUNING_save_ppm
+/// @brief Applies a master clock correction and queues it for EEPROM.
+/// @param[in] ppm  Clock error in parts per million, positive if fast.
+/// @return 1 if queued, 0 if the EEPROM write queue is full.
+//////////////////////////////////////////////////////////////////////////////
+        uint8_t TUNING_save_ppm(int16_t ppm);
+
+        uint32_t TUNING_get_clock(void);
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn TUNING_hz_to_word
+/// @brief Converts a frequency to a tuning word, rounding down.
+/// @param[in] hz  Frequency in Hz, below 2^31.
+/// @return 28 bit tuning word (wraps above the master clock).
+//////////////////////////////////////////////////////////////////////////////
+        uint32_t TUNING_hz_to_word(uint32_t hz);
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn TUNING_word_to_hz
+/// @brief Converts a tuning word back to the nearest whole Hz.
+/// @param[in] n  28 bit tuning word.
+/// @return Frequency in Hz.
+//////////////////////////////////////////////////////////////////////////////
+        uint32_t TUNING_word_to_hz(uint32_t n);
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn TUNING_freq_to_word
+/// @brief Converts a frequency to a tuning word, rounding down.  The last
+///        conversion is kept, so calling it every tick with the same
+///        frequency costs a compare.  Needs a master clock of 8.6 MHz or
+///        more, so the reciprocal fits 64 bits.
+/// @param[in] f  Frequency in mHz, below FREQ_LIMIT.
+/// @return 28 bit tuning word (wraps above the master clock).
+//////////////////////////////////////////////////////////////////////////////
+        uint32_t TUNING_freq_to_word(freq_t f);
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn TUNING_word_to_freq
+/// @brief Converts a tuning word back to the nearest mHz.
+/// @param[in] n  28 bit tuning word.
+/// @return Frequency in mHz.
+//////////////////////////////////////////////////////////////////////////////
+        freq_t TUNING_word_to_freq(uint32_t n);
+
+#ifdef __cplusplus
+}
+#endif  // __cplusplus
+#endif  // #ifndef TUNING_H
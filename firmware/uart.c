@@ -0,0 +1,139 @@
+//////////////////////////////////////////////////////////////////////////////
+///
+///  \file uart.c
+///
+///  \copy copyright (c) 2023 William R Cooke
+///
+///  @brief Interrupt driven USART with receive and transmit rings.
+///
+//////////////////////////////////////////////////////////////////////////////
+
+#include <stdint.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/pgmspace.h>
+#include <util/atomic.h>
+#include "uart.h"
+#include "ring.h"
+
+#ifndef F_CPU
+#define F_CPU 16000000UL
+#endif
+
+RING_CHECK(UART_RX_SIZE);
+RING_CHECK(UART_TX_SIZE);
+
+// Double speed: F_CPU / (8 * baud) - 1, rounded
+#define UBRR_VALUE      ((F_CPU + 4UL * UART_BAUD) / (8UL * UART_BAUD) - 1)
+
+static volatile uint8_t rx_ring[UART_RX_SIZE];
+static volatile uint8_t rx_head;          // written by the ISR
+static volatile uint8_t rx_tail;
+static volatile uint8_t tx_ring[UART_TX_SIZE];
+static volatile uint8_t tx_head;
+static volatile uint8_t tx_tail;          // moved by the ISR
+static volatile uint16_t overruns;
+
+void UART_init(void)
+{
+        rx_head = rx_tail = 0;
+        tx_head = tx_tail = 0;
+        overruns = 0;
+        UBRRH = (uint8_t)(UBRR_VALUE >> 8);
+        UBRRL = (uint8_t)UBRR_VALUE;
+        UCSRA = _BV(U2X);
+        UCSRC = _BV(URSEL) | _BV(UCSZ1) | _BV(UCSZ0);
+        UCSRB = _BV(RXCIE) | _BV(RXEN) | _BV(TXEN);
+}
+
+uint8_t UART_read(uint8_t* ch)
+{
+        uint8_t t = rx_tail;
+        if (t == rx_head)
+        {
+                return 0;
+        }
+        *ch = rx_ring[t];
+        rx_tail = RING_NEXT(t, UART_RX_SIZE);
+        return 1;
+}
+
+uint8_t UART_write(uint8_t ch)
+{
+        uint8_t h = tx_head;
+        uint8_t next = RING_NEXT(h, UART_TX_SIZE);
+        if (next == tx_tail)
+        {
+                return 0;
+        }
+        tx_ring[h] = ch;
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+        {
+                tx_head = next;
+                UCSRB |= _BV(UDRIE);
+        }
+        return 1;
+}
+
+void UART_write_string(const uint8_t* str)
+{
+        while (*str)
+        {
+                UART_write(*str++);
+        }
+}
+
+void UART_write_string_P(const char* str)
+{
+        uint8_t ch;
+        while ((ch = pgm_read_byte(str++)) != '\0')
+        {
+                UART_write(ch);
+        }
+}
+
+uint8_t UART_tx_room(void)
+{
+        // tx_tail only moves toward tx_head, so a stale read under-counts
+        return RING_ROOM(tx_head, tx_tail, UART_TX_SIZE);
+}
+
+uint16_t UART_overruns(void)
+{
+        uint16_t n;
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+        {
+                n = overruns;
+        }
+        return n;
+}
+
+ISR(USART_RXC_vect)
+{
+        uint8_t status = UCSRA;
+        uint8_t ch = UDR;
+        uint8_t next = RING_NEXT(rx_head, UART_RX_SIZE);
+        if (status & _BV(DOR))
+        {
+                overruns++;
+        }
+        if (next == rx_tail)
+        {
+                overruns++;
+                return;
+        }
+        rx_ring[rx_head] = ch;
+        rx_head = next;
+}
+
+ISR(USART_UDRE_vect)
+{
+        uint8_t t = tx_tail;
+        if (t == tx_head)
+        {
+                UCSRB &= ~_BV(UDRIE);
+                return;
+        }
+        UDR = tx_ring[t];
+        tx_tail = RING_NEXT(t, UART_TX_SIZE);
+}
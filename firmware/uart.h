@@ -0,0 +1,74 @@
+//////////////////////////////////////////////////////////////////////////////
+///
+///  \file uart.h
+///
+///  \copy copyright (c) 2023 William R Cooke
+///
+///  @brief Interrupt driven USART with receive and transmit rings.
+///
+///  The receive interrupt only stores the byte; the transmit interrupt
+///  only feeds the data register from the ring.  Neither side ever waits
+///  for the line, so run() is never held up by the serial port.
+///
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef UART_H
+#define UART_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+
+#define UART_BAUD          115200UL
+
+// Ring sizes in bytes, powers of 2
+#define UART_RX_SIZE       64
+#define UART_TX_SIZE       64
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn UART_init
+/// @brief 8N1 at UART_BAUD (double speed mode), receive interrupt on.
+//////////////////////////////////////////////////////////////////////////////
+        void UART_init(void);
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn UART_read
+/// @param[out] ch  Next received byte.
+/// @return 1 if a byte was read, 0 if none is waiting.
+//////////////////////////////////////////////////////////////////////////////
+        uint8_t UART_read(uint8_t* ch);
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn UART_write
+/// @param[in] ch  Byte to send.
+/// @return 1 if queued, 0 if the transmit ring is full (byte dropped).
+//////////////////////////////////////////////////////////////////////////////
+        uint8_t UART_write(uint8_t ch);
+
+        void UART_write_string(const uint8_t* str);
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn UART_write_string_P
+/// @brief UART_write_string() for a string in flash, such as PSTR().
+//////////////////////////////////////////////////////////////////////////////
+        void UART_write_string_P(const char* str);
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn UART_tx_room
+/// @return Bytes that can be written now without any being dropped.
+//////////////////////////////////////////////////////////////////////////////
+        uint8_t UART_tx_room(void);
+
+//////////////////////////////////////////////////////////////////////////////
+/// @fn UART_overruns
+/// @return Bytes lost because the receive ring or the USART overflowed.
+//////////////////////////////////////////////////////////////////////////////
+        uint16_t UART_overruns(void);
+
+#ifdef __cplusplus
+}
+#endif  // __cplusplus
+#endif  // #ifndef UART_H